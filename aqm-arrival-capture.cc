@@ -0,0 +1,168 @@
+#include "aqm-arrival-capture.h"
+
+#include "queue-disc.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmArrivalCapture");
+
+NS_OBJECT_ENSURE_REGISTERED(AqmArrivalCapture);
+
+TypeId
+AqmArrivalCapture::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AqmArrivalCapture")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<AqmArrivalCapture>()
+            .AddAttribute("FileName",
+                          "Name of the binary trace file",
+                          StringValue("aqm-arrivals.bin"),
+                          MakeStringAccessor(&AqmArrivalCapture::m_fileName),
+                          MakeStringChecker())
+            .AddAttribute("BufferSize",
+                          "Number of records buffered between two writes",
+                          UintegerValue(1 << 16),
+                          MakeUintegerAccessor(&AqmArrivalCapture::m_bufferSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("LinkRate",
+                          "Rate of the link fed by the captured queue disc, stored for the replay",
+                          DataRateValue(DataRate("0bps")),
+                          MakeDataRateAccessor(&AqmArrivalCapture::m_linkRate),
+                          MakeDataRateChecker());
+    return tid;
+}
+
+AqmArrivalCapture::AqmArrivalCapture()
+    : m_file(nullptr),
+      m_header(),
+      m_used(0),
+      m_nRecords(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AqmArrivalCapture::~AqmArrivalCapture()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+}
+
+void
+AqmArrivalCapture::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    Object::DoDispose();
+}
+
+void
+AqmArrivalCapture::Start(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    NS_ABORT_MSG_IF(m_file, "AqmArrivalCapture already started");
+
+    m_file = std::fopen(m_fileName.c_str(), "wb");
+    NS_ABORT_MSG_IF(!m_file, "Cannot create arrival trace " << m_fileName);
+    m_buffer.resize(m_bufferSize);
+    m_used = 0;
+    m_nRecords = 0;
+
+    std::memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = AQM_ARRIVAL_TRACE_MAGIC;
+    m_header.recordSize = sizeof(AqmArrivalRecord);
+    QueueSize maxSize = queueDisc->GetMaxSize();
+    m_header.maxSizeBytes = maxSize.GetUnit() == QueueSizeUnit::BYTES ? 1 : 0;
+    m_header.maxSize = maxSize.GetValue();
+    m_header.linkRate = m_linkRate.GetBitRate();
+    std::strncpy(m_header.queueDiscType,
+                 queueDisc->GetInstanceTypeId().GetName().c_str(),
+                 sizeof(m_header.queueDiscType) - 1);
+    WriteHeader();
+
+    queueDisc->TraceConnectWithoutContext("Enqueue",
+                                          MakeCallback(&AqmArrivalCapture::Arrival, this));
+    queueDisc->TraceConnectWithoutContext("DropBeforeEnqueue",
+                                          MakeCallback(&AqmArrivalCapture::DroppedArrival, this));
+    Simulator::ScheduleDestroy(&AqmArrivalCapture::Stop, Ptr<AqmArrivalCapture>(this));
+}
+
+void
+AqmArrivalCapture::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_file)
+    {
+        return;
+    }
+    Flush();
+    m_header.nRecords = m_nRecords;
+    WriteHeader();
+    std::fclose(m_file);
+    m_file = nullptr;
+    NS_LOG_INFO("Captured " << m_nRecords << " arrivals to " << m_fileName);
+}
+
+void
+AqmArrivalCapture::Arrival(Ptr<const QueueDiscItem> item)
+{
+    if (!m_file)
+    {
+        return;
+    }
+    if (m_used == m_buffer.size())
+    {
+        Flush();
+    }
+    uint8_t tos = 0;
+    item->GetUint8Value(QueueItem::IP_DSFIELD, tos);
+    AqmArrivalRecord& r = m_buffer[m_used++];
+    r.time = Simulator::Now().GetNanoSeconds();
+    r.flowHash = item->Hash();
+    r.size = static_cast<uint16_t>(std::min<uint32_t>(item->GetSize(), UINT16_MAX));
+    r.ecn = tos & 0x3;
+    r.reserved = 0;
+}
+
+void
+AqmArrivalCapture::DroppedArrival(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    Arrival(item);
+}
+
+void
+AqmArrivalCapture::Flush()
+{
+    NS_LOG_FUNCTION(this << m_used);
+    std::size_t written = std::fwrite(m_buffer.data(), sizeof(AqmArrivalRecord), m_used, m_file);
+    NS_ABORT_MSG_IF(written != m_used, "Cannot write arrival trace " << m_fileName);
+    m_nRecords += m_used;
+    m_used = 0;
+}
+
+void
+AqmArrivalCapture::WriteHeader()
+{
+    NS_LOG_FUNCTION(this);
+    long end = std::ftell(m_file);
+    std::fseek(m_file, 0, SEEK_SET);
+    NS_ABORT_MSG_IF(std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1,
+                    "Cannot write arrival trace " << m_fileName);
+    if (end > 0)
+    {
+        std::fseek(m_file, end, SEEK_SET);
+    }
+}
+
+} // namespace ns3
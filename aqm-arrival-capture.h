@@ -0,0 +1,99 @@
+#ifndef AQM_ARRIVAL_CAPTURE_H
+#define AQM_ARRIVAL_CAPTURE_H
+
+#include "aqm-arrival-trace-format.h"
+
+#include "ns3/data-rate.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class QueueDisc;
+class QueueDiscItem;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Binary trace of the packets arriving at a queue disc, for offline
+ * replay
+ *
+ * Start connects to the Enqueue and DropBeforeEnqueue trace sources of a
+ * queue disc, which between them fire once for every arrival, and records
+ * the arrival time, size, flow hash and ECN codepoint of each packet in a
+ * 16-byte record. Records are buffered and written BufferSize at a time.
+ * The header also holds the queue disc limit and LinkRate, so that
+ * AqmReplay can run RED, DSRED and BLUE over the same arrivals without the
+ * simulation (see aqm_replay). The ECN codepoint is read after the queue
+ * disc has seen the packet, so a marked packet shows CE; it still tells
+ * whether the packet is ECN-capable.
+ */
+class AqmArrivalCapture : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AqmArrivalCapture();
+    ~AqmArrivalCapture() override;
+
+    /**
+     * @brief Create the file and start recording the arrivals of a queue disc
+     * @param queueDisc the captured queue disc
+     */
+    void Start(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Write the buffered records, complete the header and close the file
+     */
+    void Stop();
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief Record an arrival
+     * @param item the arriving packet
+     */
+    void Arrival(Ptr<const QueueDiscItem> item);
+
+    /**
+     * @brief Record an arrival dropped before being enqueued
+     * @param item the arriving packet
+     * @param reason the drop reason
+     */
+    void DroppedArrival(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief Write the buffered records to the file
+     */
+    void Flush();
+
+    /**
+     * @brief Write the header at the start of the file
+     */
+    void WriteHeader();
+
+    std::string m_fileName; //!< Output file
+    uint32_t m_bufferSize;  //!< Records buffered between two writes
+    DataRate m_linkRate;    //!< Rate of the link fed by the queue disc
+
+    std::FILE* m_file;                      //!< Output file, while capturing
+    AqmArrivalTraceHeader m_header;         //!< File header
+    std::vector<AqmArrivalRecord> m_buffer; //!< Buffered records
+    std::size_t m_used;                     //!< Records used in m_buffer
+    uint64_t m_nRecords;                    //!< Records written to the file
+};
+
+} // namespace ns3
+
+#endif // AQM_ARRIVAL_CAPTURE_H
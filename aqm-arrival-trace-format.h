@@ -0,0 +1,57 @@
+#ifndef AQM_ARRIVAL_TRACE_FORMAT_H
+#define AQM_ARRIVAL_TRACE_FORMAT_H
+
+#include <cstdint>
+
+/**
+ * @file
+ * @ingroup traffic-control
+ * Layout of the binary arrival trace written by AqmArrivalCapture and
+ * replayed by AqmReplay.
+ *
+ * This header does not depend on ns-3. The file is an
+ * AqmArrivalTraceHeader followed by one AqmArrivalRecord per packet that
+ * reached the captured queue disc, accepted or not, in arrival order and
+ * in the byte order of the simulation host. The header is written again
+ * when the capture is closed; a trace whose nRecords is zero was not
+ * closed, and its records run up to the end of the file.
+ */
+
+namespace ns3
+{
+
+/// Magic number at the start of the file ("AQMARRV1")
+constexpr uint64_t AQM_ARRIVAL_TRACE_MAGIC = 0x31565252414d5141ULL;
+
+/**
+ * @brief One arrival
+ */
+struct AqmArrivalRecord
+{
+    int64_t time;      //!< Arrival time (ns)
+    uint32_t flowHash; //!< Hash of the packet 5-tuple
+    uint16_t size;     //!< Packet size (bytes)
+    uint8_t ecn;       //!< ECN codepoint as seen by the queue disc (0 if not ECN-capable)
+    uint8_t reserved;  //!< Zero
+};
+
+static_assert(sizeof(AqmArrivalRecord) == 16, "AqmArrivalRecord must be packed in 16 bytes");
+
+/**
+ * @brief Header of the arrival trace
+ */
+struct AqmArrivalTraceHeader
+{
+    uint64_t magic;         //!< AQM_ARRIVAL_TRACE_MAGIC
+    uint32_t recordSize;    //!< sizeof (AqmArrivalRecord)
+    uint32_t maxSizeBytes;  //!< 1 if maxSize is in bytes, 0 if in packets
+    uint32_t maxSize;       //!< MaxSize of the captured queue disc
+    uint32_t reserved;      //!< Zero
+    uint64_t linkRate;      //!< Rate of the link the queue disc feeds (bit/s), 0 if unknown
+    char queueDiscType[64]; //!< TypeId name of the captured queue disc
+    uint64_t nRecords;      //!< Number of records, 0 until the capture is closed
+};
+
+} // namespace ns3
+
+#endif // AQM_ARRIVAL_TRACE_FORMAT_H
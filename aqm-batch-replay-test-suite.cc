@@ -0,0 +1,203 @@
+#include "ns3/aqm-batch-replay.h"
+#include "ns3/aqm-replay.h"
+#include "ns3/test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief Check that AqmBatchReplay gives the results of AqmReplay
+ *
+ * A synthetic trace of bursts, heavier than the link during a burst and
+ * separated by idle periods, is fed in the same blocks to AqmReplay with
+ * common random numbers and to AqmBatchReplay, with the same seed. The
+ * packets have one size and a transmission time of a whole number of
+ * nanoseconds, so the work-based queue of AqmBatchReplay is exact. The
+ * trace ends with an arrival after the queues have drained, so that the
+ * time-averaged queue of AqmReplay and the one AqmBatchReplay derives from
+ * Little's law cover the same packets. The counters must then be equal and
+ * the averages equal up to rounding.
+ */
+class AqmBatchReplayTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param name the name of the test case
+     * @param configs the configurations, all with the same algorithm
+     */
+    AqmBatchReplayTestCase(std::string name, std::vector<AqmReplay::Config> configs);
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Build the arrival trace
+     * @return the arrivals, in time order
+     */
+    static std::vector<AqmArrivalRecord> MakeTrace();
+
+    std::vector<AqmReplay::Config> m_configs; //!< Configurations
+};
+
+AqmBatchReplayTestCase::AqmBatchReplayTestCase(std::string name,
+                                               std::vector<AqmReplay::Config> configs)
+    : TestCase(name),
+      m_configs(configs)
+{
+}
+
+std::vector<AqmArrivalRecord>
+AqmBatchReplayTestCase::MakeTrace()
+{
+    // 500-byte packets take 4 us on the 1 Gbit/s link of DoRun; with the
+    // times in whole microseconds, transmissions often end right at an
+    // arrival
+    std::mt19937_64 rng(7);
+    std::exponential_distribution<double> gap(1.0 / 3);      // 4/3 of the link rate
+    std::exponential_distribution<double> pause(1.0 / 2e3);  // 2 ms between bursts
+    std::uniform_int_distribution<uint32_t> burst(10, 3000); // arrivals per burst
+    std::bernoulli_distribution ecnCapable(0.5);
+
+    std::vector<AqmArrivalRecord> trace;
+    int64_t t = 1000;
+    while (trace.size() < 60000)
+    {
+        for (uint32_t n = burst(rng); n > 0; --n)
+        {
+            t += std::llround(gap(rng));
+            AqmArrivalRecord r{};
+            r.time = t * 1000;
+            r.size = 500;
+            r.ecn = ecnCapable(rng) ? 2 : 0;
+            trace.push_back(r);
+        }
+        t += std::llround(pause(rng));
+    }
+    // A last arrival once every queue has drained
+    AqmArrivalRecord r{};
+    r.time = (t + 1000000) * 1000;
+    r.size = 500;
+    trace.push_back(r);
+    return trace;
+}
+
+void
+AqmBatchReplayTestCase::DoRun()
+{
+    const uint64_t linkRate = 1000000000;
+    const uint64_t seed = 3;
+    std::vector<AqmArrivalRecord> trace = MakeTrace();
+
+    AqmReplay replay(linkRate, m_configs, seed, true);
+    AqmBatchReplay batch(linkRate, m_configs, seed);
+    const std::size_t blockSize = 4096;
+    for (std::size_t i = 0; i < trace.size(); i += blockSize)
+    {
+        std::size_t n = std::min(blockSize, trace.size() - i);
+        replay.Feed(trace.data() + i, n);
+        batch.Feed(trace.data() + i, n);
+    }
+
+    std::vector<AqmReplay::Result> expected = replay.GetResults();
+    std::vector<AqmReplay::Result> results = batch.GetResults();
+    NS_TEST_ASSERT_MSG_EQ(results.size(), expected.size(), "One result per configuration");
+    uint64_t drops = 0;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const AqmReplay::Result& e = expected[i];
+        const AqmReplay::Result& r = results[i];
+        NS_TEST_EXPECT_MSG_EQ(r.arrivals, e.arrivals, "Arrivals of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ(r.drops, e.drops, "Drops of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ(r.marks, e.marks, "Marks of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ(r.maxQueue, e.maxQueue, "Longest queue of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ_TOL(r.meanQueue,
+                                  e.meanQueue,
+                                  1e-9 * e.meanQueue,
+                                  "Mean queue of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ_TOL(r.meanDelay,
+                                  e.meanDelay,
+                                  1e-9 * e.meanDelay,
+                                  "Mean delay of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ_TOL(r.utilisation,
+                                  e.utilisation,
+                                  1e-9,
+                                  "Utilisation of configuration " << i);
+        NS_TEST_EXPECT_MSG_EQ_TOL(r.meanDropProb,
+                                  e.meanDropProb,
+                                  1e-9,
+                                  "Mean drop probability of configuration " << i);
+        drops += r.drops;
+    }
+    // The trace must exercise the algorithm, not only the idle link
+    NS_TEST_EXPECT_MSG_GT(drops, 0, "No drop in any configuration");
+}
+
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief AqmBatchReplay test suite
+ */
+static class AqmBatchReplayTestSuite : public TestSuite
+{
+  public:
+    AqmBatchReplayTestSuite()
+        : TestSuite("aqm-batch-replay", Type::UNIT)
+    {
+        // More RED configurations than the lanes of a block, so that a
+        // block is padded
+        std::vector<AqmReplay::Config> red;
+        std::vector<AqmReplay::Config> dsred;
+        for (double minTh : {5, 20, 40})
+        {
+            for (double maxTh : {60, 90, 120})
+            {
+                for (int variant = 0; variant < 4; ++variant)
+                {
+                    AqmReplay::Config c;
+                    c.limit = 100;
+                    c.minTh = minTh;
+                    c.maxTh = maxTh;
+                    c.midTh = (minTh + maxTh) / 2;
+                    c.qW = variant % 2 ? 0.02 : 0.002;
+                    c.isGentle = variant < 2;
+                    c.isWait = variant != 1;
+                    c.useEcn = variant == 3;
+                    red.push_back(c);
+                    c.algorithm = AqmReplay::DSRED;
+                    dsred.push_back(c);
+                }
+            }
+        }
+        std::vector<AqmReplay::Config> blue;
+        for (double increment : {0.0025, 0.02})
+        {
+            for (double decrement : {0.00025, 0.002})
+            {
+                for (double freezeTime : {0.001, 0.01, 0.1})
+                {
+                    AqmReplay::Config c;
+                    c.algorithm = AqmReplay::BLUE;
+                    c.limit = 100;
+                    c.increment = increment;
+                    c.decrement = decrement;
+                    c.freezeTime = freezeTime;
+                    blue.push_back(c);
+                }
+            }
+        }
+        AddTestCase(new AqmBatchReplayTestCase("Batch replay of RED", red),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new AqmBatchReplayTestCase("Batch replay of DSRED", dsred),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new AqmBatchReplayTestCase("Batch replay of BLUE", blue),
+                    TestCase::Duration::QUICK);
+    }
+} g_aqmBatchReplayTestSuite; ///< the test suite
@@ -0,0 +1,333 @@
+#include "aqm-batch-replay.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmBatchReplay");
+
+AqmBatchReplay::AqmBatchReplay(uint64_t linkRate,
+                               const std::vector<AqmReplay::Config>& configs,
+                               uint64_t seed)
+    : m_algorithm(configs.empty() ? AqmReplay::RED : configs[0].algorithm),
+      m_n(configs.size()),
+      m_blocks((configs.size() + LANES - 1) / LANES),
+      m_nsPerByte(8e9 / linkRate),
+      m_rng(seed),
+      m_first(0),
+      m_last(0),
+      m_started(false),
+      m_arrivals(0)
+{
+    NS_LOG_FUNCTION(this << linkRate << configs.size() << seed);
+    NS_ASSERT(linkRate > 0);
+
+    for (std::size_t i = 0; i < m_blocks.size() * LANES; ++i)
+    {
+        // The padding lanes repeat the last configuration
+        const AqmReplay::Config& c = configs[std::min(i, m_n - 1)];
+        NS_ABORT_MSG_IF(c.algorithm != m_algorithm,
+                        "The configurations of a batch must use the same algorithm");
+        Block& b = m_blocks[i / LANES];
+        std::size_t j = i % LANES;
+
+        // Same derived constants as RedQueueDisc::InitializeParams
+        double thDiff = c.maxTh - c.minTh;
+        if (thDiff == 0)
+        {
+            thDiff = 1.0;
+        }
+        b.limit[j] = c.limit;
+        b.minTh[j] = c.minTh;
+        b.maxTh[j] = c.maxTh;
+        b.forceTh[j] = c.isGentle ? 2 * c.maxTh : c.maxTh;
+        b.gentle[j] = c.isGentle;
+        b.wait[j] = c.isWait;
+        b.useEcn[j] = c.useEcn;
+        b.qW[j] = c.qW;
+        b.oneMinusQw[j] = 1.0 - c.qW;
+        b.ptc[j] = linkRate / (8.0 * c.meanPktSize);
+        b.curMaxP[j] = 1.0 / c.lInterm;
+        b.vA[j] = 1.0 / thDiff;
+        b.vB[j] = -c.minTh / thDiff;
+        b.vC[j] = (1.0 - b.curMaxP[j]) / c.maxTh;
+        b.vD[j] = 2.0 * b.curMaxP[j] - 1.0;
+
+        // Same slopes as DsRedDropCurve, which DsRedQueueDisc calls with LInterm as pMax
+        b.midTh[j] = c.midTh;
+        b.gamma[j] = c.gamma;
+        b.dsA[j] = (c.lInterm - c.gamma) / (c.midTh - c.minTh);
+        b.dsB[j] = c.gamma / (c.maxTh - c.midTh);
+
+        b.increment[j] = c.increment;
+        b.decrement[j] = c.decrement;
+        b.freeze[j] = std::round(c.freezeTime * 1e9);
+
+        b.work[j] = 0;
+        b.qAvg[j] = 0;
+        b.count[j] = 0;
+        b.old[j] = 0;
+        b.vProb[j] = 0;
+        b.dropProb[j] = 0;
+        // The first overflow may update BLUE at once
+        b.lastUpdate[j] = -std::numeric_limits<double>::infinity();
+        b.drops[j] = 0;
+        b.marks[j] = 0;
+        b.sent[j] = 0;
+        b.delaySum[j] = 0;
+        b.busySum[j] = 0;
+        b.probSum[j] = 0;
+        b.maxQueue[j] = 0;
+    }
+}
+
+uint32_t
+AqmBatchReplay::Serve(Block& b, double dt, double tx)
+{
+    double perTx = 1.0 / tx;
+    uint32_t idle = 0;
+    for (std::size_t j = 0; j < LANES; ++j)
+    {
+        // Lindley recursion; the link went idle if its work ran out by the
+        // arrival, a transmission ending at the arrival time included
+        double w = b.work[j] - dt;
+        bool empty = (b.work[j] > 0) & (w <= 0);
+        b.idleNs[j] = empty ? -w : -1.0;
+        idle += empty;
+        w = w > 0 ? w : 0.0;
+        b.work[j] = w;
+
+        // Packets in the system, less the one being sent
+        double q = w * perTx - 1e-6;
+        auto whole = static_cast<double>(static_cast<int32_t>(q));
+        double inSystem = whole + (q > whole ? 1.0 : 0.0);
+        b.nQueued[j] = inSystem > 1 ? inSystem - 1 : 0.0;
+        b.decay[j] = b.oneMinusQw[j];
+    }
+    return idle;
+}
+
+template <bool dsred>
+void
+AqmBatchReplay::DecideRed(Block& b, double u, double ecn)
+{
+    for (std::size_t j = 0; j < LANES; ++j)
+    {
+        // RedQueueDisc::DoEnqueue, packet mode, as AqmReplay::Arrive without branches
+        double nQ = b.nQueued[j];
+        double q = b.qAvg[j] * b.decay[j] + b.qW[j] * nQ;
+        double c = b.count[j] + 1;
+        bool inRange = (q >= b.minTh[j]) & (nQ > 1);
+        bool forced = inRange & (q >= b.forceTh[j]);
+        bool reset = inRange & !forced & (b.old[j] == 0);
+        bool test = inRange & !forced & (b.old[j] != 0);
+
+        // Drop curve: RedDropCurve or DsRedDropCurve
+        double p;
+        if (dsred)
+        {
+            double lower = b.dsA[j] * (q - b.minTh[j]);
+            double upper = 1.0 - b.gamma[j] + b.dsB[j] * (q - b.midTh[j]);
+            p = q < b.midTh[j] ? lower : (q < b.maxTh[j] ? upper : 1.0);
+            p = q < b.minTh[j] ? 0.0 : p;
+        }
+        else
+        {
+            double linear = (b.vA[j] * q + b.vB[j]) * b.curMaxP[j];
+            double above = b.gentle[j] != 0 ? b.vC[j] * q + b.vD[j] : 1.0;
+            p = q >= b.maxTh[j] ? above : linear;
+        }
+
+        // RedSpacedProbability with a single division; the lanes whose
+        // quotient is not used may divide by zero harmlessly
+        double cp = c * p;
+        double quotient = p / (1.0 + b.wait[j] - cp);
+        double waited = cp < 1.0 ? 0.0 : (cp < 2.0 ? quotient : 1.0);
+        double unwaited = cp < 1.0 ? quotient : 1.0;
+        double spaced = b.wait[j] != 0 ? waited : unwaited;
+        spaced = spaced < 1.0 ? spaced : 1.0;
+
+        bool hit = test & (u <= spaced);
+        bool marked = hit & (b.useEcn[j] * ecn != 0);
+        bool overflow = nQ >= b.limit[j];
+        double v = test ? spaced : (inRange ? b.vProb[j] : 0.0);
+
+        b.vProb[j] = v;
+        b.probSum[j] += v;
+        b.qAvg[j] = q;
+        b.count[j] = reset ? 1.0 : (hit ? 0.0 : c);
+        b.old[j] = inRange ? (forced ? b.old[j] : 1.0) : 0.0;
+        // The internal queue of RedQueueDisc holds at most limit packets
+        b.drop[j] = (forced | (hit & !marked) | overflow) ? 1.0 : 0.0;
+        b.mark[j] = (marked & !overflow) ? 1.0 : 0.0;
+    }
+}
+
+void
+AqmBatchReplay::DecideBlue(Block& b, double now)
+{
+    for (std::size_t j = 0; j < LANES; ++j)
+    {
+        // BlueQueueDisc::UpdateDropProb when the link found the queue empty...
+        double p = b.dropProb[j];
+        double last = b.lastUpdate[j];
+        double emptied = now - b.idleNs[j];
+        bool decrease = (b.idleNs[j] >= 0) & (emptied - last >= b.freeze[j]);
+        double lower = p - b.decrement[j];
+        p = decrease ? (lower > 0.0 ? lower : 0.0) : p;
+        last = decrease ? emptied : last;
+
+        // ... and on overflow
+        bool overflow = b.nQueued[j] >= b.limit[j];
+        bool increase = overflow & (now - last >= b.freeze[j]);
+        double higher = p + b.increment[j];
+        p = increase ? (higher < 1.0 ? higher : 1.0) : p;
+        last = increase ? now : last;
+
+        b.dropProb[j] = p;
+        b.lastUpdate[j] = last;
+        b.probSum[j] += p;
+        b.drop[j] = overflow ? 1.0 : 0.0;
+        b.mark[j] = 0.0;
+    }
+}
+
+void
+AqmBatchReplay::Accept(Block& b, double tx)
+{
+    for (std::size_t j = 0; j < LANES; ++j)
+    {
+        double accepted = 1.0 - b.drop[j];
+        double w = b.work[j];
+        // A packet waits for the work ahead of it, and only if the link is busy
+        double queued = b.nQueued[j] + (w > 0 ? accepted : 0.0);
+
+        b.drops[j] += b.drop[j];
+        b.marks[j] += b.mark[j];
+        b.sent[j] += accepted;
+        b.delaySum[j] += accepted * w;
+        b.busySum[j] += accepted * tx;
+        b.work[j] = w + accepted * tx;
+        b.maxQueue[j] = queued > b.maxQueue[j] ? queued : b.maxQueue[j];
+    }
+}
+
+void
+AqmBatchReplay::Feed(const AqmArrivalRecord* records, std::size_t n)
+{
+    NS_LOG_FUNCTION(this << n);
+    if (n == 0)
+    {
+        return;
+    }
+    if (!m_started)
+    {
+        m_started = true;
+        m_first = records[0].time;
+        m_last = m_first;
+    }
+
+    // The same random numbers for every lane
+    m_uniform.resize(n);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        m_uniform[k] = (m_rng() >> 11) * 0x1.0p-53;
+    }
+
+    // One block at a time over the arrivals, keeping its lanes in cache
+    for (Block& b : m_blocks)
+    {
+        int64_t last = m_last;
+        for (std::size_t k = 0; k < n; ++k)
+        {
+            const AqmArrivalRecord& r = records[k];
+            double tx = r.size * m_nsPerByte;
+            uint32_t idle = Serve(b, static_cast<double>(r.time - last), tx);
+            last = r.time;
+
+            if (m_algorithm == AqmReplay::BLUE)
+            {
+                DecideBlue(b, static_cast<double>(r.time));
+            }
+            else
+            {
+                // The idle-time compensation of the EWMA needs pow, left to
+                // the few lanes that found their link idle
+                for (std::size_t j = 0; idle > 0 && j < LANES; ++j)
+                {
+                    if (b.idleNs[j] >= 0)
+                    {
+                        auto m = static_cast<uint32_t>(b.ptc[j] * b.idleNs[j] * 1e-9);
+                        b.decay[j] = m == 0 ? b.oneMinusQw[j] : std::pow(b.oneMinusQw[j], m + 1);
+                        idle--;
+                    }
+                }
+                double ecn = r.ecn != 0 ? 1.0 : 0.0;
+                if (m_algorithm == AqmReplay::DSRED)
+                {
+                    DecideRed<true>(b, m_uniform[k], ecn);
+                }
+                else
+                {
+                    DecideRed<false>(b, m_uniform[k], ecn);
+                }
+            }
+            Accept(b, tx);
+        }
+    }
+    m_last = records[n - 1].time;
+    m_arrivals += n;
+}
+
+std::vector<AqmReplay::Result>
+AqmBatchReplay::GetResults() const
+{
+    std::vector<AqmReplay::Result> results;
+    auto duration = static_cast<double>(m_last - m_first);
+    for (std::size_t i = 0; i < m_n; ++i)
+    {
+        const Block& b = m_blocks[i / LANES];
+        std::size_t j = i % LANES;
+        AqmReplay::Result r;
+        r.arrivals = m_arrivals;
+        r.drops = static_cast<uint64_t>(b.drops[j]);
+        r.marks = static_cast<uint64_t>(b.marks[j]);
+        r.maxQueue = static_cast<uint32_t>(b.maxQueue[j]);
+        // Little's law over the sent packets
+        r.meanQueue = duration > 0 ? b.delaySum[j] / duration : 0;
+        r.utilisation = duration > 0 ? (b.busySum[j] - b.work[j]) / duration : 0;
+        r.meanDelay = b.sent[j] > 0 ? b.delaySum[j] / b.sent[j] * 1e-9 : 0;
+        r.meanDropProb = m_arrivals > 0 ? b.probSum[j] / m_arrivals : 0;
+        results.push_back(r);
+    }
+    return results;
+}
+
+std::vector<AqmReplay::Result>
+AqmBatchReplay::Run(const std::string& fileName,
+                    AqmArrivalTraceHeader& header,
+                    uint64_t& linkRate,
+                    const std::vector<AqmReplay::Config>& configs,
+                    uint64_t seed)
+{
+    NS_LOG_FUNCTION(fileName << linkRate << configs.size() << seed);
+
+    std::FILE* file = AqmReplay::OpenTrace(fileName, header, linkRate);
+    AqmBatchReplay replay(linkRate, configs, seed);
+    std::vector<AqmArrivalRecord> block(1 << 16);
+    std::size_t got;
+    while ((got = std::fread(block.data(), sizeof(AqmArrivalRecord), block.size(), file)) > 0)
+    {
+        replay.Feed(block.data(), got);
+    }
+    std::fclose(file);
+    return replay.GetResults();
+}
+
+} // namespace ns3
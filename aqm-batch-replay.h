@@ -0,0 +1,190 @@
+#ifndef AQM_BATCH_REPLAY_H
+#define AQM_BATCH_REPLAY_H
+
+#include "aqm-arrival-trace-format.h"
+#include "aqm-replay.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Replay of an arrival trace through many RED, DSRED or BLUE
+ * configurations in lockstep
+ *
+ * The batch counterpart of AqmReplay for large parameter studies. The
+ * state and parameters of the configurations (average queue, count,
+ * max_p, BLUE probability, thresholds, ...) are kept as a structure of
+ * arrays, one lane per configuration, cut into cache-line aligned blocks
+ * of LANES lanes. Every arrival updates all the lanes with branch-free
+ * loops (service, EWMA, drop curve, count spacing, random comparison) over
+ * the fixed-width arrays of a block, which the compiler turns into SIMD
+ * code without alias checks; the blocks are replayed one after the other
+ * over each fed chunk of arrivals, like the configurations of AqmReplay.
+ * The vectors are as wide as the target allows, so configure with
+ * NS3_NATIVE_OPTIMIZATIONS for AVX. All the configurations must use the
+ * same algorithm.
+ *
+ * To make the lanes independent of per-packet bookkeeping, a queue is kept
+ * as its unfinished work (the FIFO Lindley recursion), which is exact for
+ * the queueing delays, the link utilisation and, by Little's law, the mean
+ * queue; its length in packets is that work over the transmission time of
+ * the arriving packet, exact when the packets have the same size, as the
+ * data packets of final_testing_script do. The random comparison
+ * of an arrival uses the same uniform number in every lane (common random
+ * numbers), so differences between configurations are not blurred by
+ * independent draws. Otherwise the decisions are those of AqmReplay: with
+ * packets of one size and AqmReplay using common random numbers from the
+ * same seed, the results are the same, which the aqm-batch-replay test
+ * suite checks.
+ */
+class AqmBatchReplay
+{
+  public:
+    /**
+     * @param linkRate rate of the link draining the queues (bit/s)
+     * @param configs the configurations to replay, all with the same algorithm
+     * @param seed seed of the random numbers shared by the configurations
+     */
+    AqmBatchReplay(uint64_t linkRate, const std::vector<AqmReplay::Config>& configs, uint64_t seed);
+
+    /**
+     * @brief Feed a block of consecutive arrivals to all the configurations
+     * @param records the arrivals, in time order
+     * @param n the number of arrivals
+     */
+    void Feed(const AqmArrivalRecord* records, std::size_t n);
+
+    /**
+     * @brief Get the results, with the averages taken from the first to the
+     * last arrival fed
+     * @return one result per configuration, in the order of the configurations
+     */
+    std::vector<AqmReplay::Result> GetResults() const;
+
+    /**
+     * @brief Replay a trace file
+     * @param fileName the trace written by AqmArrivalCapture
+     * @param header set to the trace header
+     * @param[in,out] linkRate rate of the link (bit/s); 0 to take that of the trace
+     * @param configs the configurations to replay
+     * @param seed seed of the random numbers
+     * @return one result per configuration
+     */
+    static std::vector<AqmReplay::Result> Run(const std::string& fileName,
+                                              AqmArrivalTraceHeader& header,
+                                              uint64_t& linkRate,
+                                              const std::vector<AqmReplay::Config>& configs,
+                                              uint64_t seed);
+
+  private:
+    /// Lanes of a block, four cache lines of doubles per field
+    static constexpr std::size_t LANES = 32;
+
+    /**
+     * @brief Parameters, state and statistics of LANES configurations
+     */
+    struct alignas(64) Block
+    {
+        // Parameters
+        double limit[LANES];      //!< Queue disc limit (packets)
+        double minTh[LANES];      //!< Minimum threshold
+        double maxTh[LANES];      //!< Maximum threshold
+        double forceTh[LANES];    //!< Average above which drops are forced
+        double gentle[LANES];     //!< 1 for gentle RED
+        double wait[LANES];       //!< 1 to wait between drops
+        double useEcn[LANES];     //!< 1 to mark ECN-capable packets
+        double qW[LANES];         //!< EWMA queue weight
+        double oneMinusQw[LANES]; //!< 1 - qW
+        double ptc[LANES];        //!< Mean-sized packets sent per second
+        double vA[LANES];         //!< RED curve slope
+        double vB[LANES];         //!< RED curve intercept
+        double vC[LANES];         //!< Gentle RED slope
+        double vD[LANES];         //!< Gentle RED intercept
+        double curMaxP[LANES];    //!< max_p
+        double midTh[LANES];      //!< DSRED middle threshold
+        double gamma[LANES];      //!< DSRED gamma
+        double dsA[LANES];        //!< DSRED lower slope
+        double dsB[LANES];        //!< DSRED upper slope
+        double increment[LANES];  //!< BLUE increment
+        double decrement[LANES];  //!< BLUE decrement
+        double freeze[LANES];     //!< BLUE freeze time (ns)
+        // State
+        double work[LANES];       //!< Unfinished work, the packet being sent included (ns)
+        double qAvg[LANES];       //!< RED average queue length
+        double count[LANES];      //!< RED arrivals since the last early drop
+        double old[LANES];        //!< 1 once the RED average crossed minTh
+        double vProb[LANES];      //!< RED spaced drop probability
+        double dropProb[LANES];   //!< BLUE drop probability
+        double lastUpdate[LANES]; //!< Last BLUE update (ns)
+        // Values of the current arrival
+        double nQueued[LANES];    //!< Waiting packets seen by the arrival
+        double idleNs[LANES];     //!< Time the link has been idle (ns), negative if busy
+        double decay[LANES];      //!< EWMA decay, (1 - qW)^(m + 1)
+        double drop[LANES];       //!< 1 if the arrival is dropped
+        double mark[LANES];       //!< 1 if the arrival is marked
+        // Statistics
+        double drops[LANES];      //!< Packets dropped
+        double marks[LANES];      //!< Packets marked
+        double sent[LANES];       //!< Packets accepted
+        double delaySum[LANES];   //!< Queueing delays of the accepted packets (ns)
+        double busySum[LANES];    //!< Transmission time of the accepted packets (ns)
+        double probSum[LANES];    //!< Sum of the probabilities at the arrivals
+        double maxQueue[LANES];   //!< Longest queue (packets)
+    };
+
+    /**
+     * @brief Drain the queues of a block up to an arrival
+     * @param b the block
+     * @param dt time since the previous arrival (ns)
+     * @param tx the transmission time of the arriving packet (ns)
+     * @return the number of lanes whose link went idle
+     */
+    static uint32_t Serve(Block& b, double dt, double tx);
+
+    /**
+     * @brief Take the RED or DSRED decisions of a block on an arrival
+     * @tparam dsred true for the DsRedQueueDisc curve
+     * @param b the block
+     * @param u the uniform random number of the arrival
+     * @param ecn 1 if the packet is ECN-capable, 0 otherwise
+     */
+    template <bool dsred>
+    static void DecideRed(Block& b, double u, double ecn);
+
+    /**
+     * @brief Take the BLUE decisions of a block on an arrival
+     * @param b the block
+     * @param now the arrival time (ns)
+     */
+    static void DecideBlue(Block& b, double now);
+
+    /**
+     * @brief Queue the accepted arrivals of a block
+     * @param b the block
+     * @param tx the transmission time of the packet (ns)
+     */
+    static void Accept(Block& b, double tx);
+
+    AqmReplay::Algorithm m_algorithm; //!< Algorithm of all the lanes
+    std::size_t m_n;                  //!< Number of configurations
+    std::vector<Block> m_blocks;      //!< Lanes, the last block padded
+    double m_nsPerByte;               //!< Transmission time of a byte (ns)
+    std::mt19937_64 m_rng;            //!< Common random numbers
+    std::vector<double> m_uniform;    //!< Random numbers of the arrivals being fed
+    int64_t m_first;                  //!< Time of the first arrival fed (ns)
+    int64_t m_last;                   //!< Time of the last arrival fed (ns)
+    bool m_started;                   //!< True once an arrival has been fed
+    uint64_t m_arrivals;              //!< Arrivals fed
+};
+
+} // namespace ns3
+
+#endif // AQM_BATCH_REPLAY_H
@@ -0,0 +1,101 @@
+#ifndef AQM_COUNTERS_H
+#define AQM_COUNTERS_H
+
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @file
+ * @ingroup traffic-control
+ *
+ * Hot-path counters of RED, DSRED and BLUE, for finding out which branches
+ * of the algorithms a scenario exercises.
+ *
+ * The counters are only incremented if the module is built with
+ * NS3_AQM_COUNTERS defined (the NS3_AQM_COUNTERS CMake option); otherwise
+ * AQM_COUNT expands to nothing and the counters stay at zero. The counter
+ * blocks are members of the queue discs either way, so code built with and
+ * without the option can be linked together, and the enabled flag of a
+ * block tells whether it is being counted.
+ */
+
+#ifdef NS3_AQM_COUNTERS
+/// Increment a hot-path counter
+#define AQM_COUNT(counter) (++(counter))
+#else
+/// Increment a hot-path counter (disabled)
+#define AQM_COUNT(counter)
+#endif
+
+namespace ns3
+{
+
+/**
+ * @brief Hot-path counters of RedQueueDisc and DsRedQueueDisc
+ */
+struct RedHotPathCounters
+{
+    bool enabled = false;         //!< True if the queue disc was built with NS3_AQM_COUNTERS
+    uint64_t estimatorFast = 0;   //!< Average updates with m = 1 (no idle period)
+    uint64_t estimatorPow = 0;    //!< Average updates after an idle period, using std::pow
+    uint64_t oldResets = 0;       //!< Arrivals that found m_old == 0 above MinTh
+    uint64_t aredUpdates = 0;     //!< Calls of the ARED max_p update
+    uint64_t fengUpdates = 0;     //!< Calls of Feng's adaptive max_p update
+    uint64_t rngComparisons = 0;  //!< u <= p comparisons of an early drop
+    uint64_t rngHits = 0;         //!< Comparisons that dropped or marked
+    uint64_t dsredLowerSlope = 0; //!< DSRED probabilities below the mid threshold
+    uint64_t dsredUpperSlope = 0; //!< DSRED probabilities above the mid threshold
+};
+
+/**
+ * @brief Hot-path counters of BlueQueueDisc
+ */
+struct BlueHotPathCounters
+{
+    bool enabled = false;          //!< True if the queue disc was built with NS3_AQM_COUNTERS
+    uint64_t freezeRejections = 0; //!< Probability updates refused by the freeze time
+    uint64_t increments = 0;       //!< Probability increments on overflow
+    uint64_t decrements = 0;       //!< Probability decrements on an empty queue
+    uint64_t rngComparisons = 0;   //!< u <= p comparisons
+    uint64_t rngHits = 0;          //!< Comparisons that dropped
+};
+
+/**
+ * @brief Print RED hot-path counters
+ * @param os output stream
+ * @param c the counters
+ * @return the output stream
+ */
+inline std::ostream&
+operator<<(std::ostream& os, const RedHotPathCounters& c)
+{
+    os << "Hot path: " << c.estimatorFast << " fast and " << c.estimatorPow
+       << " std::pow estimator updates, " << c.oldResets << " m_old resets, " << c.aredUpdates
+       << " ARED and " << c.fengUpdates << " Feng max_p updates, " << c.rngComparisons
+       << " u <= p comparisons (" << c.rngHits << " hits)";
+    if (c.dsredLowerSlope + c.dsredUpperSlope > 0)
+    {
+        os << ", DSRED " << c.dsredLowerSlope << " lower and " << c.dsredUpperSlope
+           << " upper slope probabilities";
+    }
+    return os;
+}
+
+/**
+ * @brief Print BLUE hot-path counters
+ * @param os output stream
+ * @param c the counters
+ * @return the output stream
+ */
+inline std::ostream&
+operator<<(std::ostream& os, const BlueHotPathCounters& c)
+{
+    os << "Hot path: " << c.freezeRejections << " updates refused by the freeze time, "
+       << c.increments << " increments, " << c.decrements << " decrements, "
+       << c.rngComparisons << " u <= p comparisons (" << c.rngHits << " hits)";
+    return os;
+}
+
+} // namespace ns3
+
+#endif // AQM_COUNTERS_H
@@ -0,0 +1,185 @@
+#ifndef AQM_DROP_CURVES_H
+#define AQM_DROP_CURVES_H
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * Drop probability functions shared by the AQM queue discs and by the
+ * models that reason about them outside of the packet-level simulation
+ * (e.g. AqmFluidModel). Keeping a single copy guarantees that a parameter
+ * point screened offline is judged by exactly the curve the queue disc uses.
+ */
+
+/**
+ * @brief RED drop curve, as evaluated by RedQueueDisc::CalculatePNew
+ * @param qAvg average queue length
+ * @param vA 1.0 / (maxTh - minTh)
+ * @param vB -minTh / (maxTh - minTh)
+ * @param vC (1.0 - curMaxP) / maxTh, used in gentle mode
+ * @param vD 2.0 * curMaxP - 1.0, used in gentle mode
+ * @param maxTh maximum threshold
+ * @param curMaxP current max_p
+ * @param isGentle true for gentle RED
+ * @param isNonlinear true for Nonlinear RED
+ * @return the drop probability before "count" spacing
+ */
+inline double
+RedDropCurve(double qAvg,
+             double vA,
+             double vB,
+             double vC,
+             double vD,
+             double maxTh,
+             double curMaxP,
+             bool isGentle,
+             bool isNonlinear)
+{
+    double p;
+
+    if (isGentle && qAvg >= maxTh)
+    {
+        // p ranges from curMaxP to 1 as the average queue
+        // size ranges from maxTh to twice maxTh
+        p = vC * qAvg + vD;
+    }
+    else if (!isGentle && qAvg >= maxTh)
+    {
+        p = 1.0;
+    }
+    else
+    {
+        // p ranges from 0 to curMaxP as the average queue size ranges from
+        // minTh to maxTh
+        p = vA * qAvg + vB;
+
+        if (isNonlinear)
+        {
+            p *= p * 1.5;
+        }
+
+        p *= curMaxP;
+    }
+
+    if (p > 1.0)
+    {
+        p = 1.0;
+    }
+
+    return p;
+}
+
+/**
+ * @brief Spread RED drops uniformly over the packets since the last drop,
+ *        as done by RedQueueDisc::ModifyP
+ * @param p probability returned by the drop curve
+ * @param count number of packets (or mean-sized packets) since the last drop
+ * @param isWait true to wait between dropped packets
+ * @return the per-packet drop probability
+ */
+inline double
+RedSpacedProbability(double p, double count, bool isWait)
+{
+    if (isWait)
+    {
+        if (count * p < 1.0)
+        {
+            return 0.0;
+        }
+        if (count * p < 2.0)
+        {
+            return p / (2.0 - count * p);
+        }
+        return 1.0;
+    }
+
+    if (count * p < 1.0)
+    {
+        return p / (1.0 - count * p);
+    }
+    return 1.0;
+}
+
+/**
+ * @brief Long-run drop rate produced by RedSpacedProbability
+ *
+ * Without waiting the gap between drops is uniform in [1, 1/p], with
+ * waiting it is uniform in [1/p, 2/p]; the rate is the inverse of the
+ * mean gap. Used where packets are not modelled individually.
+ *
+ * @param p probability returned by the drop curve
+ * @param isWait true to wait between dropped packets
+ * @return the fraction of arrivals dropped or marked
+ */
+inline double
+RedEffectiveDropRate(double p, bool isWait)
+{
+    if (p <= 0.0)
+    {
+        return 0.0;
+    }
+    double rate = isWait ? p / 1.5 : 2.0 * p / (1.0 + p);
+    return rate > 1.0 ? 1.0 : rate;
+}
+
+/**
+ * @brief Double-slope RED drop curve, as evaluated by DsRedQueueDisc::CalculatePNew
+ * @param qAvg average queue length
+ * @param minTh minimum threshold
+ * @param midTh middle threshold
+ * @param maxTh maximum threshold
+ * @param pMax slope parameter of the first segment
+ * @param gamma scaling factor of the second segment
+ * @return the drop probability before "count" spacing
+ */
+inline double
+DsRedDropCurve(double qAvg, double minTh, double midTh, double maxTh, double pMax, double gamma)
+{
+    if (qAvg < minTh)
+    {
+        return 0.0;
+    }
+    if (qAvg < midTh)
+    {
+        double alpha = (pMax - gamma) / (midTh - minTh);
+        return alpha * (qAvg - minTh);
+    }
+    if (qAvg < maxTh)
+    {
+        double beta = gamma / (maxTh - midTh);
+        return 1 - gamma + beta * (qAvg - midTh);
+    }
+    return 1.0;
+}
+
+/**
+ * @brief BLUE reaction to a queue overflow, as in BlueQueueDisc::UpdateDropProb
+ * @param p current drop probability
+ * @param increment the BLUE increment d1
+ * @return the new drop probability
+ */
+inline double
+BlueIncrease(double p, double increment)
+{
+    p += increment;
+    return p > 1.0 ? 1.0 : p;
+}
+
+/**
+ * @brief BLUE reaction to an empty queue, as in BlueQueueDisc::UpdateDropProb
+ * @param p current drop probability
+ * @param decrement the BLUE decrement d2
+ * @return the new drop probability
+ */
+inline double
+BlueDecrease(double p, double decrement)
+{
+    p -= decrement;
+    return p < 0.0 ? 0.0 : p;
+}
+
+} // namespace ns3
+
+#endif // AQM_DROP_CURVES_H
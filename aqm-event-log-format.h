@@ -0,0 +1,75 @@
+#ifndef AQM_EVENT_LOG_FORMAT_H
+#define AQM_EVENT_LOG_FORMAT_H
+
+#include <cstdint>
+
+/**
+ * @file
+ * @ingroup traffic-control
+ * Layout of the binary event log written by AqmEventLog.
+ *
+ * This header does not depend on ns-3, so that decoders can be built
+ * without it. The file is an AqmEventLogHeader followed by fixed-size
+ * AqmEventRecord entries, in the byte order of the simulation host. The
+ * header, with the reason names known so far, is written when the log is
+ * opened and again, with closed set and the reasons registered since, when
+ * it is closed. The records of a log that was not closed run up to the end
+ * of the file.
+ */
+
+namespace ns3
+{
+
+/// Magic number at the start of the file ("AQMEVLG2")
+constexpr uint64_t AQM_EVENT_LOG_MAGIC = 0x32474c56454d5141ULL;
+/// Maximum number of reason names stored in the header
+constexpr uint32_t AQM_EVENT_LOG_MAX_REASONS = 32;
+/// Maximum length of a reason name, including the terminating null
+constexpr uint32_t AQM_EVENT_LOG_REASON_LEN = 32;
+/// Reason of the records that are not drops or marks
+constexpr uint16_t AQM_EVENT_NO_REASON = 0xffff;
+
+/**
+ * @brief Kind of event
+ */
+enum AqmEventType : uint8_t
+{
+    AQM_EVENT_DROP = 0,       //!< Packet dropped by the AQM
+    AQM_EVENT_MARK = 1,       //!< Packet marked by the AQM
+    AQM_EVENT_PROBABILITY = 2 //!< Drop probability or max_p updated
+};
+
+/**
+ * @brief One event
+ */
+struct AqmEventRecord
+{
+    int64_t time;         //!< Simulation time (ns)
+    uint32_t flowHash;    //!< Hash of the packet 5-tuple, 0 for probability updates
+    uint32_t queueLength; //!< Queue length, in the unit of the queue disc MaxSize
+    float probability;    //!< Drop probability when the event happened
+    uint16_t reason;      //!< Index in the header reasons, or AQM_EVENT_NO_REASON
+    uint8_t type;         //!< AqmEventType
+    uint8_t reserved;     //!< Zero
+};
+
+static_assert(sizeof(AqmEventRecord) == 24, "AqmEventRecord must be packed in 24 bytes");
+
+/**
+ * @brief Header of the event log
+ */
+struct AqmEventLogHeader
+{
+    uint64_t magic;         //!< AQM_EVENT_LOG_MAGIC
+    uint32_t recordSize;    //!< sizeof (AqmEventRecord)
+    uint32_t nReasons;      //!< Number of valid reason names
+    char queueDiscType[64]; //!< TypeId name of the logged queue disc
+    char reasons[AQM_EVENT_LOG_MAX_REASONS][AQM_EVENT_LOG_REASON_LEN]; //!< Reason names
+    uint32_t closed;        //!< 1 once the log is closed, 0 before
+    uint32_t reserved;      //!< Zero
+    uint64_t nRecords;      //!< Number of records, valid once the log is closed
+};
+
+} // namespace ns3
+
+#endif // AQM_EVENT_LOG_FORMAT_H
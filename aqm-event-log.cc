@@ -0,0 +1,159 @@
+#include "aqm-event-log.h"
+
+#include "aqm-reasons.h"
+#include "blue-queue-disc.h"
+#include "queue-disc.h"
+#include "red-queue-disc.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <cstring>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmEventLog");
+
+NS_OBJECT_ENSURE_REGISTERED(AqmEventLog);
+
+static_assert(AqmReasons::MAX_REASONS <= AQM_EVENT_LOG_MAX_REASONS,
+              "The event log header must hold every AQM reason");
+
+TypeId
+AqmEventLog::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AqmEventLog")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<AqmEventLog>()
+            .AddAttribute("FileName",
+                          "Name of the binary log file",
+                          StringValue("aqm-events.bin"),
+                          MakeStringAccessor(&AqmEventLog::m_fileName),
+                          MakeStringChecker())
+            .AddAttribute("BufferSize",
+                          "Number of records buffered between two writes",
+                          UintegerValue(1 << 16),
+                          MakeUintegerAccessor(&AqmEventLog::m_bufferSize),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+AqmEventLog::AqmEventLog()
+    : m_file(nullptr),
+      m_header(),
+      m_used(0),
+      m_nRecords(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AqmEventLog::~AqmEventLog()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+}
+
+void
+AqmEventLog::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    Object::DoDispose();
+}
+
+void
+AqmEventLog::Start(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    NS_ABORT_MSG_IF(m_file, "AqmEventLog already started");
+
+    m_file = std::fopen(m_fileName.c_str(), "wb");
+    NS_ABORT_MSG_IF(!m_file, "Cannot create event log " << m_fileName);
+    m_buffer.resize(m_bufferSize);
+    m_used = 0;
+    m_nRecords = 0;
+
+    std::memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = AQM_EVENT_LOG_MAGIC;
+    m_header.recordSize = sizeof(AqmEventRecord);
+    std::strncpy(m_header.queueDiscType,
+                 queueDisc->GetInstanceTypeId().GetName().c_str(),
+                 sizeof(m_header.queueDiscType) - 1);
+    SetReasons();
+    WriteHeader();
+
+    if (Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(queueDisc))
+    {
+        red->SetEventLog(this);
+    }
+    else if (Ptr<BlueQueueDisc> blue = DynamicCast<BlueQueueDisc>(queueDisc))
+    {
+        blue->SetEventLog(this);
+    }
+    else
+    {
+        NS_LOG_WARN(m_header.queueDiscType << " does not report events");
+    }
+    Simulator::ScheduleDestroy(&AqmEventLog::Stop, Ptr<AqmEventLog>(this));
+}
+
+void
+AqmEventLog::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_file)
+    {
+        return;
+    }
+    Flush();
+    // Reasons may have been registered after Start
+    SetReasons();
+    m_header.closed = 1;
+    m_header.nRecords = m_nRecords;
+    WriteHeader();
+    std::fclose(m_file);
+    m_file = nullptr;
+    NS_LOG_INFO("Logged " << m_nRecords << " events to " << m_fileName);
+}
+
+void
+AqmEventLog::Flush()
+{
+    NS_LOG_FUNCTION(this << m_used);
+    NS_ASSERT(m_file);
+    std::size_t written = std::fwrite(m_buffer.data(), sizeof(AqmEventRecord), m_used, m_file);
+    NS_ABORT_MSG_IF(written != m_used, "Cannot write event log " << m_fileName);
+    m_nRecords += m_used;
+    m_used = 0;
+}
+
+void
+AqmEventLog::SetReasons()
+{
+    m_header.nReasons = AqmReasons::GetN();
+    for (uint16_t id = 0; id < m_header.nReasons; ++id)
+    {
+        std::strncpy(m_header.reasons[id], AqmReasons::GetName(id), AQM_EVENT_LOG_REASON_LEN - 1);
+    }
+}
+
+void
+AqmEventLog::WriteHeader()
+{
+    NS_LOG_FUNCTION(this);
+    long end = std::ftell(m_file);
+    std::fseek(m_file, 0, SEEK_SET);
+    NS_ABORT_MSG_IF(std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1,
+                    "Cannot write event log " << m_fileName);
+    if (end > 0)
+    {
+        std::fseek(m_file, end, SEEK_SET);
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,118 @@
+#ifndef AQM_EVENT_LOG_H
+#define AQM_EVENT_LOG_H
+
+#include "aqm-event-log-format.h"
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/simulator.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+class QueueDisc;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Binary log of the drops, marks and probability updates of a queue
+ * disc, for per-packet forensics
+ *
+ * Start attaches the log to a RedQueueDisc (or subclass) or a
+ * BlueQueueDisc, which then report every drop and mark they decide, with
+ * its reason ID (see AqmReasons), the hash of the packet 5-tuple, the
+ * queue length and the drop probability, and every update of the BLUE
+ * probability or of the RED max_p. A record is 24 bytes copied into a
+ * buffer of BufferSize records, written to FileName with one call when
+ * full, so logging millions of drops costs far less than formatting
+ * NS_LOG messages. aqm_event_log_decoder turns the file into text (see
+ * aqm-event-log-format.h for the layout).
+ */
+class AqmEventLog : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AqmEventLog();
+    ~AqmEventLog() override;
+
+    /**
+     * @brief Create the file and start logging the events of a queue disc
+     * @param queueDisc the logged queue disc
+     */
+    void Start(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Write the buffered records, complete the header and close the file
+     */
+    void Stop();
+
+    /**
+     * @brief Append a record, unless the log is not started or stopped
+     * @param type the AqmEventType
+     * @param reason the reason ID, or AQM_EVENT_NO_REASON
+     * @param flowHash the hash of the packet 5-tuple, or 0
+     * @param queueLength the queue length
+     * @param probability the drop probability
+     */
+    void Log(uint8_t type, uint16_t reason, uint32_t flowHash, uint32_t queueLength, double probability)
+    {
+        if (!m_file)
+        {
+            // There is no buffer before Start and no file after Stop
+            return;
+        }
+        if (m_used == m_buffer.size())
+        {
+            Flush();
+        }
+        AqmEventRecord& r = m_buffer[m_used++];
+        r.time = Simulator::Now().GetNanoSeconds();
+        r.flowHash = flowHash;
+        r.queueLength = queueLength;
+        r.probability = static_cast<float>(probability);
+        r.reason = reason;
+        r.type = type;
+        r.reserved = 0;
+    }
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief Write the buffered records to the open file
+     */
+    void Flush();
+
+    /**
+     * @brief Copy the names of the reasons registered so far into the header
+     */
+    void SetReasons();
+
+    /**
+     * @brief Write the header at the start of the file
+     */
+    void WriteHeader();
+
+    std::string m_fileName;  //!< Output file
+    uint32_t m_bufferSize;   //!< Records buffered between two writes
+
+    std::FILE* m_file;                  //!< Output file, while logging
+    AqmEventLogHeader m_header;         //!< File header
+    std::vector<AqmEventRecord> m_buffer; //!< Buffered records
+    std::size_t m_used;                 //!< Records used in m_buffer
+    uint64_t m_nRecords;                //!< Records written to the file
+};
+
+} // namespace ns3
+
+#endif // AQM_EVENT_LOG_H
@@ -0,0 +1,178 @@
+#include "aqm-fluid-model.h"
+
+#include "aqm-drop-curves.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmFluidModel");
+
+AqmFluidModel::Result
+AqmFluidModel::Run(const Config& config)
+{
+    NS_LOG_FUNCTION(config.algorithm << config.nFlows << config.capacity);
+    NS_ASSERT(config.capacity > 0 && config.propDelay > 0);
+    NS_ASSERT(config.duration > config.warmup);
+
+    const double C = config.capacity;
+    const double B = config.bufferSize;
+    const double nActive = config.nFlows * config.activeFraction;
+    const bool isRed = (config.algorithm != BLUE);
+
+    // The EWMA of RED is sampled once per arrival, i.e. roughly C times per
+    // second; its continuous time constant bounds the Euler step
+    const double ewmaRate = -std::log(1.0 - config.qW) * C;
+    double dt = config.timeStep;
+    if (isRed && ewmaRate > 0)
+    {
+        dt = std::min(dt, 0.5 / ewmaRate);
+    }
+
+    // Same derived constants as RedQueueDisc::InitializeParams
+    double thDiff = config.maxTh - config.minTh;
+    if (thDiff == 0)
+    {
+        thDiff = 1.0;
+    }
+    const double curMaxP = 1.0 / config.lInterm;
+    const double vA = 1.0 / thDiff;
+    const double vB = -config.minTh / thDiff;
+    const double vC = (1.0 - curMaxP) / config.maxTh;
+    const double vD = 2.0 * curMaxP - 1.0;
+
+    // History of W p / R, needed one round trip in the past
+    const double maxRtt = config.propDelay + B / C;
+    const auto histLen = static_cast<std::size_t>(std::ceil(maxRtt / dt)) + 2;
+    std::vector<double> history(histLen, 0.0);
+    std::size_t head = 0;
+
+    double w = 1.0;  // per-flow window (packets)
+    double q = 0.0;  // instantaneous queue (packets)
+    double x = 0.0;  // RED average queue (packets)
+    double p = 0.0;  // AQM drop probability
+    double lastBlueUpdate = -std::numeric_limits<double>::infinity();
+
+    double sumTime = 0;
+    double sumQ = 0;
+    double sumQ2 = 0;
+    double sumServed = 0;
+    double sumOffered = 0;
+    double sumLost = 0;
+    double sumP = 0;
+
+    const auto nSteps = static_cast<uint64_t>(config.duration / dt);
+    for (uint64_t step = 0; step < nSteps; ++step)
+    {
+        double t = step * dt;
+        double rtt = config.propDelay + q / C;
+
+        double rate = w / rtt;
+        if (config.flowRateCap > 0 && rate > config.flowRateCap)
+        {
+            // application limited: the window stops growing
+            rate = config.flowRateCap;
+            w = rate * rtt;
+        }
+        double offered = nActive * rate;
+
+        // Early drops. BlueQueueDisc consults its probability only when the
+        // queue is full, so BLUE loses packets through the buffer limit alone
+        double earlyDrop = isRed ? RedEffectiveDropRate(p, config.isWait) : 0.0;
+        double accepted = offered * (1.0 - earlyDrop);
+
+        double qNext = q + (accepted - C) * dt;
+        double overflow = 0;
+        if (qNext > B)
+        {
+            overflow = (qNext - B) / dt;
+            qNext = B;
+        }
+        double served = (q > 0 || accepted > C) ? C : accepted;
+        q = std::max(qNext, 0.0);
+
+        double lost = offered * earlyDrop + overflow;
+        double lossProb = offered > 0 ? lost / offered : 0.0;
+
+        // TCP window dynamics driven by the losses seen one RTT ago
+        auto lag = static_cast<std::size_t>(rtt / dt);
+        double delayed = 0.0;
+        if (step >= lag)
+        {
+            delayed = history[head >= lag ? head - lag : head + histLen - lag];
+        }
+        w += (1.0 / rtt - 0.5 * w * delayed) * dt;
+        w = std::max(w, 1.0);
+        history[head] = w * lossProb / rtt;
+        head = (head + 1 == histLen) ? 0 : head + 1;
+
+        if (isRed)
+        {
+            x += ewmaRate * (q - x) * dt;
+            double prob;
+            if (config.algorithm == DSRED)
+            {
+                prob = DsRedDropCurve(x,
+                                      config.minTh,
+                                      config.midTh,
+                                      config.maxTh,
+                                      config.lInterm,
+                                      config.gamma);
+            }
+            else
+            {
+                prob = RedDropCurve(x, vA, vB, vC, vD, config.maxTh, curMaxP, config.isGentle, false);
+            }
+            // RED only considers early drops while the average is above minTh
+            p = (x >= config.minTh) ? std::min(prob, 1.0) : 0.0;
+        }
+        else if (t - lastBlueUpdate >= config.freezeTime)
+        {
+            if (q >= B)
+            {
+                p = BlueIncrease(p, config.increment);
+                lastBlueUpdate = t;
+            }
+            else if (q <= 0)
+            {
+                p = BlueDecrease(p, config.decrement);
+                lastBlueUpdate = t;
+            }
+        }
+
+        if (t >= config.warmup)
+        {
+            sumTime += dt;
+            sumQ += q * dt;
+            sumQ2 += q * q * dt;
+            sumServed += served * dt;
+            sumOffered += offered * dt;
+            sumLost += lost * dt;
+            sumP += p * dt;
+        }
+    }
+
+    Result result;
+    if (sumTime > 0)
+    {
+        result.meanQueue = sumQ / sumTime;
+        result.queueStdDev =
+            std::sqrt(std::max(sumQ2 / sumTime - result.meanQueue * result.meanQueue, 0.0));
+        result.meanDelay = result.meanQueue / C;
+        result.lossRate = sumOffered > 0 ? sumLost / sumOffered : 0.0;
+        result.utilisation = sumServed / (C * sumTime);
+        result.meanDropProb = sumP / sumTime;
+    }
+
+    NS_LOG_DEBUG("meanQueue " << result.meanQueue << " lossRate " << result.lossRate
+                              << " utilisation " << result.utilisation);
+    return result;
+}
+
+} // namespace ns3
@@ -0,0 +1,94 @@
+#ifndef AQM_FLUID_MODEL_H
+#define AQM_FLUID_MODEL_H
+
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Fluid (ODE) model of N TCP flows sharing an AQM bottleneck
+ *
+ * Integrates the Misra-Gong-Towsley TCP window dynamics
+ *
+ *   dW/dt = 1/R(t) - W(t) W(t-R) / (2 R(t-R)) p(t-R)
+ *   dq/dt = N W(t) / R(t) - C
+ *
+ * with forward Euler, where the drop/mark probability p is produced by the
+ * same curves used by RedQueueDisc, DsRedQueueDisc and BlueQueueDisc (see
+ * aqm-drop-curves.h). One configuration costs a few tens of thousands of
+ * floating point updates, so large parameter grids can be screened before
+ * spending packet-level simulation time on them.
+ */
+class AqmFluidModel
+{
+  public:
+    /**
+     * @brief AQM algorithm driving the drop probability
+     */
+    enum Algorithm
+    {
+        RED,   //!< RedQueueDisc curve on the EWMA queue
+        DSRED, //!< DsRedQueueDisc curve on the EWMA queue
+        BLUE,  //!< BlueQueueDisc increment/decrement dynamics
+    };
+
+    /**
+     * @brief Scenario and AQM parameters of one fluid run
+     *
+     * Queue lengths and thresholds are in packets.
+     */
+    struct Config
+    {
+        Algorithm algorithm{RED}; //!< AQM algorithm
+        uint32_t nFlows{10};      //!< Number of TCP flows
+        double activeFraction{1}; //!< Mean fraction of flows with data to send
+        double capacity{244};     //!< Bottleneck capacity (packets/s)
+        double flowRateCap{0};    //!< Per-flow sending rate cap (packets/s), 0 for none
+        double propDelay{0.104};  //!< Round trip propagation delay (s)
+        double bufferSize{1000};  //!< Queue disc limit (packets)
+        // RED and DSRED
+        double minTh{5};      //!< Minimum threshold
+        double maxTh{15};     //!< Maximum threshold
+        double midTh{10};     //!< Middle threshold (DSRED)
+        double gamma{0.5};    //!< Gamma (DSRED)
+        double lInterm{50};   //!< RED LInterm, max_p = 1 / LInterm
+        double qW{0.002};     //!< EWMA queue weight
+        bool isGentle{true};  //!< Gentle RED
+        bool isWait{true};    //!< Wait between drops
+        // BLUE
+        double increment{0.02};  //!< Drop probability increment on overflow
+        double decrement{0.002}; //!< Drop probability decrement on underflow
+        double freezeTime{0.1};  //!< Minimum time between probability updates (s)
+        // Integration
+        double duration{30};  //!< Simulated time (s)
+        double warmup{5};     //!< Time excluded from the averages (s)
+        double timeStep{2e-3}; //!< Upper bound on the Euler step (s)
+    };
+
+    /**
+     * @brief Time averages predicted by a fluid run, taken after the warm-up
+     */
+    struct Result
+    {
+        double meanQueue{0};    //!< Mean queue length (packets)
+        double queueStdDev{0};  //!< Standard deviation of the queue length (packets)
+        double meanDelay{0};    //!< Mean queueing delay (s)
+        double lossRate{0};     //!< Fraction of the offered load dropped or marked
+        double utilisation{0};  //!< Fraction of the capacity used
+        double meanDropProb{0}; //!< Mean drop/mark probability
+    };
+
+    /**
+     * @brief Integrate one configuration
+     * @param config the scenario and AQM parameters
+     * @return the time averages of the run
+     */
+    static Result Run(const Config& config);
+};
+
+} // namespace ns3
+
+#endif // AQM_FLUID_MODEL_H
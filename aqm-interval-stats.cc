@@ -0,0 +1,260 @@
+#include "aqm-interval-stats.h"
+
+#include "blue-queue-disc.h"
+#include "queue-disc.h"
+#include "red-queue-disc.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmIntervalStats");
+
+NS_OBJECT_ENSURE_REGISTERED(AqmIntervalStats);
+
+TypeId
+AqmIntervalStats::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AqmIntervalStats")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<AqmIntervalStats>()
+            .AddAttribute("Interval",
+                          "Length of a window",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&AqmIntervalStats::m_interval),
+                          MakeTimeChecker())
+            .AddAttribute("WarmUp",
+                          "Time excluded from the statistics before the first window opens",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&AqmIntervalStats::m_warmUp),
+                          MakeTimeChecker())
+            .AddAttribute("FileName",
+                          "CSV file with one line per window, empty for none",
+                          StringValue(""),
+                          MakeStringAccessor(&AqmIntervalStats::m_fileName),
+                          MakeStringChecker())
+            .AddTraceSource("Window",
+                            "Statistics of a window, fired when it closes",
+                            MakeTraceSourceAccessor(&AqmIntervalStats::m_windowTrace),
+                            "ns3::AqmIntervalStats::WindowTracedCallback");
+    return tid;
+}
+
+AqmIntervalStats::AqmIntervalStats()
+    : m_open(false),
+      m_probSum(0),
+      m_probSamples(0),
+      m_totalProbSum(0),
+      m_totalProbSamples(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AqmIntervalStats::~AqmIntervalStats()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+AqmIntervalStats::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    m_queueDisc = nullptr;
+    m_red = nullptr;
+    m_blue = nullptr;
+    Object::DoDispose();
+}
+
+void
+AqmIntervalStats::Start(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    NS_ABORT_MSG_IF(m_queueDisc, "AqmIntervalStats already started");
+    NS_ABORT_MSG_IF(!m_interval.IsStrictlyPositive(), "The interval must be positive");
+
+    m_queueDisc = queueDisc;
+    m_red = DynamicCast<RedQueueDisc>(queueDisc);
+    m_blue = DynamicCast<BlueQueueDisc>(queueDisc);
+    if (!m_fileName.empty())
+    {
+        m_file.open(m_fileName, std::ios::out);
+        NS_ABORT_MSG_IF(!m_file, "Cannot create " << m_fileName);
+        m_file << "start,end,arrivals,drops,marks,enqueuedBytes,dequeued,sojournMeanMs,"
+               << "sojournP50Ms,sojournP90Ms,sojournP99Ms,sojournMaxMs,meanProbability"
+               << std::endl;
+    }
+
+    queueDisc->TraceConnectWithoutContext("Enqueue",
+                                          MakeCallback(&AqmIntervalStats::Arrival, this));
+    queueDisc->TraceConnectWithoutContext("DropBeforeEnqueue",
+                                          MakeCallback(&AqmIntervalStats::DroppedArrival, this));
+    queueDisc->TraceConnectWithoutContext("SojournTime",
+                                          MakeCallback(&AqmIntervalStats::Sojourn, this));
+    m_total.start = std::max(m_warmUp, Simulator::Now());
+    m_total.end = m_total.start;
+    m_event = Simulator::Schedule(m_total.start - Simulator::Now(), &AqmIntervalStats::Open, this);
+    Simulator::ScheduleDestroy(&AqmIntervalStats::Stop, Ptr<AqmIntervalStats>(this));
+}
+
+void
+AqmIntervalStats::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    if (m_open && Simulator::Now() > m_start)
+    {
+        Report();
+    }
+    m_open = false;
+    if (m_file.is_open())
+    {
+        m_file.close();
+    }
+}
+
+AqmIntervalStats::Snapshot
+AqmIntervalStats::Take() const
+{
+    const QueueDisc::Stats& stats = m_queueDisc->GetStats();
+    Snapshot s;
+    s.arrivals = stats.nTotalReceivedPackets;
+    s.drops = stats.nTotalDroppedPackets;
+    s.marks = stats.nTotalMarkedPackets;
+    s.enqueuedBytes = stats.nTotalEnqueuedBytes;
+    return s;
+}
+
+void
+AqmIntervalStats::Open()
+{
+    NS_LOG_FUNCTION(this);
+    m_open = true;
+    m_start = Simulator::Now();
+    m_snapshot = Take();
+    m_sojourn.Reset();
+    m_probSum = 0;
+    m_probSamples = 0;
+    m_event = Simulator::Schedule(m_interval, &AqmIntervalStats::Close, this);
+}
+
+void
+AqmIntervalStats::Close()
+{
+    NS_LOG_FUNCTION(this);
+    Report();
+    Open();
+}
+
+void
+AqmIntervalStats::SetSojourn(Window& window, const SojournHistogram& histogram)
+{
+    window.dequeued = histogram.GetCount();
+    window.sojournMean = histogram.GetMean();
+    window.sojournP50 = histogram.GetPercentile(50);
+    window.sojournP90 = histogram.GetPercentile(90);
+    window.sojournP99 = histogram.GetPercentile(99);
+    window.sojournMax = histogram.GetMax();
+}
+
+void
+AqmIntervalStats::Report()
+{
+    NS_LOG_FUNCTION(this);
+    Snapshot now = Take();
+    Window w;
+    w.start = m_start;
+    w.end = Simulator::Now();
+    w.arrivals = now.arrivals - m_snapshot.arrivals;
+    w.drops = now.drops - m_snapshot.drops;
+    w.marks = now.marks - m_snapshot.marks;
+    w.enqueuedBytes = now.enqueuedBytes - m_snapshot.enqueuedBytes;
+    SetSojourn(w, m_sojourn);
+    w.meanProbability = m_probSamples > 0 ? m_probSum / m_probSamples : 0;
+
+    m_total.end = w.end;
+    m_total.arrivals += w.arrivals;
+    m_total.drops += w.drops;
+    m_total.marks += w.marks;
+    m_total.enqueuedBytes += w.enqueuedBytes;
+    m_totalSojourn.Merge(m_sojourn);
+    m_totalProbSum += m_probSum;
+    m_totalProbSamples += m_probSamples;
+
+    NS_LOG_DEBUG(w);
+    m_windowTrace(w);
+    if (m_file.is_open())
+    {
+        m_file << w.start.GetSeconds() << "," << w.end.GetSeconds() << "," << w.arrivals << ","
+               << w.drops << "," << w.marks << "," << w.enqueuedBytes << "," << w.dequeued << ","
+               << w.sojournMean.GetSeconds() * 1e3 << "," << w.sojournP50.GetSeconds() * 1e3
+               << "," << w.sojournP90.GetSeconds() * 1e3 << ","
+               << w.sojournP99.GetSeconds() * 1e3 << "," << w.sojournMax.GetSeconds() * 1e3
+               << "," << w.meanProbability << std::endl;
+    }
+}
+
+AqmIntervalStats::Window
+AqmIntervalStats::GetTotal() const
+{
+    Window total = m_total;
+    SetSojourn(total, m_totalSojourn);
+    total.meanProbability = m_totalProbSamples > 0 ? m_totalProbSum / m_totalProbSamples : 0;
+    return total;
+}
+
+void
+AqmIntervalStats::Arrival(Ptr<const QueueDiscItem> item)
+{
+    if (!m_open)
+    {
+        return;
+    }
+    if (m_red)
+    {
+        m_probSum += m_red->GetDropProbability();
+    }
+    else if (m_blue)
+    {
+        m_probSum += m_blue->GetDropProbability();
+    }
+    m_probSamples++;
+}
+
+void
+AqmIntervalStats::DroppedArrival(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    Arrival(item);
+}
+
+void
+AqmIntervalStats::Sojourn(Time sojourn)
+{
+    if (m_open)
+    {
+        m_sojourn.Record(sojourn);
+    }
+}
+
+std::ostream&
+operator<<(std::ostream& os, const AqmIntervalStats::Window& window)
+{
+    os << "Window " << window.start.As(Time::S) << " to " << window.end.As(Time::S) << ": "
+       << window.arrivals << " arrivals, " << window.drops << " drops, " << window.marks
+       << " marks, " << window.enqueuedBytes << " bytes enqueued, sojourn mean "
+       << window.sojournMean.As(Time::MS) << " p50 " << window.sojournP50.As(Time::MS) << " p90 "
+       << window.sojournP90.As(Time::MS) << " p99 " << window.sojournP99.As(Time::MS)
+       << " max " << window.sojournMax.As(Time::MS) << ", mean probability "
+       << window.meanProbability;
+    return os;
+}
+
+} // namespace ns3
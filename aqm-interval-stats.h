@@ -0,0 +1,198 @@
+#ifndef AQM_INTERVAL_STATS_H
+#define AQM_INTERVAL_STATS_H
+
+#include "sojourn-histogram.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/traced-callback.h"
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+
+namespace ns3
+{
+
+class QueueDisc;
+class QueueDiscItem;
+class RedQueueDisc;
+class BlueQueueDisc;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Per-window statistics of a queue disc, excluding a warm-up period
+ *
+ * QueueDisc::Stats counts from the start of the simulation, slow start
+ * included. From WarmUp on, AqmIntervalStats cuts the time into windows of
+ * Interval and, at the end of each, reports the difference of the
+ * counters of the queue disc over the window (packets received, dropped
+ * and marked, bytes enqueued), the sojourn-time percentiles of the packets
+ * dequeued in the window and the mean drop probability seen by its
+ * arrivals (RED p_b or BLUE p_m; zero for other queue discs). Each window
+ * is fired through the Window trace and, if FileName is set, written as a
+ * CSV line. The windows are also merged into a total covering everything
+ * after the warm-up.
+ *
+ * Only the open window and the total are kept, each with a fixed-size
+ * SojournHistogram, so the memory does not grow with the simulated time.
+ */
+class AqmIntervalStats : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AqmIntervalStats();
+    ~AqmIntervalStats() override;
+
+    /**
+     * @brief Statistics of one window, or of the whole time after the warm-up
+     */
+    struct Window
+    {
+        Time start;              //!< Start of the window
+        Time end;                //!< End of the window
+        uint64_t arrivals{0};    //!< Packets received by the queue disc
+        uint64_t drops{0};       //!< Packets dropped
+        uint64_t marks{0};       //!< Packets marked
+        uint64_t enqueuedBytes{0}; //!< Bytes enqueued
+        uint64_t dequeued{0};    //!< Packets whose sojourn time was recorded
+        Time sojournMean;        //!< Mean sojourn time
+        Time sojournP50;         //!< Median sojourn time
+        Time sojournP90;         //!< 90th percentile of the sojourn time
+        Time sojournP99;         //!< 99th percentile of the sojourn time
+        Time sojournMax;         //!< Largest sojourn time
+        double meanProbability{0}; //!< Mean drop probability at the arrivals
+    };
+
+    /**
+     * @brief TracedCallback signature for closed windows
+     * @param [in] window the statistics of the window
+     */
+    typedef void (*WindowTracedCallback)(const Window& window);
+
+    /**
+     * @brief Start cutting the statistics of a queue disc into windows at WarmUp
+     * @param queueDisc the monitored queue disc
+     */
+    void Start(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Close the open window, even if shorter than Interval, and stop
+     */
+    void Stop();
+
+    /**
+     * @return the statistics of the windows closed so far, merged
+     */
+    Window GetTotal() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief Counters of the queue disc at a window boundary
+     */
+    struct Snapshot
+    {
+        uint64_t arrivals{0};      //!< Packets received
+        uint64_t drops{0};         //!< Packets dropped
+        uint64_t marks{0};         //!< Packets marked
+        uint64_t enqueuedBytes{0}; //!< Bytes enqueued
+    };
+
+    /**
+     * @brief Read the counters of the queue disc
+     * @return the counters
+     */
+    Snapshot Take() const;
+
+    /**
+     * @brief Open the first window, at the end of the warm-up
+     */
+    void Open();
+
+    /**
+     * @brief Report the open window and add it to the total
+     */
+    void Report();
+
+    /**
+     * @brief Report the open window at its boundary and open the next one
+     */
+    void Close();
+
+    /**
+     * @brief Fill the sojourn fields of a window from a histogram
+     * @param window the window
+     * @param histogram the sojourn times of the window
+     */
+    static void SetSojourn(Window& window, const SojournHistogram& histogram);
+
+    /**
+     * @brief Enqueue trace sink, adding the probability seen by the arrival
+     * @param item the enqueued packet
+     */
+    void Arrival(Ptr<const QueueDiscItem> item);
+
+    /**
+     * @brief DropBeforeEnqueue trace sink, adding the probability seen by the arrival
+     * @param item the dropped packet
+     * @param reason the drop reason
+     */
+    void DroppedArrival(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief SojournTime trace sink
+     * @param sojourn the time the dequeued packet spent in the queue disc
+     */
+    void Sojourn(Time sojourn);
+
+    Time m_interval;        //!< Length of a window
+    Time m_warmUp;          //!< Time excluded before the first window
+    std::string m_fileName; //!< CSV output, empty for none
+
+    Ptr<QueueDisc> m_queueDisc; //!< Monitored queue disc
+    Ptr<RedQueueDisc> m_red;    //!< Monitored queue disc, if of the RED family
+    Ptr<BlueQueueDisc> m_blue;  //!< Monitored queue disc, if BLUE
+    EventId m_event;            //!< Next window boundary
+    bool m_open;                //!< True while a window is open
+    std::ofstream m_file;       //!< CSV output
+
+    // Open window
+    Time m_start;                //!< Start of the window
+    Snapshot m_snapshot;         //!< Counters at the start of the window
+    SojournHistogram m_sojourn;  //!< Sojourn times of the window
+    double m_probSum;            //!< Sum of the probabilities at the arrivals
+    uint64_t m_probSamples;      //!< Arrivals whose probability was added
+
+    // After the warm-up
+    Window m_total;                   //!< Counters of the closed windows
+    SojournHistogram m_totalSojourn;  //!< Sojourn times of the closed windows
+    double m_totalProbSum;            //!< Sum of the probabilities at the arrivals
+    uint64_t m_totalProbSamples;      //!< Arrivals whose probability was added
+
+    TracedCallback<const Window&> m_windowTrace; //!< Fired for each closed window
+};
+
+/**
+ * @brief Stream insertion operator.
+ *
+ * @param os the reference to the output stream
+ * @param window the statistics of a window
+ * @return the reference to the output stream
+ */
+std::ostream& operator<<(std::ostream& os, const AqmIntervalStats::Window& window);
+
+} // namespace ns3
+
+#endif // AQM_INTERVAL_STATS_H
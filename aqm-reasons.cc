@@ -0,0 +1,59 @@
+#include "aqm-reasons.h"
+
+#include "ns3/abort.h"
+
+#include <cstring>
+#include <vector>
+
+namespace ns3
+{
+
+namespace
+{
+
+/**
+ * @return the registered reason strings, by ID
+ *
+ * Built on first use, so queue discs can register from static initializers
+ * of any translation unit.
+ */
+std::vector<const char*>&
+GetReasonTable()
+{
+    static std::vector<const char*> table;
+    return table;
+}
+
+} // namespace
+
+uint16_t
+AqmReasons::Register(const char* reason)
+{
+    std::vector<const char*>& table = GetReasonTable();
+    for (uint16_t id = 0; id < table.size(); ++id)
+    {
+        if (std::strcmp(table[id], reason) == 0)
+        {
+            return id;
+        }
+    }
+    NS_ABORT_MSG_IF(table.size() == MAX_REASONS,
+                    "Too many AQM reasons, cannot register " << reason);
+    table.push_back(reason);
+    return table.size() - 1;
+}
+
+const char*
+AqmReasons::GetName(uint16_t id)
+{
+    NS_ABORT_MSG_IF(id >= GetReasonTable().size(), "Unknown AQM reason " << id);
+    return GetReasonTable()[id];
+}
+
+uint16_t
+AqmReasons::GetN()
+{
+    return GetReasonTable().size();
+}
+
+} // namespace ns3
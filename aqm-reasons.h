@@ -0,0 +1,47 @@
+#ifndef AQM_REASONS_H
+#define AQM_REASONS_H
+
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Process-wide table giving a small integer ID to every drop and
+ * mark reason of the AQM queue discs
+ *
+ * Queue discs register their reason strings once, when the module is
+ * loaded, and keep the IDs in static members next to the strings (e.g.
+ * RedQueueDisc::UNFORCED_DROP_ID). Registering the same string twice
+ * returns the same ID, so RED and its subclasses share theirs. The IDs
+ * only name reasons in compact records such as those of AqmEventLog; the
+ * drop and mark counts stay in the string-keyed QueueDisc::Stats.
+ */
+class AqmReasons
+{
+  public:
+    static constexpr uint16_t MAX_REASONS = 32; //!< Capacity of the table
+
+    /**
+     * @brief Get the ID of a reason, registering it if new
+     * @param reason the reason string
+     * @return the reason ID
+     */
+    static uint16_t Register(const char* reason);
+
+    /**
+     * @brief Get the string of a registered reason
+     * @param id the reason ID
+     * @return the reason string
+     */
+    static const char* GetName(uint16_t id);
+
+    /// @return the number of registered reasons
+    static uint16_t GetN();
+};
+
+} // namespace ns3
+
+#endif // AQM_REASONS_H
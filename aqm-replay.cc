@@ -0,0 +1,320 @@
+#include "aqm-replay.h"
+
+#include "aqm-drop-curves.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmReplay");
+
+AqmReplay::AqmReplay(uint64_t linkRate,
+                     const std::vector<Config>& configs,
+                     uint64_t seed,
+                     bool commonRandomNumbers)
+    : m_nsPerByte(8e9 / linkRate),
+      m_common(commonRandomNumbers),
+      m_rng(seed),
+      m_first(0),
+      m_last(0),
+      m_started(false)
+{
+    NS_LOG_FUNCTION(this << linkRate << configs.size() << seed << commonRandomNumbers);
+    NS_ASSERT(linkRate > 0);
+
+    m_instances.resize(configs.size());
+    for (std::size_t i = 0; i < configs.size(); ++i)
+    {
+        Instance& s = m_instances[i];
+        const Config& c = configs[i];
+        s.config = c;
+        s.rng.seed(seed + i);
+
+        // Same derived constants as RedQueueDisc::InitializeParams
+        double thDiff = c.maxTh - c.minTh;
+        if (thDiff == 0)
+        {
+            thDiff = 1.0;
+        }
+        s.curMaxP = 1.0 / c.lInterm;
+        s.vA = 1.0 / thDiff;
+        s.vB = -c.minTh / thDiff;
+        s.vC = (1.0 - s.curMaxP) / c.maxTh;
+        s.vD = 2.0 * s.curMaxP - 1.0;
+        s.ptc = linkRate / (8.0 * c.meanPktSize);
+    }
+}
+
+int64_t
+AqmReplay::TxTime(uint32_t size) const
+{
+    return std::llround(size * m_nsPerByte);
+}
+
+void
+AqmReplay::UpdateBlue(Instance& s, int64_t now, bool overflow)
+{
+    if (now - s.lastUpdate < std::llround(s.config.freezeTime * 1e9))
+    {
+        return;
+    }
+    if (overflow)
+    {
+        s.dropProb = BlueIncrease(s.dropProb, s.config.increment);
+    }
+    else if (s.queue.empty())
+    {
+        s.dropProb = BlueDecrease(s.dropProb, s.config.decrement);
+    }
+    s.lastUpdate = now;
+}
+
+void
+AqmReplay::StartTx(Instance& s, int64_t now) const
+{
+    s.queueArea += s.queue.size() * static_cast<double>(now - s.lastChange);
+    s.lastChange = now;
+
+    const Packet& p = s.queue.front();
+    int64_t tx = TxTime(p.size);
+    s.delaySum += now - p.arrival;
+    s.sent++;
+    s.queue.pop_front();
+
+    s.busy = true;
+    s.idle = false;
+    s.txEnd = now + tx;
+    s.busyTime += tx;
+}
+
+void
+AqmReplay::Drain(Instance& s, int64_t now) const
+{
+    // The link asks for the next packet whenever a transmission ends
+    while (s.busy && s.txEnd <= now)
+    {
+        if (s.queue.empty())
+        {
+            s.busy = false;
+            s.idle = true;
+            s.idleTime = s.txEnd;
+            if (s.config.algorithm == BLUE)
+            {
+                UpdateBlue(s, s.txEnd, false);
+            }
+            break;
+        }
+        StartTx(s, s.txEnd);
+    }
+}
+
+void
+AqmReplay::Arrive(Instance& s, const AqmArrivalRecord& r, double u) const
+{
+    const Config& c = s.config;
+    int64_t now = r.time;
+    auto nQueued = static_cast<uint32_t>(s.queue.size());
+    bool drop = false;
+    bool mark = false;
+    s.result.arrivals++;
+
+    if (c.algorithm == BLUE)
+    {
+        if (nQueued >= c.limit)
+        {
+            UpdateBlue(s, now, true);
+            drop = true;
+        }
+        s.probSum += s.dropProb;
+    }
+    else
+    {
+        // RedQueueDisc::DoEnqueue, packet mode
+        uint32_t m = 0;
+        if (s.idle)
+        {
+            m = static_cast<uint32_t>(s.ptc * (now - s.idleTime) * 1e-9);
+            s.idle = false;
+        }
+        s.qAvg *= m == 0 ? 1.0 - c.qW : std::pow(1.0 - c.qW, m + 1);
+        s.qAvg += c.qW * nQueued;
+        s.count++;
+
+        if (s.qAvg >= c.minTh && nQueued > 1)
+        {
+            if ((!c.isGentle && s.qAvg >= c.maxTh) || (c.isGentle && s.qAvg >= 2 * c.maxTh))
+            {
+                // Hard drop, as with UseHardDrop
+                drop = true;
+            }
+            else if (!s.old)
+            {
+                s.count = 1;
+                s.old = true;
+            }
+            else
+            {
+                double p = c.algorithm == DSRED
+                               ? DsRedDropCurve(s.qAvg, c.minTh, c.midTh, c.maxTh, c.lInterm, c.gamma)
+                               : RedDropCurve(s.qAvg,
+                                              s.vA,
+                                              s.vB,
+                                              s.vC,
+                                              s.vD,
+                                              c.maxTh,
+                                              s.curMaxP,
+                                              c.isGentle,
+                                              false);
+                s.vProb = std::min(RedSpacedProbability(p, s.count, c.isWait), 1.0);
+                if (!m_common)
+                {
+                    u = (s.rng() >> 11) * 0x1.0p-53;
+                }
+                if (u <= s.vProb)
+                {
+                    s.count = 0;
+                    mark = c.useEcn && r.ecn != 0;
+                    drop = !mark;
+                }
+            }
+        }
+        else
+        {
+            s.vProb = 0.0;
+            s.old = false;
+        }
+        s.probSum += s.vProb;
+        // The internal queue of RedQueueDisc holds at most limit packets
+        drop = drop || nQueued >= c.limit;
+    }
+
+    if (drop)
+    {
+        s.result.drops++;
+        return;
+    }
+    if (mark)
+    {
+        s.result.marks++;
+    }
+
+    s.queueArea += nQueued * static_cast<double>(now - s.lastChange);
+    s.lastChange = now;
+    s.queue.push_back({now, r.size});
+    if (!s.busy)
+    {
+        // An idle link takes the packet at once
+        StartTx(s, now);
+    }
+    s.result.maxQueue = std::max(s.result.maxQueue, static_cast<uint32_t>(s.queue.size()));
+}
+
+void
+AqmReplay::Feed(const AqmArrivalRecord* records, std::size_t n)
+{
+    NS_LOG_FUNCTION(this << n);
+    if (n == 0)
+    {
+        return;
+    }
+    if (!m_started)
+    {
+        m_started = true;
+        m_first = records[0].time;
+        for (auto& s : m_instances)
+        {
+            s.lastChange = m_first;
+            s.idleTime = m_first;
+            // The first overflow may update BLUE at once
+            s.lastUpdate = std::numeric_limits<int64_t>::min() / 2;
+        }
+    }
+    m_last = records[n - 1].time;
+
+    // The same random numbers for every configuration
+    m_uniform.assign(n, 0.0);
+    for (std::size_t i = 0; m_common && i < n; ++i)
+    {
+        m_uniform[i] = (m_rng() >> 11) * 0x1.0p-53;
+    }
+
+    // One configuration at a time over the block, keeping its state in cache
+    for (auto& s : m_instances)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Drain(s, records[i].time);
+            Arrive(s, records[i], m_uniform[i]);
+        }
+    }
+}
+
+std::vector<AqmReplay::Result>
+AqmReplay::GetResults() const
+{
+    std::vector<Result> results;
+    auto duration = static_cast<double>(m_last - m_first);
+    for (const auto& s : m_instances)
+    {
+        Result r = s.result;
+        double area = s.queueArea + s.queue.size() * static_cast<double>(m_last - s.lastChange);
+        double busy = s.busyTime - (s.busy ? std::max<int64_t>(s.txEnd - m_last, 0) : 0);
+        r.meanQueue = duration > 0 ? area / duration : 0;
+        r.utilisation = duration > 0 ? busy / duration : 0;
+        r.meanDelay = s.sent > 0 ? s.delaySum / s.sent * 1e-9 : 0;
+        r.meanDropProb = r.arrivals > 0 ? s.probSum / r.arrivals : 0;
+        results.push_back(r);
+    }
+    return results;
+}
+
+std::vector<AqmReplay::Result>
+AqmReplay::Run(const std::string& fileName,
+               AqmArrivalTraceHeader& header,
+               uint64_t& linkRate,
+               const std::vector<Config>& configs,
+               uint64_t seed)
+{
+    NS_LOG_FUNCTION(fileName << linkRate << configs.size() << seed);
+
+    std::FILE* file = OpenTrace(fileName, header, linkRate);
+    AqmReplay replay(linkRate, configs, seed);
+    std::vector<AqmArrivalRecord> block(1 << 16);
+    std::size_t got;
+    while ((got = std::fread(block.data(), sizeof(AqmArrivalRecord), block.size(), file)) > 0)
+    {
+        replay.Feed(block.data(), got);
+    }
+    std::fclose(file);
+    return replay.GetResults();
+}
+
+std::FILE*
+AqmReplay::OpenTrace(const std::string& fileName, AqmArrivalTraceHeader& header, uint64_t& linkRate)
+{
+    NS_LOG_FUNCTION(fileName << linkRate);
+
+    std::FILE* file = std::fopen(fileName.c_str(), "rb");
+    NS_ABORT_MSG_IF(!file, "Cannot open " << fileName << ": " << std::strerror(errno));
+    NS_ABORT_MSG_IF(std::fread(&header, sizeof(header), 1, file) != 1 ||
+                        header.magic != AQM_ARRIVAL_TRACE_MAGIC ||
+                        header.recordSize != sizeof(AqmArrivalRecord),
+                    fileName << " is not an arrival trace of this build");
+    if (linkRate == 0)
+    {
+        linkRate = header.linkRate;
+    }
+    NS_ABORT_MSG_IF(linkRate == 0, fileName << " does not record the link rate, give it");
+    return file;
+}
+
+} // namespace ns3
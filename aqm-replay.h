@@ -0,0 +1,245 @@
+#ifndef AQM_REPLAY_H
+#define AQM_REPLAY_H
+
+#include "aqm-arrival-trace-format.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Open-loop replay of a captured arrival trace through the RED,
+ * DSRED and BLUE decisions
+ *
+ * Each configuration owns a FIFO served at the link rate of the trace, the
+ * device holding only the packet being sent, and the decision state of its
+ * algorithm: the arrival steps of RedQueueDisc::DoEnqueue (idle-time
+ * compensated EWMA, forced drops above MaxTh or twice MaxTh when gentle,
+ * count-spaced early drops with the RedQueueDisc or DsRedQueueDisc curve,
+ * marks for ECN-capable packets with UseEcn) and those of BlueQueueDisc
+ * (freeze-time limited increments on overflow and decrements when the
+ * link finds the queue empty). The curves come from aqm-drop-curves.h,
+ * like in the queue discs. Departures are computed from the arrival times
+ * rather than scheduled, and there is no transport: the arrivals do not
+ * react to the decisions, so the replay tells how an AQM would have
+ * judged the captured traffic, not how the senders would have adapted.
+ *
+ * Every arrival is fed to all the configurations, block by block, so one
+ * pass over the trace screens a whole parameter grid. Adaptive max_p
+ * (ARED, Feng), byte mode and the cautious variants are not modelled.
+ *
+ * By default each configuration draws its own random numbers, and only
+ * when it tests for an early drop. With common random numbers, one number
+ * is drawn per arrival and shared by all the configurations, as
+ * AqmBatchReplay does.
+ */
+class AqmReplay
+{
+  public:
+    /**
+     * @brief AQM algorithm of a configuration
+     */
+    enum Algorithm
+    {
+        RED,   //!< RedQueueDisc
+        DSRED, //!< DsRedQueueDisc
+        BLUE,  //!< BlueQueueDisc
+    };
+
+    /**
+     * @brief AQM parameters of one configuration, queue lengths in packets
+     */
+    struct Config
+    {
+        Algorithm algorithm{RED};  //!< AQM algorithm
+        double limit{1000};        //!< Queue disc limit (packets)
+        // RED and DSRED
+        double minTh{5};           //!< Minimum threshold
+        double maxTh{15};          //!< Maximum threshold
+        double midTh{10};          //!< Middle threshold (DSRED)
+        double gamma{0.5};         //!< Gamma (DSRED)
+        double lInterm{50};        //!< RED LInterm, max_p = 1 / LInterm
+        double qW{0.002};          //!< EWMA queue weight
+        uint32_t meanPktSize{500}; //!< Packet size used to count idle-time arrivals (bytes)
+        bool isGentle{true};       //!< Gentle RED
+        bool isWait{true};         //!< Wait between drops
+        bool useEcn{false};        //!< Mark ECN-capable packets instead of dropping them
+        // BLUE
+        double increment{0.02};  //!< Drop probability increment on overflow
+        double decrement{0.002}; //!< Drop probability decrement when the link goes idle
+        double freezeTime{0.1};  //!< Minimum time between probability updates (s)
+    };
+
+    /**
+     * @brief What a configuration did with the trace
+     */
+    struct Result
+    {
+        uint64_t arrivals{0};     //!< Packets offered
+        uint64_t drops{0};        //!< Packets dropped, early, forced or on overflow
+        uint64_t marks{0};        //!< Packets marked
+        double meanQueue{0};      //!< Time-averaged queue length (packets)
+        uint32_t maxQueue{0};     //!< Longest queue (packets)
+        double meanDelay{0};      //!< Mean queueing delay of the sent packets (s)
+        double utilisation{0};    //!< Fraction of the time the link was busy
+        double meanDropProb{0};   //!< Mean probability at the arrivals (RED p_b, BLUE p_m)
+    };
+
+    /**
+     * @param linkRate rate of the link draining the queues (bit/s)
+     * @param configs the configurations to replay
+     * @param seed seed of the random numbers; configuration i uses seed + i,
+     *        unless they are common
+     * @param commonRandomNumbers true to share the random number of each
+     *        arrival between the configurations
+     */
+    AqmReplay(uint64_t linkRate,
+              const std::vector<Config>& configs,
+              uint64_t seed,
+              bool commonRandomNumbers = false);
+
+    /**
+     * @brief Feed a block of consecutive arrivals to all the configurations
+     * @param records the arrivals, in time order
+     * @param n the number of arrivals
+     */
+    void Feed(const AqmArrivalRecord* records, std::size_t n);
+
+    /**
+     * @brief Get the results, with the averages taken from the first to the
+     * last arrival fed
+     * @return one result per configuration, in the order of the configurations
+     */
+    std::vector<Result> GetResults() const;
+
+    /**
+     * @brief Replay a trace file
+     * @param fileName the trace written by AqmArrivalCapture
+     * @param header set to the trace header
+     * @param[in,out] linkRate rate of the link (bit/s); 0 to take that of the trace
+     * @param configs the configurations to replay
+     * @param seed seed of the random numbers
+     * @return one result per configuration
+     */
+    static std::vector<Result> Run(const std::string& fileName,
+                                   AqmArrivalTraceHeader& header,
+                                   uint64_t& linkRate,
+                                   const std::vector<Config>& configs,
+                                   uint64_t seed);
+
+    /**
+     * @brief Open a trace file and check its header
+     * @param fileName the trace written by AqmArrivalCapture
+     * @param header set to the trace header
+     * @param[in,out] linkRate rate of the link (bit/s); 0 to take that of the trace
+     * @return the file, positioned on the first record
+     */
+    static std::FILE* OpenTrace(const std::string& fileName,
+                                AqmArrivalTraceHeader& header,
+                                uint64_t& linkRate);
+
+  private:
+    /**
+     * @brief Waiting packet of a replayed queue
+     */
+    struct Packet
+    {
+        int64_t arrival; //!< Arrival time (ns)
+        uint32_t size;   //!< Size (bytes)
+    };
+
+    /**
+     * @brief Queue and decision state of one configuration
+     */
+    struct Instance
+    {
+        Config config;            //!< Parameters
+        std::mt19937_64 rng;      //!< Random numbers of the early drops
+        std::deque<Packet> queue; //!< Waiting packets
+        bool busy{false};         //!< True while the link sends a packet
+        int64_t txEnd{0};         //!< End of the current transmission (ns)
+        // RED
+        double vA{0};             //!< 1 / (maxTh - minTh)
+        double vB{0};             //!< -minTh / (maxTh - minTh)
+        double vC{0};             //!< Gentle slope
+        double vD{0};             //!< Gentle intercept
+        double curMaxP{0};        //!< max_p
+        double ptc{0};            //!< Mean-sized packets sent per second
+        double qAvg{0};           //!< Average queue length
+        double vProb{0};          //!< Spaced drop probability of the last early-drop test
+        uint32_t count{0};        //!< Arrivals since the last early drop
+        bool old{false};          //!< True once the average crossed minTh
+        bool idle{true};          //!< True while the link finds the queue empty
+        int64_t idleTime{0};      //!< Time the link went idle (ns)
+        // BLUE
+        double dropProb{0};       //!< BLUE drop probability
+        int64_t lastUpdate{0};    //!< Last BLUE update (ns)
+        // Statistics
+        Result result;            //!< Counters
+        double queueArea{0};      //!< Queue length integrated over time (packet ns)
+        double delaySum{0};       //!< Sum of the queueing delays (ns)
+        uint64_t sent{0};         //!< Packets sent
+        double busyTime{0};       //!< Time the link was busy (ns)
+        double probSum{0};        //!< Sum of the probabilities at the arrivals
+        int64_t lastChange{0};    //!< Last update of queueArea (ns)
+    };
+
+    /**
+     * @brief Send the packets whose transmission can start up to a time
+     * @param s the configuration
+     * @param now the time of the next arrival (ns)
+     */
+    void Drain(Instance& s, int64_t now) const;
+
+    /**
+     * @brief Start sending the head of a queue
+     * @param s the configuration
+     * @param now the time the link asks for a packet (ns)
+     */
+    void StartTx(Instance& s, int64_t now) const;
+
+    /**
+     * @brief Decide on an arrival and queue it if accepted
+     * @param s the configuration
+     * @param r the arrival
+     * @param u the common random number of the arrival, unused if the
+     *        configurations draw their own
+     */
+    void Arrive(Instance& s, const AqmArrivalRecord& r, double u) const;
+
+    /**
+     * @brief Update the BLUE drop probability, as BlueQueueDisc::UpdateDropProb
+     * @param s the configuration
+     * @param now the time of the event (ns)
+     * @param overflow true on overflow, false when the link finds the queue empty
+     */
+    static void UpdateBlue(Instance& s, int64_t now, bool overflow);
+
+    /**
+     * @brief Transmission time of a packet
+     * @param size the packet size (bytes)
+     * @return the time (ns)
+     */
+    int64_t TxTime(uint32_t size) const;
+
+    double m_nsPerByte;               //!< Transmission time of a byte (ns)
+    std::vector<Instance> m_instances; //!< One per configuration
+    bool m_common;                    //!< True to use common random numbers
+    std::mt19937_64 m_rng;            //!< Common random numbers
+    std::vector<double> m_uniform;    //!< Random numbers of the arrivals being fed
+    int64_t m_first;                  //!< Time of the first arrival fed (ns)
+    int64_t m_last;                   //!< Time of the last arrival fed (ns)
+    bool m_started;                   //!< True once an arrival has been fed
+};
+
+} // namespace ns3
+
+#endif // AQM_REPLAY_H
@@ -0,0 +1,283 @@
+#include "aqm-steady-state-monitor.h"
+
+#include "queue-disc.h"
+
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmSteadyStateMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED(AqmSteadyStateMonitor);
+
+TypeId
+AqmSteadyStateMonitor::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AqmSteadyStateMonitor")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<AqmSteadyStateMonitor>()
+            .AddAttribute("Window",
+                          "Time the queue length, probability and goodput are averaged over",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&AqmSteadyStateMonitor::m_window),
+                          MakeTimeChecker())
+            .AddAttribute("HoldTime",
+                          "Time the window means must agree to declare the steady state",
+                          TimeValue(Seconds(5)),
+                          MakeTimeAccessor(&AqmSteadyStateMonitor::m_holdTime),
+                          MakeTimeChecker())
+            .AddAttribute("StartTime",
+                          "Time the first window opens, e.g. when the senders start",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&AqmSteadyStateMonitor::m_startTime),
+                          MakeTimeChecker())
+            .AddAttribute("EndTime",
+                          "Time after which no window closes, e.g. when the senders stop; "
+                          "zero for none",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&AqmSteadyStateMonitor::m_endTime),
+                          MakeTimeChecker())
+            .AddAttribute("Tolerance",
+                          "Relative difference allowed between a window and the run before it",
+                          DoubleValue(0.1),
+                          MakeDoubleAccessor(&AqmSteadyStateMonitor::m_tolerance),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("StopSimulation",
+                          "Stop the simulator once the steady state is declared",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&AqmSteadyStateMonitor::m_stopSimulation),
+                          MakeBooleanChecker());
+    return tid;
+}
+
+AqmSteadyStateMonitor::AqmSteadyStateMonitor()
+    : m_delivered(0),
+      m_length(0),
+      m_arrivals(0),
+      m_signals(0),
+      m_open(false),
+      m_done(false),
+      m_queueArea(0),
+      m_windowArrivals(0),
+      m_windowSignals(0),
+      m_windowDelivered(0),
+      m_runLength(0),
+      m_runQueue(0),
+      m_runProb(0),
+      m_runGoodput(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AqmSteadyStateMonitor::~AqmSteadyStateMonitor()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+AqmSteadyStateMonitor::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_queueDisc)
+    {
+        m_queueDisc->TraceDisconnectWithoutContext(
+            "PacketsInQueue",
+            MakeCallback(&AqmSteadyStateMonitor::QueueLengthChanged, this));
+    }
+    m_done = true;
+    m_queueDisc = nullptr;
+    Object::DoDispose();
+}
+
+void
+AqmSteadyStateMonitor::Start(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    NS_ABORT_MSG_IF(m_queueDisc, "AqmSteadyStateMonitor already started");
+    NS_ABORT_MSG_IF(!m_window.IsStrictlyPositive(), "The window must be positive");
+
+    m_queueDisc = queueDisc;
+    m_length = queueDisc->GetNPackets();
+    ReadCounters();
+    m_windowStart = std::max(m_startTime, Simulator::Now());
+    queueDisc->TraceConnectWithoutContext(
+        "PacketsInQueue",
+        MakeCallback(&AqmSteadyStateMonitor::QueueLengthChanged, this));
+}
+
+void
+AqmSteadyStateMonitor::Delivered(Ptr<const Packet> packet, const Address& from)
+{
+    // The bytes count towards the window open at their delivery
+    Advance();
+    m_delivered += packet->GetSize();
+}
+
+void
+AqmSteadyStateMonitor::QueueLengthChanged(uint32_t oldValue, uint32_t newValue)
+{
+    // The old length held until now
+    Advance();
+    m_length = newValue;
+}
+
+const AqmSteadyStateMonitor::Estimate&
+AqmSteadyStateMonitor::GetEstimate() const
+{
+    return m_estimate;
+}
+
+void
+AqmSteadyStateMonitor::Advance()
+{
+    if (m_done || !m_queueDisc)
+    {
+        return;
+    }
+    Time now = Simulator::Now();
+    if (!m_open)
+    {
+        if (now < m_windowStart)
+        {
+            ReadCounters();
+            return;
+        }
+        m_open = true;
+        OpenWindow(m_windowStart);
+    }
+    if (now >= m_windowStart + m_window)
+    {
+        // Close the window of the last event
+        Time end = m_windowStart + m_window;
+        if (!m_endTime.IsZero() && end > m_endTime)
+        {
+            // The traffic being judged is over
+            m_done = true;
+            return;
+        }
+        Integrate(end);
+        CloseWindow(end);
+        if (m_estimate.steady)
+        {
+            m_done = true;
+            return;
+        }
+        // Nothing happened in the whole windows since then: skip them, and
+        // start a new run after the gap
+        int64_t idle = (now - end).GetTimeStep() / m_window.GetTimeStep();
+        if (idle > 0)
+        {
+            NS_LOG_DEBUG("Skipping " << idle << " idle windows");
+            m_runLength = 0;
+        }
+        OpenWindow(end + m_window * idle);
+    }
+    Integrate(now);
+    ReadCounters();
+}
+
+void
+AqmSteadyStateMonitor::ReadCounters()
+{
+    const QueueDisc::Stats& stats = m_queueDisc->GetStats();
+    m_arrivals = stats.nTotalReceivedPackets;
+    m_signals = stats.nTotalDroppedPackets + stats.nTotalMarkedPackets;
+}
+
+void
+AqmSteadyStateMonitor::Integrate(Time now)
+{
+    m_queueArea += m_length * (now - m_lastChange).GetSeconds();
+    m_lastChange = now;
+}
+
+void
+AqmSteadyStateMonitor::OpenWindow(Time start)
+{
+    m_windowStart = start;
+    m_lastChange = start;
+    m_queueArea = 0;
+    m_windowArrivals = m_arrivals;
+    m_windowSignals = m_signals;
+    m_windowDelivered = m_delivered;
+}
+
+bool
+AqmSteadyStateMonitor::Agrees(double value, double reference, double resolution) const
+{
+    double difference = std::abs(value - reference);
+    return difference <= resolution || difference <= m_tolerance * std::abs(reference);
+}
+
+void
+AqmSteadyStateMonitor::CloseWindow(Time end)
+{
+    NS_LOG_FUNCTION(this << end);
+    double duration = (end - m_windowStart).GetSeconds();
+    uint64_t arrivals = m_arrivals - m_windowArrivals;
+    uint64_t signals = m_signals - m_windowSignals;
+
+    double queue = m_queueArea / duration;
+    double prob = arrivals > 0 ? static_cast<double>(signals) / arrivals : 0;
+    double goodput = (m_delivered - m_windowDelivered) * 8.0 / duration;
+    NS_LOG_DEBUG("Window ending at " << end.As(Time::S) << ": queue " << queue
+                                     << " probability " << prob << " goodput " << goodput);
+
+    bool agrees = m_runLength > 0 && Agrees(queue, m_runQueue / m_runLength, 0.5) &&
+                  Agrees(prob, m_runProb / m_runLength, 0.001) &&
+                  Agrees(goodput, m_runGoodput / m_runLength, 0);
+    if (!agrees)
+    {
+        // The window starts a new run
+        m_runStart = m_windowStart;
+        m_runLength = 0;
+        m_runQueue = 0;
+        m_runProb = 0;
+        m_runGoodput = 0;
+    }
+    m_runLength++;
+    m_runQueue += queue;
+    m_runProb += prob;
+    m_runGoodput += goodput;
+
+    if (m_runLength > 1 && end - m_runStart >= m_holdTime)
+    {
+        m_estimate.steady = true;
+        m_estimate.start = m_runStart;
+        m_estimate.end = end;
+        m_estimate.queue = m_runQueue / m_runLength;
+        m_estimate.probability = m_runProb / m_runLength;
+        m_estimate.goodput = m_runGoodput / m_runLength;
+        NS_LOG_INFO(m_estimate);
+        if (m_stopSimulation)
+        {
+            Simulator::Stop();
+        }
+    }
+}
+
+std::ostream&
+operator<<(std::ostream& os, const AqmSteadyStateMonitor::Estimate& estimate)
+{
+    if (!estimate.steady)
+    {
+        os << "No steady state";
+        return os;
+    }
+    os << "Steady state from " << estimate.start.As(Time::S) << " to "
+       << estimate.end.As(Time::S) << ": queue " << estimate.queue << " packets, probability "
+       << estimate.probability << ", goodput " << estimate.goodput / 1e6 << " Mbps";
+    return os;
+}
+
+} // namespace ns3
@@ -0,0 +1,190 @@
+#ifndef AQM_STEADY_STATE_MONITOR_H
+#define AQM_STEADY_STATE_MONITOR_H
+
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <cstdint>
+#include <ostream>
+
+namespace ns3
+{
+
+class QueueDisc;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Detection of the steady state of an AQM, to end runs once they
+ * stop telling anything new
+ *
+ * The time is cut into windows of Window, each closed into means of the
+ * queue length, of the congestion-signal probability (packets dropped or
+ * marked over packets received by the queue disc in the window) and of the
+ * aggregate goodput (bytes passed to Delivered, typically from the
+ * PacketSink Rx traces). A window agrees with the run of windows before it when each of
+ * its three means is within Tolerance, relative, of the mean of that run,
+ * or within a small absolute resolution (half a packet, a probability of
+ * 0.001) for values near zero; a window that does not agree starts a new
+ * run. Once a run has lasted HoldTime, the system is deemed steady from
+ * the start of the run: the means of the run are kept as the steady-state
+ * values and, with StopSimulation, the simulator is stopped.
+ *
+ * Windows are judged from StartTime to EndTime, which should frame the
+ * time the senders are active.
+ *
+ * The monitor schedules no event of its own. It follows the PacketsInQueue
+ * trace of the queue disc, so the mean queue length is integrated exactly
+ * over time, and a window is closed at its boundary by the first queue
+ * change or delivery after it. The drop, mark and arrival counters of the
+ * queue disc are those read at the event before, so the event closing a
+ * window counts towards the next one. Windows without any event, during
+ * which the link was idle, are skipped rather than judged, and the idle
+ * gap ends the current run.
+ *
+ * Only the open window and the running sums of the current run are kept,
+ * so the memory does not grow with the simulated time.
+ */
+class AqmSteadyStateMonitor : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AqmSteadyStateMonitor();
+    ~AqmSteadyStateMonitor() override;
+
+    /**
+     * @brief Steady-state values of the monitored queue disc
+     */
+    struct Estimate
+    {
+        bool steady{false};     //!< True once a run of agreeing windows lasted HoldTime
+        Time start;             //!< Start of that run
+        Time end;               //!< Time the steady state was declared
+        double queue{0};        //!< Mean queue length (packets)
+        double probability{0};  //!< Fraction of the arrivals dropped or marked
+        double goodput{0};      //!< Aggregate goodput (bit/s)
+    };
+
+    /**
+     * @brief Follow the queue length of a queue disc, the first window
+     * opening at StartTime
+     * @param queueDisc the monitored queue disc
+     */
+    void Start(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Count delivered bytes towards the goodput, with the signature
+     * of the PacketSink Rx trace
+     * @param packet the delivered packet
+     * @param from the sender
+     */
+    void Delivered(Ptr<const Packet> packet, const Address& from);
+
+    /**
+     * @return the steady-state values, valid if steady is set
+     */
+    const Estimate& GetEstimate() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief PacketsInQueue trace sink
+     * @param oldValue the previous queue length
+     * @param newValue the new queue length
+     */
+    void QueueLengthChanged(uint32_t oldValue, uint32_t newValue);
+
+    /**
+     * @brief Bring the windows up to the current time: open the first one,
+     * close those whose boundary has passed and integrate the queue length
+     */
+    void Advance();
+
+    /**
+     * @brief Keep the arrival, drop and mark counters of the queue disc,
+     * which the next event will attribute to the open window
+     */
+    void ReadCounters();
+
+    /**
+     * @brief Add the queue length since the last change to the open window
+     * @param now the end of the period
+     */
+    void Integrate(Time now);
+
+    /**
+     * @brief Open a window
+     * @param start the start of the window
+     */
+    void OpenWindow(Time start);
+
+    /**
+     * @brief Close the open window and compare it with the current run
+     * @param end the end of the window
+     */
+    void CloseWindow(Time end);
+
+    /**
+     * @brief Tell whether a window mean agrees with the mean of the run
+     * @param value the window mean
+     * @param reference the mean of the run
+     * @param resolution the difference always deemed steady
+     * @return true if they agree
+     */
+    bool Agrees(double value, double reference, double resolution) const;
+
+    Time m_window;         //!< Averaging window
+    Time m_holdTime;       //!< Time the means must hold steady
+    Time m_startTime;      //!< Time the first window opens
+    Time m_endTime;        //!< Time after which no window closes, zero for none
+    double m_tolerance;    //!< Relative tolerance between a window and its run
+    bool m_stopSimulation; //!< True to stop the simulator once steady
+
+    Ptr<QueueDisc> m_queueDisc; //!< Monitored queue disc
+    uint64_t m_delivered;       //!< Bytes delivered since the start
+    uint32_t m_length;          //!< Queue length since m_lastChange (packets)
+    uint64_t m_arrivals;        //!< Packets received by the queue disc at the last event
+    uint64_t m_signals;         //!< Packets dropped or marked at the last event
+    Time m_lastChange;          //!< Last integration of the queue length
+    bool m_open;                //!< True once the first window is open
+    bool m_done;                //!< True once steady or past EndTime
+
+    // Open window, or the first one before it opens
+    Time m_windowStart;          //!< Start of the window
+    double m_queueArea;          //!< Queue length integrated over the window (packet s)
+    uint64_t m_windowArrivals;   //!< Packets received by the queue disc at the start
+    uint64_t m_windowSignals;    //!< Packets dropped or marked at the start
+    uint64_t m_windowDelivered;  //!< Bytes delivered at the start
+
+    // Current run of agreeing windows
+    Time m_runStart;      //!< Start of the run
+    uint32_t m_runLength; //!< Windows in the run
+    double m_runQueue;    //!< Sum of the window queue means
+    double m_runProb;     //!< Sum of the window probabilities
+    double m_runGoodput;  //!< Sum of the window goodputs
+
+    Estimate m_estimate; //!< Steady-state values
+};
+
+/**
+ * @brief Stream insertion operator.
+ *
+ * @param os the reference to the output stream
+ * @param estimate the steady-state values
+ * @return the reference to the output stream
+ */
+std::ostream& operator<<(std::ostream& os, const AqmSteadyStateMonitor::Estimate& estimate);
+
+} // namespace ns3
+
+#endif // AQM_STEADY_STATE_MONITOR_H
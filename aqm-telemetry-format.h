@@ -0,0 +1,71 @@
+#ifndef AQM_TELEMETRY_FORMAT_H
+#define AQM_TELEMETRY_FORMAT_H
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @file
+ * @ingroup traffic-control
+ * Layout of the shared-memory segment written by AqmTelemetry.
+ *
+ * This header does not depend on ns-3, so that readers can be built
+ * without it. The segment is an AqmTelemetryHeader followed by
+ * `capacity` AqmTelemetryRecord slots used as a ring. There is a single
+ * producer; every slot is protected by a sequence number, so readers never
+ * block the simulation and detect slots overwritten while being copied.
+ */
+
+namespace ns3
+{
+
+/// Magic number at the start of the segment ("AQMTELE2")
+constexpr uint64_t AQM_TELEMETRY_MAGIC = 0x32454c45544d5141ULL;
+/// Maximum number of distinct drop and mark reasons tracked per segment
+constexpr uint32_t AQM_TELEMETRY_MAX_REASONS = 8;
+/// Maximum length of a reason name, including the terminating null
+constexpr uint32_t AQM_TELEMETRY_REASON_LEN = 32;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "AQM telemetry needs address-free 64 bit atomics");
+
+/**
+ * @brief One sample of the AQM state
+ *
+ * The producer sets seq to 2 i + 1 before it writes sample i into the slot
+ * and to 2 i + 2 once it is complete. A reader that sees the same even
+ * value before and after copying the fields got a consistent sample.
+ */
+struct AqmTelemetryRecord
+{
+    std::atomic<uint64_t> seq; //!< Sequence number of the slot
+    double time;               //!< Simulation time of the sample (s)
+    uint32_t packets;          //!< Instantaneous queue length (packets)
+    uint32_t bytes;            //!< Instantaneous queue length (bytes)
+    double queueAverage;       //!< Average queue length (RED family), else 0
+    double dropProbability;    //!< Current drop probability
+    double markProbability;    //!< Current mark probability
+    uint64_t drops;            //!< Total dropped packets
+    uint64_t marks;            //!< Total marked packets
+    uint64_t byReason[AQM_TELEMETRY_MAX_REASONS]; //!< Drops and marks per header reason
+};
+
+/**
+ * @brief Header of the shared-memory segment
+ */
+struct AqmTelemetryHeader
+{
+    uint64_t magic;         //!< AQM_TELEMETRY_MAGIC
+    uint32_t recordSize;    //!< sizeof (AqmTelemetryRecord)
+    uint32_t capacity;      //!< Number of record slots
+    char queueDiscType[64]; //!< TypeId name of the monitored queue disc
+    std::atomic<uint32_t> nReasons; //!< Number of valid reason names
+    std::atomic<uint32_t> finished; //!< Set to 1 when the producer is done
+    char reasons[AQM_TELEMETRY_MAX_REASONS][AQM_TELEMETRY_REASON_LEN]; //!< Reason names
+    std::atomic<uint64_t> written; //!< Number of samples published so far
+    std::atomic<uint32_t> attached; //!< Number of readers that mapped the segment
+};
+
+} // namespace ns3
+
+#endif // AQM_TELEMETRY_FORMAT_H
@@ -0,0 +1,243 @@
+#include "aqm-telemetry.h"
+
+#include "blue-queue-disc.h"
+#include "queue-disc.h"
+#include "red-queue-disc.h"
+
+#include "ns3/boolean.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("AqmTelemetry");
+
+NS_OBJECT_ENSURE_REGISTERED(AqmTelemetry);
+
+TypeId
+AqmTelemetry::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::AqmTelemetry")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<AqmTelemetry>()
+            .AddAttribute("SegmentName",
+                          "Name of the POSIX shared-memory segment, starting with '/'",
+                          StringValue("/ns3-aqm-telemetry"),
+                          MakeStringAccessor(&AqmTelemetry::m_segmentName),
+                          MakeStringChecker())
+            .AddAttribute("Interval",
+                          "Simulation time between two samples",
+                          TimeValue(MilliSeconds(10)),
+                          MakeTimeAccessor(&AqmTelemetry::m_interval),
+                          MakeTimeChecker())
+            .AddAttribute("Capacity",
+                          "Number of samples kept in the ring",
+                          UintegerValue(4096),
+                          MakeUintegerAccessor(&AqmTelemetry::m_capacity),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Readers",
+                          "Readers expected to attach; the segment name is unlinked once they "
+                          "have, or when publishing stops (0 to wait for the stop)",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&AqmTelemetry::m_readers),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+AqmTelemetry::AqmTelemetry()
+    : m_useEcn(false),
+      m_header(nullptr),
+      m_records(nullptr),
+      m_mappedSize(0),
+      m_linked(false)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+AqmTelemetry::~AqmTelemetry()
+{
+    NS_LOG_FUNCTION(this);
+    Unmap();
+}
+
+void
+AqmTelemetry::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Stop();
+    Unmap();
+    m_queueDisc = nullptr;
+    m_red = nullptr;
+    m_blue = nullptr;
+    Object::DoDispose();
+}
+
+void
+AqmTelemetry::Start(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    NS_ABORT_MSG_IF(m_header, "AqmTelemetry already started");
+
+    m_queueDisc = queueDisc;
+    m_red = DynamicCast<RedQueueDisc>(queueDisc);
+    m_blue = DynamicCast<BlueQueueDisc>(queueDisc);
+    if (m_red)
+    {
+        BooleanValue useEcn;
+        m_red->GetAttribute("UseEcn", useEcn);
+        m_useEcn = useEcn.Get();
+    }
+
+    // Start from a fresh segment, readers of a previous run keep their mapping
+    shm_unlink(m_segmentName.c_str());
+    int fd = shm_open(m_segmentName.c_str(), O_CREAT | O_RDWR, 0644);
+    NS_ABORT_MSG_IF(fd < 0, "Cannot create shared-memory segment " << m_segmentName);
+    m_mappedSize = sizeof(AqmTelemetryHeader) + m_capacity * sizeof(AqmTelemetryRecord);
+    NS_ABORT_MSG_IF(ftruncate(fd, m_mappedSize) != 0,
+                    "Cannot size shared-memory segment " << m_segmentName);
+    void* base = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    NS_ABORT_MSG_IF(base == MAP_FAILED, "Cannot map shared-memory segment " << m_segmentName);
+    m_linked = true;
+
+    // ftruncate zero-fills the segment, which is a valid initial state for
+    // the atomics; the magic is written last so readers see a complete header
+    m_header = static_cast<AqmTelemetryHeader*>(base);
+    m_records = reinterpret_cast<AqmTelemetryRecord*>(m_header + 1);
+    m_header->recordSize = sizeof(AqmTelemetryRecord);
+    m_header->capacity = m_capacity;
+    std::strncpy(m_header->queueDiscType,
+                 queueDisc->GetInstanceTypeId().GetName().c_str(),
+                 sizeof(m_header->queueDiscType) - 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = AQM_TELEMETRY_MAGIC;
+
+    m_event = Simulator::ScheduleNow(&AqmTelemetry::Publish, this);
+    Simulator::ScheduleDestroy(&AqmTelemetry::Stop, Ptr<AqmTelemetry>(this));
+}
+
+void
+AqmTelemetry::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_event.Cancel();
+    if (m_header)
+    {
+        m_header->finished.store(1, std::memory_order_release);
+    }
+    Unlink();
+}
+
+void
+AqmTelemetry::Unlink()
+{
+    if (m_linked)
+    {
+        NS_LOG_LOGIC("Unlinking " << m_segmentName);
+        shm_unlink(m_segmentName.c_str());
+        m_linked = false;
+    }
+}
+
+void
+AqmTelemetry::Unmap()
+{
+    if (m_header)
+    {
+        munmap(m_header, m_mappedSize);
+        m_header = nullptr;
+        m_records = nullptr;
+    }
+}
+
+uint32_t
+AqmTelemetry::GetReasonIndex(const std::string& reason)
+{
+    auto it = m_reasonIndex.find(reason);
+    if (it != m_reasonIndex.end())
+    {
+        return it->second;
+    }
+    uint32_t n = m_header->nReasons.load(std::memory_order_relaxed);
+    if (n == AQM_TELEMETRY_MAX_REASONS)
+    {
+        NS_LOG_WARN("No telemetry slot left for reason " << reason);
+        m_reasonIndex[reason] = n;
+        return n;
+    }
+    std::strncpy(m_header->reasons[n], reason.c_str(), AQM_TELEMETRY_REASON_LEN - 1);
+    m_header->nReasons.store(n + 1, std::memory_order_release);
+    m_reasonIndex[reason] = n;
+    return n;
+}
+
+void
+AqmTelemetry::Publish()
+{
+    NS_LOG_FUNCTION(this);
+
+    const QueueDisc::Stats& stats = m_queueDisc->GetStats();
+    uint64_t index = m_header->written.load(std::memory_order_relaxed);
+    AqmTelemetryRecord& r = m_records[index % m_capacity];
+
+    r.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    r.time = Simulator::Now().GetSeconds();
+    r.packets = m_queueDisc->GetNPackets();
+    r.bytes = m_queueDisc->GetNBytes();
+    r.queueAverage = 0;
+    r.dropProbability = 0;
+    r.markProbability = 0;
+    if (m_red)
+    {
+        double p = m_red->GetDropProbability();
+        r.queueAverage = m_red->GetQueueAverage();
+        r.dropProbability = m_useEcn ? 0 : p;
+        r.markProbability = m_useEcn ? p : 0;
+    }
+    else if (m_blue)
+    {
+        r.dropProbability = m_blue->GetDropProbability();
+    }
+    r.drops = stats.nTotalDroppedPackets;
+    r.marks = stats.nTotalMarkedPackets;
+    std::memset(r.byReason, 0, sizeof(r.byReason));
+    for (const auto* counts : {&stats.nDroppedPacketsBeforeEnqueue,
+                               &stats.nDroppedPacketsAfterDequeue,
+                               &stats.nMarkedPackets})
+    {
+        for (const auto& [reason, count] : *counts)
+        {
+            uint32_t slot = GetReasonIndex(reason);
+            if (slot < AQM_TELEMETRY_MAX_REASONS)
+            {
+                r.byReason[slot] += count;
+            }
+        }
+    }
+
+    r.seq.store(2 * index + 2, std::memory_order_release);
+    m_header->written.store(index + 1, std::memory_order_release);
+
+    if (m_linked && m_readers > 0 &&
+        m_header->attached.load(std::memory_order_acquire) >= m_readers)
+    {
+        // The readers hold their own mapping, the name is no longer needed
+        Unlink();
+    }
+
+    m_event = Simulator::Schedule(m_interval, &AqmTelemetry::Publish, this);
+}
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+#ifndef AQM_TELEMETRY_H
+#define AQM_TELEMETRY_H
+
+#include "aqm-telemetry-format.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+
+#include <map>
+#include <string>
+
+namespace ns3
+{
+
+class QueueDisc;
+class RedQueueDisc;
+class BlueQueueDisc;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Live feed of the state of a queue disc through POSIX shared memory
+ *
+ * Every Interval of simulation time, the queue length, the RED average
+ * queue, the drop and mark probabilities and the drop and mark counts by
+ * reason are written into a ring of records in the shared-memory segment
+ * SegmentName (see aqm-telemetry-format.h). Publishing is a few stores
+ * into the mapped segment; the simulation never waits for readers and does
+ * no file I/O. aqm_telemetry_reader tails the segment from another process.
+ *
+ * Readers count themselves in the header when they map the segment. Once
+ * Readers of them have attached, or at the latest when publishing stops,
+ * the segment name is unlinked: the attached readers keep their mapping
+ * and no segment is left behind after the run.
+ */
+class AqmTelemetry : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    AqmTelemetry();
+    ~AqmTelemetry() override;
+
+    /**
+     * @brief Create the segment and start publishing samples of a queue disc
+     * @param queueDisc the monitored queue disc
+     */
+    void Start(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Stop publishing and tell the readers the run is over
+     */
+    void Stop();
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief Write one sample and schedule the next one
+     */
+    void Publish();
+
+    /**
+     * @brief Get the header slot of a drop or mark reason, registering it if new
+     * @param reason the reason name
+     * @return the slot, or AQM_TELEMETRY_MAX_REASONS if all slots are taken
+     */
+    uint32_t GetReasonIndex(const std::string& reason);
+
+    /**
+     * @brief Unmap the segment
+     */
+    void Unmap();
+
+    /**
+     * @brief Remove the segment name, if not done yet
+     */
+    void Unlink();
+
+    std::string m_segmentName; //!< Name of the shared-memory segment
+    Time m_interval;           //!< Simulation time between samples
+    uint32_t m_capacity;       //!< Number of ring slots
+    uint32_t m_readers;        //!< Readers expected to attach before unlinking
+
+    Ptr<QueueDisc> m_queueDisc; //!< Monitored queue disc
+    Ptr<RedQueueDisc> m_red;    //!< Monitored queue disc, if of the RED family
+    Ptr<BlueQueueDisc> m_blue;  //!< Monitored queue disc, if BLUE
+    bool m_useEcn;              //!< True if RED marks instead of dropping
+    EventId m_event;            //!< Next publication
+    AqmTelemetryHeader* m_header;  //!< Mapped segment header
+    AqmTelemetryRecord* m_records; //!< Mapped ring slots
+    std::size_t m_mappedSize;      //!< Size of the mapping
+    bool m_linked;                 //!< True while the segment name exists
+    std::map<std::string, uint32_t> m_reasonIndex; //!< Header slot of each reason
+};
+
+} // namespace ns3
+
+#endif // AQM_TELEMETRY_H
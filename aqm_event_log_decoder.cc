@@ -0,0 +1,160 @@
+#include "ns3/aqm-event-log-format.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Name of the reason of a record.
+ *
+ * \param header The log header.
+ * \param r The record.
+ * \return The reason name, "-" for probability updates.
+ */
+std::string
+ReasonName(const AqmEventLogHeader& header, const AqmEventRecord& r)
+{
+    if (r.reason == AQM_EVENT_NO_REASON)
+    {
+        return "-";
+    }
+    if (r.reason < header.nReasons)
+    {
+        return header.reasons[r.reason];
+    }
+    return "reason " + std::to_string(r.reason);
+}
+
+/**
+ * Decode an AqmEventLog file, printing one line per event or, with
+ * --summary, the events by type and reason and the flows with the most
+ * drops and marks.
+ */
+int
+main(int argc, char* argv[])
+{
+    std::string fileName;
+    bool summary = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help")
+        {
+            std::cout << "Usage: " << argv[0] << " [--summary] <event log>" << std::endl;
+            return 0;
+        }
+        if (arg == "--summary")
+        {
+            summary = true;
+        }
+        else
+        {
+            fileName = arg;
+        }
+    }
+    if (fileName.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--summary] <event log>" << std::endl;
+        return 1;
+    }
+
+    std::FILE* file = std::fopen(fileName.c_str(), "rb");
+    if (!file)
+    {
+        std::cerr << "Cannot open " << fileName << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    AqmEventLogHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || header.magic != AQM_EVENT_LOG_MAGIC ||
+        header.recordSize != sizeof(AqmEventRecord))
+    {
+        std::cerr << fileName << " is not an AQM event log of this build" << std::endl;
+        return 1;
+    }
+    if (!header.closed)
+    {
+        std::cerr << fileName << " was not closed, reading up to the end of the file" << std::endl;
+    }
+
+    static const char* typeNames[] = {"drop", "mark", "prob"};
+    std::map<std::pair<uint8_t, std::string>, uint64_t> byReason;
+    std::unordered_map<uint32_t, uint64_t> byFlow;
+    uint64_t n = 0;
+    double first = 0;
+    double last = 0;
+
+    if (!summary)
+    {
+        std::cout << "# " << header.queueDiscType << '\n';
+        std::cout << "# time type reason flow queue probability\n";
+    }
+    std::vector<AqmEventRecord> block(1 << 16);
+    std::size_t got;
+    while ((got = std::fread(block.data(), sizeof(AqmEventRecord), block.size(), file)) > 0)
+    {
+        for (std::size_t i = 0; i < got; ++i)
+        {
+            const AqmEventRecord& r = block[i];
+            double time = r.time * 1e-9;
+            const char* type = r.type <= AQM_EVENT_PROBABILITY ? typeNames[r.type] : "?";
+            if (n++ == 0)
+            {
+                first = time;
+            }
+            last = time;
+            if (summary)
+            {
+                byReason[{r.type, ReasonName(header, r)}]++;
+                if (r.type != AQM_EVENT_PROBABILITY)
+                {
+                    byFlow[r.flowHash]++;
+                }
+                continue;
+            }
+            std::cout << std::fixed << std::setprecision(9) << time << " " << type << " \""
+                      << ReasonName(header, r) << "\" " << std::hex << std::setw(8)
+                      << std::setfill('0') << r.flowHash << std::dec << std::setfill(' ') << " "
+                      << r.queueLength << " " << std::setprecision(6) << r.probability << '\n';
+        }
+    }
+    std::fclose(file);
+
+    if (header.closed && header.nRecords != n)
+    {
+        std::cerr << "Header announces " << header.nRecords << " records, read " << n << std::endl;
+    }
+    if (!summary)
+    {
+        return 0;
+    }
+
+    std::cout << header.queueDiscType << ": " << n << " events from " << first << " s to " << last
+              << " s\n";
+    for (const auto& [key, count] : byReason)
+    {
+        const char* type = key.first <= AQM_EVENT_PROBABILITY ? typeNames[key.first] : "?";
+        std::cout << "  " << std::setw(10) << count << "  " << type << "  " << key.second << '\n';
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> flows;
+    for (const auto& [hash, count] : byFlow)
+    {
+        flows.emplace_back(count, hash);
+    }
+    std::sort(flows.rbegin(), flows.rend());
+    std::cout << flows.size() << " flows dropped or marked, most hit:\n";
+    for (std::size_t i = 0; i < flows.size() && i < 10; ++i)
+    {
+        std::cout << "  " << std::setw(10) << flows[i].first << "  " << std::hex << std::setw(8)
+                  << std::setfill('0') << flows[i].second << std::dec << std::setfill(' ') << '\n';
+    }
+    return 0;
+}
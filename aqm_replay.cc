@@ -0,0 +1,212 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("AqmReplayTool");
+
+/**
+ * Expand a "lo:hi:n" grid specification into n evenly spaced values.
+ * A single number yields a one-point grid.
+ *
+ * \param spec The grid specification.
+ * \return The grid values.
+ */
+std::vector<double>
+ParseGrid(const std::string& spec)
+{
+    std::vector<double> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':'))
+    {
+        fields.push_back(std::stod(field));
+    }
+    if (fields.size() == 1)
+    {
+        return fields;
+    }
+    NS_ABORT_MSG_IF(fields.size() != 3, "Grid must be a number or lo:hi:n, got " << spec);
+
+    std::vector<double> values;
+    auto n = static_cast<uint32_t>(fields[2]);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        values.push_back(n == 1 ? fields[0] : fields[0] + (fields[1] - fields[0]) * i / (n - 1));
+    }
+    return values;
+}
+
+/**
+ * Replay an arrival trace captured by final_testing_script --captureArrivals
+ * through RED, DSRED and BLUE parameter grids, open loop, and print one CSV
+ * line per configuration.
+ *
+ * The queue disc limit and the link rate default to those of the trace.
+ * With --batch the grid runs through the SIMD lanes of AqmBatchReplay,
+ * which share their random numbers and count the queues from their work.
+ */
+int
+main(int argc, char* argv[])
+{
+    std::string traceFile = "aqm-arrivals.bin";
+    std::string queueDiscType = "RED";
+    uint32_t queueDiscLimitPackets = 0;
+    std::string linkRate;
+    uint32_t pktSize = 512;
+    bool useEcn = false;
+    std::string minThGrid = "2:20:10";
+    std::string maxThGrid = "10:60:11";
+    std::string midThGrid = "5:40:8";
+    std::string gammaGrid = "0.1:0.9:5";
+    std::string incrementGrid = "0.005:0.05:10";
+    std::string decrementGrid = "0.0005:0.005:10";
+    std::string freezeTimeGrid = "0.01:0.2:5";
+    uint64_t seed = 1;
+    bool batch = false;
+    std::string outputFile;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("traceFile", "Arrival trace to replay", traceFile);
+    cmd.AddValue("queueDiscType", "Queue disc to replay: RED, DSRED or Blue", queueDiscType);
+    cmd.AddValue("queueDiscLimitPackets",
+                 "Max packets allowed in the queue disc (0 for the captured limit)",
+                 queueDiscLimitPackets);
+    cmd.AddValue("linkRate", "Rate draining the queue (empty for the captured rate)", linkRate);
+    cmd.AddValue("appPktSize", "Mean packet size RED uses for idle periods", pktSize);
+    cmd.AddValue("useEcn", "Mark ECN-capable packets instead of dropping them", useEcn);
+    cmd.AddValue("redMinTh", "RED minimum threshold grid (lo:hi:n)", minThGrid);
+    cmd.AddValue("redMaxTh", "RED maximum threshold grid (lo:hi:n)", maxThGrid);
+    cmd.AddValue("redMidTh", "DSRED middle threshold grid (lo:hi:n)", midThGrid);
+    cmd.AddValue("gamma", "DSRED gamma grid (lo:hi:n)", gammaGrid);
+    cmd.AddValue("blueIncrement", "BLUE increment grid (lo:hi:n)", incrementGrid);
+    cmd.AddValue("blueDecrement", "BLUE decrement grid (lo:hi:n)", decrementGrid);
+    cmd.AddValue("blueFreezeTime", "BLUE freeze time grid in seconds (lo:hi:n)", freezeTimeGrid);
+    cmd.AddValue("seed", "Seed of the early-drop random numbers", seed);
+    cmd.AddValue("batch", "Replay the configurations in lockstep SIMD lanes", batch);
+    cmd.AddValue("outputFile", "CSV file for all points (stdout if empty)", outputFile);
+    cmd.Parse(argc, argv);
+
+    if ((queueDiscType != "RED") && (queueDiscType != "DSRED") && (queueDiscType != "Blue"))
+    {
+        std::cout << "Invalid queue disc type: Use --queueDiscType=RED or --queueDiscType=DSRED or "
+                     "--queueDiscType=Blue"
+                  << std::endl;
+        exit(1);
+    }
+
+    // The limit of the trace is needed before building the grid
+    std::ifstream in(traceFile, std::ios::binary);
+    AqmArrivalTraceHeader header;
+    NS_ABORT_MSG_IF(!in.read(reinterpret_cast<char*>(&header), sizeof(header)),
+                    "Cannot read " << traceFile);
+    in.close();
+    if (queueDiscLimitPackets == 0)
+    {
+        NS_ABORT_MSG_IF(header.maxSizeBytes,
+                        "The captured limit is in bytes, give --queueDiscLimitPackets");
+        queueDiscLimitPackets = header.maxSize;
+    }
+
+    AqmReplay::Config base;
+    base.limit = queueDiscLimitPackets;
+    base.meanPktSize = pktSize;
+    base.useEcn = useEcn;
+
+    std::vector<AqmReplay::Config> points;
+    if (queueDiscType == "Blue")
+    {
+        base.algorithm = AqmReplay::BLUE;
+        for (double inc : ParseGrid(incrementGrid))
+        {
+            for (double dec : ParseGrid(decrementGrid))
+            {
+                for (double freeze : ParseGrid(freezeTimeGrid))
+                {
+                    AqmReplay::Config c = base;
+                    c.increment = inc;
+                    c.decrement = dec;
+                    c.freezeTime = freeze;
+                    points.push_back(c);
+                }
+            }
+        }
+    }
+    else
+    {
+        base.algorithm = (queueDiscType == "DSRED") ? AqmReplay::DSRED : AqmReplay::RED;
+        std::vector<double> mids = ParseGrid(midThGrid);
+        std::vector<double> gammas = ParseGrid(gammaGrid);
+        if (base.algorithm == AqmReplay::RED)
+        {
+            mids = {base.midTh};
+            gammas = {base.gamma};
+        }
+        for (double minTh : ParseGrid(minThGrid))
+        {
+            for (double maxTh : ParseGrid(maxThGrid))
+            {
+                for (double midTh : mids)
+                {
+                    for (double gamma : gammas)
+                    {
+                        bool ordered = (base.algorithm == AqmReplay::DSRED)
+                                           ? (minTh < midTh && midTh < maxTh)
+                                           : (minTh < maxTh);
+                        if (!ordered)
+                        {
+                            continue;
+                        }
+                        AqmReplay::Config c = base;
+                        c.minTh = minTh;
+                        c.maxTh = maxTh;
+                        c.midTh = midTh;
+                        c.gamma = gamma;
+                        points.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+
+    uint64_t rate = linkRate.empty() ? 0 : DataRate(linkRate).GetBitRate();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<AqmReplay::Result> results =
+        batch ? AqmBatchReplay::Run(traceFile, header, rate, points, seed)
+              : AqmReplay::Run(traceFile, header, rate, points, seed);
+    double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream file;
+    if (!outputFile.empty())
+    {
+        file.open(outputFile, std::ios::out);
+    }
+    std::ostream& out = outputFile.empty() ? std::cout : file;
+    out << "minTh,maxTh,midTh,gamma,increment,decrement,freezeTime,"
+        << "arrivals,drops,marks,meanQueue,maxQueue,meanDelay,utilisation,meanDropProb"
+        << std::endl;
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        const AqmReplay::Config& c = points[i];
+        const AqmReplay::Result& r = results[i];
+        out << c.minTh << "," << c.maxTh << "," << c.midTh << "," << c.gamma << ","
+            << c.increment << "," << c.decrement << "," << c.freezeTime << "," << r.arrivals
+            << "," << r.drops << "," << r.marks << "," << r.meanQueue << "," << r.maxQueue << ","
+            << r.meanDelay << "," << r.utilisation << "," << r.meanDropProb << std::endl;
+    }
+
+    uint64_t arrivals = results.empty() ? 0 : results[0].arrivals;
+    std::cerr << "Replayed " << arrivals << " arrivals of " << header.queueDiscType << " at "
+              << rate << " bit/s through " << points.size() << " configurations in " << elapsed
+              << " s (" << (elapsed > 0 ? arrivals * points.size() / elapsed : 0)
+              << " decisions per second)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "ns3/aqm-telemetry-format.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace ns3;
+
+/**
+ * Map a telemetry segment, waiting for the simulation to create it, and
+ * count the reader as attached so the simulation can unlink the segment.
+ *
+ * \param name The segment name.
+ * \param size Set to the size of the mapping.
+ * \return The segment header.
+ */
+AqmTelemetryHeader*
+MapSegment(const std::string& name, std::size_t& size)
+{
+    bool waiting = false;
+    while (true)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        struct stat st;
+        if (fd >= 0 && fstat(fd, &st) == 0 &&
+            static_cast<std::size_t>(st.st_size) >= sizeof(AqmTelemetryHeader))
+        {
+            size = st.st_size;
+            void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if (base == MAP_FAILED)
+            {
+                std::cerr << "Cannot map " << name << ": " << std::strerror(errno) << std::endl;
+                exit(1);
+            }
+            auto header = static_cast<AqmTelemetryHeader*>(base);
+            if (header->magic == AQM_TELEMETRY_MAGIC)
+            {
+                std::atomic_thread_fence(std::memory_order_acquire);
+                header->attached.fetch_add(1, std::memory_order_release);
+                return header;
+            }
+            munmap(base, size);
+        }
+        else if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (!waiting)
+        {
+            std::cerr << "Waiting for " << name << std::endl;
+            waiting = true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+/**
+ * Copy a ring slot, checking it holds a complete copy of the expected sample.
+ *
+ * \param slot The ring slot.
+ * \param index The expected sample index.
+ * \param out The copy.
+ * \return True if the copy is consistent.
+ */
+bool
+ReadSlot(const AqmTelemetryRecord& slot, uint64_t index, AqmTelemetryRecord& out)
+{
+    uint64_t before = slot.seq.load(std::memory_order_acquire);
+    if (before != 2 * index + 2)
+    {
+        return false;
+    }
+    std::memcpy(static_cast<void*>(&out), &slot, sizeof(AqmTelemetryRecord));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.seq.load(std::memory_order_relaxed) == before;
+}
+
+/**
+ * Tail the shared-memory feed of an AqmTelemetry publisher and print one
+ * line per sample. Exits when the simulation stops publishing.
+ */
+int
+main(int argc, char* argv[])
+{
+    std::string name = argc > 1 ? argv[1] : "/ns3-aqm-telemetry";
+    int pollMs = argc > 2 ? std::atoi(argv[2]) : 50;
+    if (name == "-h" || name == "--help")
+    {
+        std::cout << "Usage: " << argv[0] << " [segment name] [poll interval (ms)]" << std::endl;
+        return 0;
+    }
+
+    std::size_t size = 0;
+    AqmTelemetryHeader* header = MapSegment(name, size);
+    if (header->recordSize != sizeof(AqmTelemetryRecord) ||
+        size < sizeof(AqmTelemetryHeader) + header->capacity * sizeof(AqmTelemetryRecord))
+    {
+        std::cerr << "Segment " << name << " has an unexpected layout" << std::endl;
+        return 1;
+    }
+    auto records = reinterpret_cast<const AqmTelemetryRecord*>(header + 1);
+    std::cout << "# " << header->queueDiscType << std::endl;
+
+    uint32_t nReasonsPrinted = 0;
+    uint64_t cursor = 0;
+    uint64_t lost = 0;
+    while (true)
+    {
+        bool finished = header->finished.load(std::memory_order_acquire);
+        uint64_t written = header->written.load(std::memory_order_acquire);
+
+        uint32_t nReasons = header->nReasons.load(std::memory_order_acquire);
+        if (nReasons != nReasonsPrinted)
+        {
+            std::cout << "# time packets bytes qAvg pDrop pMark drops marks";
+            for (uint32_t i = 0; i < nReasons; ++i)
+            {
+                std::cout << " \"" << header->reasons[i] << "\"";
+            }
+            std::cout << std::endl;
+            nReasonsPrinted = nReasons;
+        }
+
+        if (written - cursor > header->capacity)
+        {
+            lost += written - header->capacity - cursor;
+            cursor = written - header->capacity;
+        }
+        for (; cursor < written; ++cursor)
+        {
+            AqmTelemetryRecord r;
+            if (!ReadSlot(records[cursor % header->capacity], cursor, r))
+            {
+                lost++; // overwritten while we were copying it
+                continue;
+            }
+            std::cout << std::fixed << std::setprecision(3) << r.time << " " << r.packets << " "
+                      << r.bytes << " " << std::setprecision(2) << r.queueAverage << " "
+                      << std::setprecision(5) << r.dropProbability << " " << r.markProbability
+                      << " " << r.drops << " " << r.marks;
+            for (uint32_t i = 0; i < nReasonsPrinted; ++i)
+            {
+                std::cout << " " << r.byReason[i];
+            }
+            std::cout << std::endl;
+        }
+
+        if (finished)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(pollMs));
+    }
+    if (lost > 0)
+    {
+        std::cerr << lost << " samples were overwritten before they could be read" << std::endl;
+    }
+    munmap(header, size);
+    return 0;
+}
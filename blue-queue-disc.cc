@@ -1,9 +1,13 @@
 #include "blue-queue-disc.h"
+#include "aqm-drop-curves.h"
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/double.h"
 #include "ns3/drop-tail-queue.h"
 
+#include <cmath>
+
 namespace ns3 {
 
 // Define the logging component for BlueQueueDisc
@@ -12,6 +16,10 @@ NS_LOG_COMPONENT_DEFINE("BlueQueueDisc");
 // Ensure BlueQueueDisc is registered as an ns-3 object
 NS_OBJECT_ENSURE_REGISTERED(BlueQueueDisc);
 
+// Register the reasons once, so counting a drop is an array increment
+const uint16_t BlueQueueDisc::FORCED_DROP_ID = AqmReasons::Register(FORCED_DROP);
+const uint16_t BlueQueueDisc::PROB_DROP_ID = AqmReasons::Register(PROB_DROP);
+
 /**
  * Get the TypeId of the BlueQueueDisc class.
  * This function registers attributes and parent classes for ns-3 object model.
@@ -42,7 +50,23 @@ BlueQueueDisc::GetTypeId()
                       "Time interval between drop probability updates",
                       TimeValue(Seconds(0.1)),
                       MakeTimeAccessor(&BlueQueueDisc::m_freezeTime),
-                      MakeTimeChecker());
+                      MakeTimeChecker())
+        .AddAttribute("TraceDeadband",
+                      "Smallest change of the drop probability reported by the "
+                      "DropProbability trace source",
+                      DoubleValue(0.0),
+                      MakeDoubleAccessor(&BlueQueueDisc::m_traceDeadband),
+                      MakeDoubleChecker<double>(0.0, 1.0))
+        .AddAttribute("ProfileCycles",
+                      "True to count the calls of DoEnqueue and DoDequeue and the ticks spent "
+                      "in them (see GetEnqueueCycles)",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&BlueQueueDisc::m_profileCycles),
+                      MakeBooleanChecker())
+        .AddTraceSource("DropProbability",
+                        "Drop probability, reported when it changes by at least TraceDeadband",
+                        MakeTraceSourceAccessor(&BlueQueueDisc::m_dropProbTrace),
+                        "ns3::TracedValueCallback::Double");
 
     return tid;
 }
@@ -74,6 +98,9 @@ BlueQueueDisc::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_uv = nullptr;
+    m_queue = nullptr;
+    m_sharedBuffer = nullptr;
+    m_eventLog = nullptr;
     QueueDisc::DoDispose();
 }
 
@@ -97,6 +124,93 @@ BlueQueueDisc::GetDropProbability() const
     return m_dropProb;
 }
 
+/**
+ * Get the sojourn time histogram of the dequeued packets.
+ */
+const SojournHistogram&
+BlueQueueDisc::GetSojournHistogram() const
+{
+    return m_sojourn;
+}
+
+/**
+ * Get the ticks spent in DoEnqueue.
+ */
+const CycleAccount&
+BlueQueueDisc::GetEnqueueCycles() const
+{
+    return m_enqueueCycles;
+}
+
+/**
+ * Get the ticks spent in DoDequeue.
+ */
+const CycleAccount&
+BlueQueueDisc::GetDequeueCycles() const
+{
+    return m_dequeueCycles;
+}
+
+/**
+ * Get the hot-path counters.
+ */
+const BlueHotPathCounters&
+BlueQueueDisc::GetHotPathCounters() const
+{
+    return m_counters;
+}
+
+/**
+ * Register with a shared-buffer manager.
+ */
+void
+BlueQueueDisc::SetSharedBuffer(Ptr<SharedBufferManager> manager)
+{
+    NS_LOG_FUNCTION(this << manager);
+    m_sharedBuffer = manager;
+    m_sharedBufferPort = manager->Register(this);
+}
+
+/**
+ * Attach a binary event log.
+ */
+void
+BlueQueueDisc::SetEventLog(Ptr<AqmEventLog> log)
+{
+    NS_LOG_FUNCTION(this << log);
+    m_eventLog = log;
+}
+
+/**
+ * Drop a packet before enqueue and log the drop by reason ID.
+ */
+void
+BlueQueueDisc::DropBeforeEnqueue(Ptr<const QueueDiscItem> item, uint16_t reason)
+{
+    QueueDisc::DropBeforeEnqueue(item, AqmReasons::GetName(reason));
+    if (m_eventLog)
+    {
+        m_eventLog->Log(AQM_EVENT_DROP,
+                        reason,
+                        item->Hash(),
+                        GetCurrentSize().GetValue(),
+                        m_dropProb);
+    }
+}
+
+/**
+ * Print the drop probability and the sojourn time percentiles.
+ */
+void
+BlueQueueDisc::PrintAqmStats(std::ostream& os) const
+{
+    os << "Drop probability " << m_dropProb << std::endl;
+#ifdef NS3_AQM_COUNTERS
+    os << m_counters << std::endl;
+#endif
+    os << m_sojourn << std::endl;
+}
+
 /**
  * Enqueue a packet into the queue.
  * If the queue is full, it updates the drop probability and may drop the packet.
@@ -105,26 +219,36 @@ bool
 BlueQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
 {
     NS_LOG_FUNCTION(this << item);
+    CycleScope profile(m_profileCycles ? &m_enqueueCycles : nullptr);
+
+    if (m_sharedBuffer && !m_sharedBuffer->Admit(m_sharedBufferPort, item))
+    {
+        DropBeforeEnqueue(item, SharedBufferManager::ADMISSION_DROP_ID);
+        return false;
+    }
 
     QueueSize currentSize = GetCurrentSize();
     if (currentSize >= GetMaxSize())
     {
         UpdateDropProb(true);  // Overflow event
         double u = m_uv->GetValue();
+        AQM_COUNT(m_counters.rngComparisons);
         if (u <= m_dropProb)
         {
+            AQM_COUNT(m_counters.rngHits);
             NS_LOG_DEBUG("\t Dropping due to probability " << m_dropProb);
-            DropBeforeEnqueue(item, PROB_DROP);
+            DropBeforeEnqueue(item, PROB_DROP_ID);
             return false;
         }
         NS_LOG_DEBUG("\t Queue full, dropping packet");
-        DropBeforeEnqueue(item, FORCED_DROP);
+        DropBeforeEnqueue(item, FORCED_DROP_ID);
         return false;
     }
 
-    bool retval = GetInternalQueue(0)->Enqueue(item);
-    NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-    NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+    item->SetTimeStamp(Simulator::Now());
+    bool retval = m_queue->Enqueue(item);
+    NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+    NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
     return retval;
 }
@@ -139,7 +263,12 @@ BlueQueueDisc::InitializeParams()
     NS_LOG_INFO("Initializing BLUE params.");
 
     m_dropProb = 0.0;
+    m_dropProbTrace = 0.0;
     m_lastUpdate = NanoSeconds(0);
+    m_counters = BlueHotPathCounters();
+#ifdef NS3_AQM_COUNTERS
+    m_counters.enabled = true;
+#endif
 }
 
 /**
@@ -153,30 +282,47 @@ BlueQueueDisc::UpdateDropProb(bool overflow)
     Time now = Simulator::Now();
     if (now - m_lastUpdate < m_freezeTime)
     {
+        AQM_COUNT(m_counters.freezeRejections);
         return;  // Too soon to update
     }
 
     if (overflow)
     {
-        m_dropProb += m_increment;
-        if (m_dropProb > 1.0)
-        {
-            m_dropProb = 1.0;
-        }
+        AQM_COUNT(m_counters.increments);
+        m_dropProb = BlueIncrease(m_dropProb, m_increment);
     }
-    else if (GetInternalQueue(0)->IsEmpty())
+    else if (m_queue->IsEmpty())
     {
-        m_dropProb -= m_decrement;
-        if (m_dropProb < 0.0)
-        {
-            m_dropProb = 0.0;
-        }
+        AQM_COUNT(m_counters.decrements);
+        m_dropProb = BlueDecrease(m_dropProb, m_decrement);
     }
 
     m_lastUpdate = now;
+    UpdateTrace();
+    if (m_eventLog)
+    {
+        m_eventLog->Log(AQM_EVENT_PROBABILITY,
+                        AQM_EVENT_NO_REASON,
+                        0,
+                        GetCurrentSize().GetValue(),
+                        m_dropProb);
+    }
     NS_LOG_DEBUG("Updated drop probability: " << m_dropProb);
 }
 
+/**
+ * Report the drop probability to the trace sinks, skipping changes smaller
+ * than the deadband except the return to zero.
+ */
+void
+BlueQueueDisc::UpdateTrace()
+{
+    if (m_dropProb == 0.0 || std::fabs(m_dropProb - m_dropProbTrace.Get()) >= m_traceDeadband)
+    {
+        m_dropProbTrace = m_dropProb;
+    }
+}
+
 /**
  * Dequeue a packet from the queue.
  */
@@ -184,18 +330,20 @@ Ptr<QueueDiscItem>
 BlueQueueDisc::DoDequeue()
 {
     NS_LOG_FUNCTION(this);
+    CycleScope profile(m_profileCycles ? &m_dequeueCycles : nullptr);
 
-    if (GetInternalQueue(0)->IsEmpty())
+    if (m_queue->IsEmpty())
     {
         NS_LOG_LOGIC("Queue empty");
         UpdateDropProb(false);  // Underflow event
         return nullptr;
     }
 
-    Ptr<QueueDiscItem> item = GetInternalQueue(0)->Dequeue();
+    Ptr<QueueDiscItem> item = m_queue->Dequeue();
+    m_sojourn.Record(Simulator::Now() - item->GetTimeStamp());
     NS_LOG_LOGIC("Popped " << item);
-    NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-    NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+    NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+    NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
     return item;
 }
@@ -207,15 +355,15 @@ Ptr<const QueueDiscItem>
 BlueQueueDisc::DoPeek()
 {
     NS_LOG_FUNCTION(this);
-    if (GetInternalQueue(0)->IsEmpty())
+    if (m_queue->IsEmpty())
     {
         NS_LOG_LOGIC("Queue empty");
         return nullptr;
     }
 
-    Ptr<const QueueDiscItem> item = GetInternalQueue(0)->Peek();
-    NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-    NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+    Ptr<const QueueDiscItem> item = m_queue->Peek();
+    NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+    NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
     return item;
 }
@@ -252,6 +400,7 @@ BlueQueueDisc::CheckConfig()
         NS_LOG_ERROR("BlueQueueDisc needs 1 internal queue");
         return false;
     }
+    m_queue = GetInternalQueue(0);
 
     return true;
 }
@@ -1,9 +1,16 @@
 #ifndef BLUE_QUEUE_DISC_H
 #define BLUE_QUEUE_DISC_H
 
+#include "ns3/aqm-counters.h"
+#include "ns3/aqm-event-log.h"
+#include "ns3/aqm-reasons.h"
+#include "ns3/cycle-counter.h"
 #include "ns3/queue-disc.h"
 #include "ns3/nstime.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/shared-buffer-manager.h"
+#include "ns3/sojourn-histogram.h"
+#include "ns3/traced-value.h"
 
 namespace ns3 {
 
@@ -11,6 +18,11 @@ namespace ns3 {
  * @ingroup traffic-control
  *
  * @brief A BLUE packet queue disc
+ *
+ * The drop probability is exported as the DropProbability trace source,
+ * which fires when the probability changes by at least TraceDeadband (any
+ * change by default) or falls back to zero, so it can be recorded exactly
+ * without polling GetDropProbability.
  */
 class BlueQueueDisc : public QueueDisc {
 public:
@@ -35,6 +47,8 @@ public:
     // Reasons for dropping packets
     static constexpr const char* FORCED_DROP = "Forced drop";     //!< Queue full drop
     static constexpr const char* PROB_DROP = "Probabilistic drop"; //!< Random drop based on probability
+    static const uint16_t FORCED_DROP_ID; //!< ID of FORCED_DROP (see AqmReasons)
+    static const uint16_t PROB_DROP_ID;   //!< ID of PROB_DROP (see AqmReasons)
     /**
      * Assign a fixed random variable stream number to the random variables
      * used by this model.
@@ -46,6 +60,56 @@ public:
     // Getter for Marking Probability
     double GetDropProbability() const;
 
+    /**
+     * @brief Get the histogram of the time dequeued packets spent in the queue
+     * @return the sojourn time histogram
+     */
+    const SojournHistogram& GetSojournHistogram() const;
+
+    /**
+     * @brief Get the ticks spent in DoEnqueue, counted if ProfileCycles is set
+     * @return the enqueue cycle account
+     */
+    const CycleAccount& GetEnqueueCycles() const;
+
+    /**
+     * @brief Get the ticks spent in DoDequeue, counted if ProfileCycles is set
+     * @return the dequeue cycle account
+     */
+    const CycleAccount& GetDequeueCycles() const;
+
+    /**
+     * @brief Get the hot-path counters, counted if built with NS3_AQM_COUNTERS
+     * @return the hot-path counters
+     */
+    const BlueHotPathCounters& GetHotPathCounters() const;
+
+    /**
+     * @brief Share the packet buffer of other queue discs of the node
+     *
+     * Every arriving packet must then be admitted by the manager before the
+     * BLUE decision; refused packets are dropped with
+     * SharedBufferManager::ADMISSION_DROP.
+     *
+     * @param manager the shared-buffer manager
+     */
+    void SetSharedBuffer(Ptr<SharedBufferManager> manager);
+
+    /**
+     * @brief Report drops and drop probability updates to a binary event log
+     *
+     * Called by AqmEventLog::Start.
+     *
+     * @param log the event log
+     */
+    void SetEventLog(Ptr<AqmEventLog> log);
+
+    /**
+     * @brief Print the statistics BLUE keeps on top of QueueDisc::Stats
+     * @param os output stream
+     */
+    void PrintAqmStats(std::ostream& os) const;
+
 protected:
     /**
      * @brief Dispose of the object
@@ -69,15 +133,44 @@ private:
      */
     void UpdateDropProb(bool overflow);
 
+    /**
+     * @brief Drop a packet before enqueue for a registered reason
+     *
+     * Every drop decided by BLUE goes through this overload, which logs it
+     * by reason ID if an event log is set; QueueDisc::Stats counts the drop
+     * under the reason string as usual.
+     *
+     * @param item the dropped item
+     * @param reason the reason ID (see AqmReasons)
+     */
+    void DropBeforeEnqueue(Ptr<const QueueDiscItem> item, uint16_t reason);
+
+    /**
+     * @brief Publish the drop probability to the DropProbability trace
+     * source if it moved by at least the deadband
+     */
+    void UpdateTrace();
+
     // ** Variables supplied by user
     double m_increment;      //!< Drop probability increment on overflow
     double m_decrement;      //!< Drop probability decrement on underflow
     Time m_freezeTime;       //!< Time interval between drop probability updates
+    double m_traceDeadband;  //!< Smallest change of the drop probability that is traced
+    bool m_profileCycles;    //!< True to count the ticks spent in DoEnqueue and DoDequeue
 
     // ** Variables maintained by BLUE
     double m_dropProb;       //!< Current drop probability
     Time m_lastUpdate;       //!< Last time drop probability was updated
+    TracedValue<double> m_dropProbTrace; //!< Last traced drop probability
     Ptr<UniformRandomVariable> m_uv; //!< Random number generator stream
+    SojournHistogram m_sojourn;      //!< Sojourn times of the dequeued packets
+    CycleAccount m_enqueueCycles;    //!< Ticks spent in DoEnqueue
+    CycleAccount m_dequeueCycles;    //!< Ticks spent in DoDequeue
+    BlueHotPathCounters m_counters;  //!< Hot-path counters (see aqm-counters.h)
+    Ptr<InternalQueue> m_queue;      //!< The internal queue, cached by CheckConfig
+    Ptr<SharedBufferManager> m_sharedBuffer; //!< Shared-buffer manager, if any
+    uint32_t m_sharedBufferPort;             //!< Port index in the shared-buffer manager
+    Ptr<AqmEventLog> m_eventLog;             //!< Binary event log, if any
 };
 
 } // namespace ns3
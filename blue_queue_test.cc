@@ -219,6 +219,14 @@
  
      std::cout << "*** Stats from the bottleneck queue disc ***" << std::endl;
      std::cout << st << std::endl;
+     if (Ptr<BlueQueueDisc> blue = DynamicCast<BlueQueueDisc>(queueDiscs.Get(0)))
+     {
+         blue->PrintAqmStats(std::cout);
+     }
+     else if (Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(queueDiscs.Get(0)))
+     {
+         red->PrintAqmStats(std::cout);
+     }
      std::cout << "Destroying the simulation" << std::endl;
  
      Simulator::Destroy();
@@ -0,0 +1,337 @@
+#include "classful-aqm-queue-disc.h"
+
+#include "aqm-drop-curves.h"
+
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/log.h"
+#include "ns3/object-factory.h"
+#include "ns3/packet-filter.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ClassfulAqmQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(ClassfulAqmQueueDisc);
+
+TypeId
+ClassfulAqmQueueDisc::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ClassfulAqmQueueDisc")
+            .SetParent<QueueDisc>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<ClassfulAqmQueueDisc>()
+            .AddAttribute("MaxSize",
+                          "The maximum number of packets accepted by this queue disc",
+                          QueueSizeValue(QueueSize("1000p")),
+                          MakeQueueSizeAccessor(&QueueDisc::SetMaxSize, &QueueDisc::GetMaxSize),
+                          MakeQueueSizeChecker())
+            .AddAttribute("Aqm",
+                          "AQM algorithm applied to the managed aggregate; Blue drops or marks "
+                          "every managed arrival with its probability, not only on overflow "
+                          "as BlueQueueDisc does",
+                          EnumValue<Aqm>(BLUE),
+                          MakeEnumAccessor<Aqm>(&ClassfulAqmQueueDisc::m_aqm),
+                          MakeEnumChecker(BLUE, "Blue", RED, "Red"))
+            .AddAttribute("ProtectedClasses",
+                          "Number of classes, starting from class 0, exempt from the AQM",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&ClassfulAqmQueueDisc::m_nProtected),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("UseEcn",
+                          "True to mark ECN-capable packets instead of dropping them",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&ClassfulAqmQueueDisc::m_useEcn),
+                          MakeBooleanChecker())
+            .AddAttribute("Increment",
+                          "BLUE: increment of the drop probability on aggregate overflow",
+                          DoubleValue(0.0205),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_increment),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("Decrement",
+                          "BLUE: decrement of the drop probability when a dequeue finds the "
+                          "managed aggregate empty",
+                          DoubleValue(0.00025),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_decrement),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("FreezeTime",
+                          "BLUE: time interval between drop probability updates",
+                          TimeValue(Seconds(0.1)),
+                          MakeTimeAccessor(&ClassfulAqmQueueDisc::m_freezeTime),
+                          MakeTimeChecker())
+            .AddAttribute("MinTh",
+                          "RED: minimum average length of the managed aggregate; the count "
+                          "restarts below it and, unlike RedQueueDisc, the first arrival above "
+                          "it may be dropped",
+                          DoubleValue(5),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_minTh),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("MaxTh",
+                          "RED: average length of the managed aggregate from which every managed "
+                          "arrival is dropped (no gentle mode)",
+                          DoubleValue(15),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_maxTh),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("MaxP",
+                          "RED: drop probability when the average reaches MaxTh, fixed (no "
+                          "adaptive max_p) and spaced by the count without waiting",
+                          DoubleValue(0.02),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_maxP),
+                          MakeDoubleChecker<double>(0.0, 1.0))
+            .AddAttribute("QW",
+                          "RED: queue weight given to the current aggregate length at each "
+                          "managed arrival, without RedQueueDisc's idle-time compensation",
+                          DoubleValue(0.002),
+                          MakeDoubleAccessor(&ClassfulAqmQueueDisc::m_qW),
+                          MakeDoubleChecker<double>(0.0, 1.0));
+    return tid;
+}
+
+ClassfulAqmQueueDisc::ClassfulAqmQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::MULTIPLE_QUEUES)
+{
+    NS_LOG_FUNCTION(this);
+    m_uv = CreateObject<UniformRandomVariable>();
+}
+
+ClassfulAqmQueueDisc::~ClassfulAqmQueueDisc()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+ClassfulAqmQueueDisc::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_uv = nullptr;
+    QueueDisc::DoDispose();
+}
+
+int64_t
+ClassfulAqmQueueDisc::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_uv->SetStream(stream);
+    return 1;
+}
+
+double
+ClassfulAqmQueueDisc::GetDropProbability() const
+{
+    if (m_aqm == BLUE)
+    {
+        return m_dropProb;
+    }
+    if (m_qAvg < m_minTh)
+    {
+        return 0.0;
+    }
+    double thDiff = m_maxTh - m_minTh;
+    return RedDropCurve(m_qAvg, 1.0 / thDiff, -m_minTh / thDiff, 0, 0, m_maxTh, m_maxP, false, false);
+}
+
+const SojournHistogram&
+ClassfulAqmQueueDisc::GetSojournHistogram() const
+{
+    return m_sojourn;
+}
+
+void
+ClassfulAqmQueueDisc::PrintAqmStats(std::ostream& os) const
+{
+    os << (m_aqm == BLUE ? "BLUE" : "RED") << " drop probability of the managed aggregate "
+       << GetDropProbability() << std::endl;
+    os << m_sojourn << std::endl;
+}
+
+uint32_t
+ClassfulAqmQueueDisc::GetManagedLength() const
+{
+    bool bytes = GetMaxSize().GetUnit() == QueueSizeUnit::BYTES;
+    uint32_t length = 0;
+    for (std::size_t i = m_nProtected; i < GetNQueueDiscClasses(); ++i)
+    {
+        Ptr<QueueDisc> qd = GetQueueDiscClass(i)->GetQueueDisc();
+        length += bytes ? qd->GetNBytes() : qd->GetNPackets();
+    }
+    return length;
+}
+
+void
+ClassfulAqmQueueDisc::UpdateBlue(bool overflow)
+{
+    NS_LOG_FUNCTION(this << overflow);
+
+    Time now = Simulator::Now();
+    if (now - m_lastUpdate < m_freezeTime)
+    {
+        return;
+    }
+    m_dropProb = overflow ? BlueIncrease(m_dropProb, m_increment)
+                          : BlueDecrease(m_dropProb, m_decrement);
+    m_lastUpdate = now;
+    NS_LOG_DEBUG("Updated drop probability: " << m_dropProb);
+}
+
+const char*
+ClassfulAqmQueueDisc::RedDecision(Ptr<QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << item);
+
+    m_qAvg = (1.0 - m_qW) * m_qAvg + m_qW * GetManagedLength();
+    if (m_qAvg < m_minTh)
+    {
+        m_count = 0;
+        return nullptr;
+    }
+    if (m_qAvg >= m_maxTh)
+    {
+        m_count = 0;
+        return FORCED_DROP;
+    }
+    m_count++;
+    double p = RedSpacedProbability(GetDropProbability(), m_count, false);
+    if (m_uv->GetValue() < p)
+    {
+        m_count = 0;
+        return PROB_DROP;
+    }
+    return nullptr;
+}
+
+bool
+ClassfulAqmQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << item);
+
+    std::size_t nClasses = GetNQueueDiscClasses();
+    int32_t ret = Classify(item);
+    std::size_t band = nClasses - 1;
+    if (ret != PacketFilter::PF_NO_MATCH && ret >= 0 && static_cast<std::size_t>(ret) < nClasses)
+    {
+        band = ret;
+    }
+    bool managed = band >= m_nProtected;
+
+    if (GetCurrentSize() + item > GetMaxSize())
+    {
+        NS_LOG_LOGIC("Queue disc limit exceeded -- dropping packet");
+        if (managed && m_aqm == BLUE)
+        {
+            UpdateBlue(true);
+        }
+        DropBeforeEnqueue(item, LIMIT_EXCEEDED_DROP);
+        return false;
+    }
+
+    if (managed)
+    {
+        const char* reason = nullptr;
+        if (m_aqm == BLUE)
+        {
+            reason = m_uv->GetValue() < m_dropProb ? PROB_DROP : nullptr;
+        }
+        else
+        {
+            reason = RedDecision(item);
+        }
+
+        if (reason == PROB_DROP && m_useEcn && Mark(item, PROB_MARK))
+        {
+            NS_LOG_DEBUG("\t Marking due to aggregate probability " << GetDropProbability());
+        }
+        else if (reason)
+        {
+            NS_LOG_DEBUG("\t Dropping (" << reason << ")");
+            DropBeforeEnqueue(item, reason);
+            return false;
+        }
+    }
+
+    item->SetTimeStamp(Simulator::Now());
+    // A drop by the child is reported by QueueDisc with the child prefix
+    bool retval = GetQueueDiscClass(band)->GetQueueDisc()->Enqueue(item);
+    NS_LOG_LOGIC("Enqueued in class " << band << ", managed aggregate " << GetManagedLength());
+    return retval;
+}
+
+Ptr<QueueDiscItem>
+ClassfulAqmQueueDisc::DoDequeue()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_aqm == BLUE && GetManagedLength() == 0)
+    {
+        // The managed share of the link is idle, even if protected traffic is queued
+        UpdateBlue(false);
+    }
+
+    for (std::size_t i = 0; i < GetNQueueDiscClasses(); ++i)
+    {
+        Ptr<QueueDiscItem> item = GetQueueDiscClass(i)->GetQueueDisc()->Dequeue();
+        if (item)
+        {
+            m_sojourn.Record(Simulator::Now() - item->GetTimeStamp());
+            NS_LOG_LOGIC("Popped from class " << i << ": " << item);
+            return item;
+        }
+    }
+
+    NS_LOG_LOGIC("Queue empty");
+    return nullptr;
+}
+
+bool
+ClassfulAqmQueueDisc::CheckConfig()
+{
+    NS_LOG_FUNCTION(this);
+    if (GetNInternalQueues() > 0)
+    {
+        NS_LOG_ERROR("ClassfulAqmQueueDisc cannot have internal queues");
+        return false;
+    }
+
+    if (GetNQueueDiscClasses() == 0)
+    {
+        // A single managed FIFO class: the whole queue disc is the managed aggregate
+        ObjectFactory factory;
+        factory.SetTypeId("ns3::FifoQueueDisc");
+        Ptr<QueueDisc> qd = factory.Create<QueueDisc>();
+        qd->SetMaxSize(GetMaxSize());
+        qd->Initialize();
+        Ptr<QueueDiscClass> c = CreateObject<QueueDiscClass>();
+        c->SetQueueDisc(qd);
+        AddQueueDiscClass(c);
+    }
+
+    if (m_nProtected >= GetNQueueDiscClasses())
+    {
+        NS_LOG_ERROR("ClassfulAqmQueueDisc needs at least one class managed by the AQM");
+        return false;
+    }
+
+    if (m_aqm == RED && m_minTh >= m_maxTh)
+    {
+        NS_LOG_ERROR("MinTh (" << m_minTh << ") must be smaller than MaxTh (" << m_maxTh << ")");
+        return false;
+    }
+
+    return true;
+}
+
+void
+ClassfulAqmQueueDisc::InitializeParams()
+{
+    NS_LOG_FUNCTION(this);
+    m_dropProb = 0.0;
+    m_lastUpdate = NanoSeconds(0);
+    m_qAvg = 0.0;
+    m_count = 0;
+}
+
+} // namespace ns3
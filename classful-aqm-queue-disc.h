@@ -0,0 +1,154 @@
+#ifndef CLASSFUL_AQM_QUEUE_DISC_H
+#define CLASSFUL_AQM_QUEUE_DISC_H
+
+#include "queue-disc.h"
+#include "sojourn-histogram.h"
+
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Strict-priority classful queue disc with BLUE or RED applied to
+ * the aggregate of its managed classes
+ *
+ * Packets are classified by the packet filters into the child queue discs
+ * (class i for filter result i, the last class when no filter matches) and
+ * served in class order, class 0 first. The first ProtectedClasses classes
+ * are left alone by the AQM, e.g. for control traffic. The packets of all
+ * the other classes form the managed aggregate: its length drives the
+ * drop probability, which follows BLUE (raised on aggregate overflow,
+ * lowered when a dequeue finds the aggregate empty) or RED (curve of the
+ * average aggregate length, without idle-time compensation), and its
+ * arrivals are dropped or marked with that probability before reaching
+ * their class.
+ *
+ * The BLUE variant is the probabilistic-early BLUE of Feng et al.: every
+ * managed arrival is dropped or marked with the drop probability, even
+ * below the limit. BlueQueueDisc, in contrast, only drops on overflow and
+ * uses its probability to label those drops, so the two do not behave
+ * alike at the same parameters.
+ *
+ * The RED variant shares RedDropCurve and RedSpacedProbability with
+ * RedQueueDisc, but is a reduced RED: the average is only updated at
+ * managed arrivals (no idle-time compensation), there is no gentle mode,
+ * no wait between drops and no adaptive max_p, the count restarts below
+ * MinTh and at every drop, and the first arrival above MinTh may already
+ * be dropped (RedQueueDisc exempts it through its "old" flag).
+ *
+ * Every packet is dropped at most once: an AQM drop happens at this level
+ * and the packet never reaches a child, while a child's own drops are
+ * reported once, with the child prefix, by QueueDisc.
+ */
+class ClassfulAqmQueueDisc : public QueueDisc
+{
+  public:
+    /**
+     * @brief AQM algorithm applied to the managed aggregate
+     */
+    enum Aqm
+    {
+        BLUE, //!< Probabilistic-early BLUE, driven by overflow and idle events
+        RED   //!< Reduced RED, driven by the average aggregate length
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    ClassfulAqmQueueDisc();
+    ~ClassfulAqmQueueDisc() override;
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     * @param stream first stream index to use
+     * @return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    /**
+     * @brief Get the drop probability applied to the managed aggregate
+     * @return the BLUE drop probability, or the RED curve probability
+     */
+    double GetDropProbability() const;
+
+    /**
+     * @brief Get the histogram of the time dequeued packets spent in the queue disc
+     * @return the sojourn time histogram
+     */
+    const SojournHistogram& GetSojournHistogram() const;
+
+    /**
+     * @brief Print the AQM state and the sojourn time percentiles
+     * @param os output stream
+     */
+    void PrintAqmStats(std::ostream& os) const;
+
+    // Reasons for dropping packets
+    static constexpr const char* LIMIT_EXCEEDED_DROP = "Queue disc limit exceeded"; //!< Aggregate overflow
+    static constexpr const char* PROB_DROP = "Aggregate probabilistic drop"; //!< AQM drop
+    static constexpr const char* FORCED_DROP = "Aggregate forced drop"; //!< RED average above MaxTh
+    // Reasons for marking packets
+    static constexpr const char* PROB_MARK = "Aggregate probabilistic mark"; //!< AQM mark
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+
+    /**
+     * @brief Get the length of the managed aggregate
+     * @return packets or bytes, in the unit of MaxSize
+     */
+    uint32_t GetManagedLength() const;
+
+    /**
+     * @brief Update the BLUE drop probability
+     * @param overflow true on aggregate overflow, false when a dequeue finds it empty
+     */
+    void UpdateBlue(bool overflow);
+
+    /**
+     * @brief Decide whether a managed arrival is dropped (or marked) by RED
+     * @param item the arriving packet
+     * @return the drop reason, nullptr to accept the packet
+     */
+    const char* RedDecision(Ptr<QueueDiscItem> item);
+
+    // ** Variables supplied by user
+    Aqm m_aqm;                 //!< AQM algorithm
+    uint32_t m_nProtected;     //!< Number of classes exempt from the AQM
+    bool m_useEcn;             //!< True to mark ECN-capable packets instead of dropping them
+    double m_increment;        //!< BLUE increment on overflow
+    double m_decrement;        //!< BLUE decrement when idle
+    Time m_freezeTime;         //!< BLUE minimum time between updates
+    double m_minTh;            //!< RED minimum threshold
+    double m_maxTh;            //!< RED maximum threshold
+    double m_maxP;             //!< RED drop probability at MaxTh
+    double m_qW;               //!< RED queue weight
+
+    // ** Variables maintained by the queue disc
+    double m_dropProb;               //!< BLUE drop probability
+    Time m_lastUpdate;               //!< Last BLUE update
+    double m_qAvg;                   //!< RED average aggregate length
+    uint32_t m_count;                //!< RED arrivals since the last drop
+    Ptr<UniformRandomVariable> m_uv; //!< Random number generator stream
+    SojournHistogram m_sojourn;      //!< Sojourn times of the dequeued packets
+};
+
+} // namespace ns3
+
+#endif // CLASSFUL_AQM_QUEUE_DISC_H
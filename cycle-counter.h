@@ -0,0 +1,89 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Read a cheap, monotonic tick counter
+ *
+ * The time stamp counter on x86 and the virtual counter on AArch64, both a
+ * few nanoseconds to read and unaffected by frequency scaling on current
+ * processors; elsewhere the steady clock in nanoseconds. Ticks are turned
+ * into seconds by comparing them with the wall clock over a long interval
+ * (see ProfilingSimulatorImpl).
+ *
+ * @return the counter value
+ */
+inline uint64_t
+ReadCycleCounter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+/**
+ * @brief Calls of a piece of code and the ticks spent in them
+ */
+struct CycleAccount
+{
+    uint64_t calls = 0;  //!< Number of measured calls
+    uint64_t cycles = 0; //!< Ticks spent in the measured calls
+};
+
+/**
+ * @brief Charge the ticks until the end of the enclosing scope to an account
+ *
+ * Does nothing if the account is null, so a measurement can be switched
+ * off at the cost of a predictable branch.
+ */
+class CycleScope
+{
+  public:
+    /**
+     * @param account the account to charge, or nullptr
+     */
+    explicit CycleScope(CycleAccount* account)
+        : m_account(account),
+          m_start(account ? ReadCycleCounter() : 0)
+    {
+    }
+
+    ~CycleScope()
+    {
+        if (m_account)
+        {
+            m_account->cycles += ReadCycleCounter() - m_start;
+            m_account->calls++;
+        }
+    }
+
+    CycleScope(const CycleScope&) = delete;
+    CycleScope& operator=(const CycleScope&) = delete;
+
+  private:
+    CycleAccount* m_account; //!< Account charged, or nullptr
+    uint64_t m_start;        //!< Counter value at the start of the scope
+};
+
+} // namespace ns3
+
+#endif // CYCLE_COUNTER_H
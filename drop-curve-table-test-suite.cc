@@ -0,0 +1,187 @@
+#include "ns3/drop-curve-table.h"
+#include "ns3/test.h"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief Check that the lookup table of a drop curve stays within a given
+ * error of the curve computed from its breakpoints
+ *
+ * The curve is evaluated at its breakpoints, just before and after each of
+ * them, at the table entries and half-way between consecutive entries,
+ * where the linear interpolation is the furthest from a curved segment.
+ */
+class DropCurveTableAccuracyTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor
+     *
+     * @param spec the breakpoints
+     * @param breakpoints the x of the breakpoints of spec
+     * @param tableSize number of table intervals
+     * @param tolerance largest allowed difference between Evaluate and EvaluateExact
+     */
+    DropCurveTableAccuracyTestCase(std::string spec,
+                                   std::vector<double> breakpoints,
+                                   uint32_t tableSize,
+                                   double tolerance);
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Check the table at one average queue length
+     * @param table the compiled curve
+     * @param x the average queue length
+     */
+    void CheckAt(const DropCurveTable& table, double x);
+
+    std::string m_spec;               //!< Breakpoints
+    std::vector<double> m_breakpoints; //!< x of the breakpoints
+    uint32_t m_tableSize;             //!< Number of table intervals
+    double m_tolerance;               //!< Largest allowed error
+};
+
+DropCurveTableAccuracyTestCase::DropCurveTableAccuracyTestCase(std::string spec,
+                                                               std::vector<double> breakpoints,
+                                                               uint32_t tableSize,
+                                                               double tolerance)
+    : TestCase("Drop curve table accuracy for \"" + spec + "\""),
+      m_spec(spec),
+      m_breakpoints(breakpoints),
+      m_tableSize(tableSize),
+      m_tolerance(tolerance)
+{
+}
+
+void
+DropCurveTableAccuracyTestCase::CheckAt(const DropCurveTable& table, double x)
+{
+    NS_TEST_EXPECT_MSG_EQ_TOL(table.Evaluate(x),
+                              table.EvaluateExact(x),
+                              m_tolerance,
+                              "Table error too large at x = " << x);
+}
+
+void
+DropCurveTableAccuracyTestCase::DoRun()
+{
+    DropCurveTable table;
+    std::string error;
+    NS_TEST_ASSERT_MSG_EQ(table.Compile(m_spec, m_tableSize, error), true, error);
+
+    double xMin = m_breakpoints.front();
+    double xMax = m_breakpoints.back();
+    double step = (xMax - xMin) / m_tableSize;
+    for (double b : m_breakpoints)
+    {
+        CheckAt(table, b);
+        CheckAt(table, b - step * 1e-3);
+        CheckAt(table, b + step * 1e-3);
+    }
+    for (uint32_t i = 0; i < m_tableSize; ++i)
+    {
+        CheckAt(table, xMin + step * i);
+        CheckAt(table, xMin + step * (i + 0.5));
+    }
+    CheckAt(table, xMin - 1);
+    CheckAt(table, xMax + 1);
+
+    // Outside the breakpoints the curve is flat
+    NS_TEST_EXPECT_MSG_EQ(table.Evaluate(xMin - 1), table.EvaluateExact(xMin), "Not flat below");
+    NS_TEST_EXPECT_MSG_EQ(table.Evaluate(xMax + 1), table.EvaluateExact(xMax), "Not flat above");
+}
+
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief Check that invalid drop curves are rejected
+ */
+class DropCurveTableParseTestCase : public TestCase
+{
+  public:
+    DropCurveTableParseTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+DropCurveTableParseTestCase::DropCurveTableParseTestCase()
+    : TestCase("Drop curve parsing")
+{
+}
+
+void
+DropCurveTableParseTestCase::DoRun()
+{
+    const char* invalid[] = {
+        "",                 // no breakpoint
+        "5:0",              // one breakpoint
+        "5:0 15",           // no probability
+        "5:0 15:1.5",       // probability above 1
+        "15:0 5:1",         // decreasing x
+        "5:0 15:1:square",  // unknown shape
+        "5:0 15:1:exp=0",   // zero exponential rate
+    };
+    for (const char* spec : invalid)
+    {
+        DropCurveTable table;
+        std::string error;
+        NS_TEST_EXPECT_MSG_EQ(table.Compile(spec, 1024, error),
+                              false,
+                              "\"" << spec << "\" should be rejected");
+        NS_TEST_EXPECT_MSG_EQ(table.IsEmpty(), true, "\"" << spec << "\" left a table");
+        NS_TEST_EXPECT_MSG_EQ(error.empty(), false, "\"" << spec << "\" gave no reason");
+    }
+
+    DropCurveTable table;
+    std::string error;
+    NS_TEST_EXPECT_MSG_EQ(table.Compile("5:0 15:1", 0, error), false, "Empty table accepted");
+    NS_TEST_EXPECT_MSG_EQ(table.Compile("5:0, 15:0.1:linear, 30:1", 1024, error),
+                          true,
+                          error);
+
+    // A failed Compile drops the curve compiled before
+    NS_TEST_EXPECT_MSG_EQ(table.Compile("5:0 15:0.5 10:1", 1024, error), false, "Accepted");
+    NS_TEST_EXPECT_MSG_EQ(table.IsEmpty(), true, "The previous table was kept");
+}
+
+/**
+ * @ingroup traffic-control-test
+ *
+ * @brief Drop curve table test suite
+ */
+static class DropCurveTableTestSuite : public TestSuite
+{
+  public:
+    DropCurveTableTestSuite()
+        : TestSuite("drop-curve-table", Type::UNIT)
+    {
+        // The RED shapes with the default DropCurveTableSize: the kinks
+        // between the table entries bound the error to about 3e-4
+        AddTestCase(new DropCurveTableAccuracyTestCase("5:0 15:0.1 30:1", {5, 15, 30}, 1024, 3e-4),
+                    TestCase::Duration::QUICK);
+        AddTestCase(
+            new DropCurveTableAccuracyTestCase("5:0 15:0.1:cubic 30:1", {5, 15, 30}, 1024, 3e-4),
+            TestCase::Duration::QUICK);
+        AddTestCase(new DropCurveTableAccuracyTestCase("5:0 15:0.1:exp 30:1:exp=3",
+                                                       {5, 15, 30},
+                                                       1024,
+                                                       3e-4),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new DropCurveTableAccuracyTestCase("5:0 15:1:cubic", {5, 15}, 1024, 3e-4),
+                    TestCase::Duration::QUICK);
+        // A finer table lowers the error in proportion
+        AddTestCase(new DropCurveTableAccuracyTestCase("5:0 15:0.1 30:1", {5, 15, 30}, 8192, 4e-5),
+                    TestCase::Duration::QUICK);
+        AddTestCase(new DropCurveTableParseTestCase(), TestCase::Duration::QUICK);
+    }
+} g_dropCurveTableTestSuite; ///< the test suite
@@ -0,0 +1,141 @@
+#include "drop-curve-table.h"
+
+#include "ns3/log.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("DropCurveTable");
+
+DropCurveTable::DropCurveTable()
+    : m_xMin(0),
+      m_scale(0)
+{
+}
+
+bool
+DropCurveTable::Compile(const std::string& spec, uint32_t tableSize, std::string& error)
+{
+    NS_LOG_FUNCTION(this << spec << tableSize);
+
+    // The breakpoints are parsed aside, so a failure leaves no partial curve
+    m_points.clear();
+    m_table.clear();
+    std::vector<Breakpoint> points;
+
+    std::string text = spec;
+    std::replace(text.begin(), text.end(), ',', ' ');
+    std::istringstream tokens(text);
+    std::string token;
+    while (tokens >> token)
+    {
+        std::istringstream fields(token);
+        Breakpoint b{0, 0, LINEAR, 5.0};
+        char colon;
+        if (!(fields >> b.x >> colon >> b.p) || colon != ':')
+        {
+            error = "breakpoint \"" + token + "\" is not x:p";
+            return false;
+        }
+        std::string shape;
+        if (fields >> colon)
+        {
+            if (colon != ':' || !(fields >> shape))
+            {
+                error = "breakpoint \"" + token + "\" has no shape after its second ':'";
+                return false;
+            }
+        }
+        if (shape == "cubic")
+        {
+            b.shape = CUBIC;
+        }
+        else if (shape == "exp" || shape.rfind("exp=", 0) == 0)
+        {
+            b.shape = EXPONENTIAL;
+            if (shape.size() > 4)
+            {
+                b.k = std::atof(shape.c_str() + 4);
+            }
+            if (b.k == 0)
+            {
+                error = "breakpoint \"" + token + "\" has a zero exponential rate";
+                return false;
+            }
+        }
+        else if (!shape.empty() && shape != "linear")
+        {
+            error = "unknown segment shape \"" + shape + "\"";
+            return false;
+        }
+        if (b.p < 0 || b.p > 1)
+        {
+            error = "probability of \"" + token + "\" is not in [0, 1]";
+            return false;
+        }
+        if (!points.empty() && b.x <= points.back().x)
+        {
+            error = "breakpoint \"" + token + "\" does not increase x";
+            return false;
+        }
+        points.push_back(b);
+    }
+    if (points.size() < 2)
+    {
+        error = "a drop curve needs at least two breakpoints";
+        return false;
+    }
+    if (tableSize == 0)
+    {
+        error = "the table needs at least one interval";
+        return false;
+    }
+
+    m_points = std::move(points);
+    m_xMin = m_points.front().x;
+    double width = m_points.back().x - m_xMin;
+    m_scale = tableSize / width;
+    m_table.resize(tableSize + 1);
+    for (uint32_t i = 0; i <= tableSize; ++i)
+    {
+        m_table[i] = EvaluateExact(m_xMin + width * i / tableSize);
+    }
+    NS_LOG_DEBUG("Compiled " << m_points.size() << " breakpoints into " << m_table.size()
+                             << " entries");
+    return true;
+}
+
+double
+DropCurveTable::EvaluateExact(double x) const
+{
+    if (x <= m_points.front().x)
+    {
+        return m_points.front().p;
+    }
+    if (x >= m_points.back().x)
+    {
+        return m_points.back().p;
+    }
+    auto b = std::upper_bound(m_points.begin(),
+                              m_points.end(),
+                              x,
+                              [](double v, const Breakpoint& bp) { return v < bp.x; });
+    auto a = b - 1;
+    double t = (x - a->x) / (b->x - a->x);
+    double f = t;
+    if (b->shape == CUBIC)
+    {
+        f = t * t * t;
+    }
+    else if (b->shape == EXPONENTIAL)
+    {
+        f = std::expm1(b->k * t) / std::expm1(b->k);
+    }
+    return a->p + f * (b->p - a->p);
+}
+
+} // namespace ns3
@@ -0,0 +1,111 @@
+#ifndef DROP_CURVE_TABLE_H
+#define DROP_CURVE_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Drop curve given by a list of breakpoints, compiled into a
+ * uniform lookup table
+ *
+ * The curve is written as whitespace or comma separated "x:p" breakpoints
+ * with increasing x, e.g. "5:0 15:0.1 30:1" for gentle RED with
+ * MinTh = 5, MaxTh = 15 and max_p = 0.1. Between two breakpoints the
+ * probability is linear, unless the second one carries a shape:
+ * "x:p:cubic" rises as t^3 and "x:p:exp" (or "x:p:exp=k", k = 5 by
+ * default) as (e^(kt) - 1) / (e^k - 1), t going from 0 to 1 across the
+ * segment. Below the first and above the last breakpoint the probability
+ * is that of the breakpoint.
+ *
+ * Compile samples the curve at TableSize + 1 evenly spaced points, so
+ * Evaluate is one index computation and one linear interpolation,
+ * whatever the number and shape of the segments. The interpolation error
+ * is largest where a breakpoint falls between two table entries, and
+ * shrinks in proportion to TableSize; EvaluateExact gives the reference.
+ */
+class DropCurveTable
+{
+  public:
+    /**
+     * @brief Shape of a segment
+     */
+    enum Shape
+    {
+        LINEAR,     //!< Straight line
+        CUBIC,      //!< t^3
+        EXPONENTIAL //!< (e^(kt) - 1) / (e^k - 1)
+    };
+
+    DropCurveTable();
+
+    /**
+     * @brief Parse a curve and build its lookup table
+     * @param spec the breakpoints
+     * @param tableSize number of table intervals
+     * @param error set to the reason of a failure
+     * @return false if spec is not a valid curve; the table is then empty
+     */
+    bool Compile(const std::string& spec, uint32_t tableSize, std::string& error);
+
+    /// @return true if no curve has been compiled
+    bool IsEmpty() const
+    {
+        return m_table.empty();
+    }
+
+    /**
+     * @brief Look up the probability of an average queue length
+     * @param x the average queue length
+     * @return the drop probability
+     */
+    double Evaluate(double x) const
+    {
+        if (x <= m_xMin)
+        {
+            return m_table.front();
+        }
+        double pos = (x - m_xMin) * m_scale;
+        auto i = static_cast<std::size_t>(pos);
+        if (i >= m_table.size() - 1)
+        {
+            return m_table.back();
+        }
+        return m_table[i] + (pos - i) * (m_table[i + 1] - m_table[i]);
+    }
+
+    /**
+     * @brief Compute the probability of an average queue length from the
+     * breakpoints, without the table
+     * @param x the average queue length
+     * @return the drop probability
+     */
+    double EvaluateExact(double x) const;
+
+  private:
+    /**
+     * @brief A breakpoint and the shape of the segment ending there
+     */
+    struct Breakpoint
+    {
+        double x;    //!< Average queue length
+        double p;    //!< Drop probability
+        Shape shape; //!< Shape of the segment ending at this breakpoint
+        double k;    //!< Rate of an exponential segment
+    };
+
+    std::vector<Breakpoint> m_points; //!< Breakpoints, by increasing x
+    std::vector<double> m_table;      //!< Probability at m_xMin + i / m_scale
+    double m_xMin;                    //!< First breakpoint
+    double m_scale;                   //!< Table intervals per unit of queue length
+};
+
+} // namespace ns3
+
+#endif // DROP_CURVE_TABLE_H
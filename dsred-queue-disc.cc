@@ -1,4 +1,5 @@
 #include "dsred-queue-disc.h"
+#include "aqm-drop-curves.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -42,30 +43,13 @@ DsRedQueueDisc::SetGamma (double gamma)
 double
 DsRedQueueDisc::CalculatePNew (void)
 {
-  double avg = m_qAvg;
-  double minTh = m_minTh;
-  double maxTh = m_maxTh;
-  double pMax = m_lInterm;
-
-  double alpha = (pMax-m_gamma)/(m_midThreshold-minTh);
-  double beta = m_gamma/(maxTh-m_midThreshold);
-
-  if (avg < minTh)
-    {
-      return 0.0;
-    }
-  else if (avg < m_midThreshold)
-    {
-      return alpha * (avg - minTh);
-    }
-  else if (avg < maxTh)
-    {
-        return 1 - m_gamma + beta * (avg - m_midThreshold);
-    }
-  else
+  if (!m_dropCurve.IsEmpty ())
     {
-      return 1.0; // Drop all packets above max threshold
+      // A configured breakpoint curve replaces the double slope
+      return m_dropCurve.Evaluate (m_qAvg);
     }
+  AQM_COUNT (m_qAvg < m_midThreshold ? m_counters.dsredLowerSlope : m_counters.dsredUpperSlope);
+  return DsRedDropCurve (m_qAvg, m_minTh, m_midThreshold, m_maxTh, m_lInterm, m_gamma);
 }
 
 } // namespace ns3
@@ -0,0 +1,268 @@
+#include "dualq-coupled-queue-disc.h"
+
+#include "blue-queue-disc.h"
+#include "red-queue-disc.h"
+
+#include "ns3/double.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/log.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("DualQCoupledQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(DualQCoupledQueueDisc);
+
+TypeId
+DualQCoupledQueueDisc::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::DualQCoupledQueueDisc")
+            .SetParent<QueueDisc>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<DualQCoupledQueueDisc>()
+            .AddAttribute("ClassicQueueDisc",
+                          "Type of the classic queue disc created if no class is configured",
+                          StringValue("ns3::RedQueueDisc"),
+                          MakeStringAccessor(&DualQCoupledQueueDisc::m_classicType),
+                          MakeStringChecker())
+            .AddAttribute("LowLatencyMaxSize",
+                          "The maximum number of packets accepted by the L queue",
+                          QueueSizeValue(QueueSize("1000p")),
+                          MakeQueueSizeAccessor(&DualQCoupledQueueDisc::m_lMaxSize),
+                          MakeQueueSizeChecker())
+            .AddAttribute("CouplingFactor",
+                          "k in p_CL = k * sqrt(p_C)",
+                          DoubleValue(2.0),
+                          MakeDoubleAccessor(&DualQCoupledQueueDisc::m_k),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("StepThreshold",
+                          "L queue sojourn time above which every L packet is marked",
+                          TimeValue(MilliSeconds(1)),
+                          MakeTimeAccessor(&DualQCoupledQueueDisc::m_stepThreshold),
+                          MakeTimeChecker())
+            .AddAttribute("TimeShift",
+                          "Extra waiting time the C head needs to be served before the L head",
+                          TimeValue(MilliSeconds(30)),
+                          MakeTimeAccessor(&DualQCoupledQueueDisc::m_tShift),
+                          MakeTimeChecker());
+    return tid;
+}
+
+DualQCoupledQueueDisc::DualQCoupledQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::NO_LIMITS),
+      m_nStepMarks(0),
+      m_nCoupledMarks(0)
+{
+    NS_LOG_FUNCTION(this);
+    m_uv = CreateObject<UniformRandomVariable>();
+}
+
+DualQCoupledQueueDisc::~DualQCoupledQueueDisc()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+DualQCoupledQueueDisc::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_uv = nullptr;
+    m_lQueue = nullptr;
+    m_classic = nullptr;
+    m_classicRed = nullptr;
+    m_classicBlue = nullptr;
+    QueueDisc::DoDispose();
+}
+
+int64_t
+DualQCoupledQueueDisc::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+    m_uv->SetStream(stream);
+    return 1;
+}
+
+const SojournHistogram&
+DualQCoupledQueueDisc::GetLowLatencySojournHistogram() const
+{
+    return m_lSojourn;
+}
+
+void
+DualQCoupledQueueDisc::PrintAqmStats(std::ostream& os) const
+{
+    os << "L queue: " << m_nStepMarks << " step marks, " << m_nCoupledMarks
+       << " coupled marks" << std::endl;
+    os << m_lSojourn << std::endl;
+    os << "C queue:" << std::endl;
+    if (m_classicRed)
+    {
+        m_classicRed->PrintAqmStats(os);
+    }
+    else if (m_classicBlue)
+    {
+        m_classicBlue->PrintAqmStats(os);
+    }
+}
+
+bool
+DualQCoupledQueueDisc::IsL4s(Ptr<const QueueDiscItem> item)
+{
+    uint8_t tos;
+    // ECT(1) is 01 and CE is 11 in the two ECN bits
+    return item->GetUint8Value(QueueItem::IP_DSFIELD, tos) && (tos & 0x1);
+}
+
+double
+DualQCoupledQueueDisc::GetClassicProbability()
+{
+    if (m_classicRed)
+    {
+        return m_classicRed->GetCurveProbability();
+    }
+    if (m_classicBlue)
+    {
+        return m_classicBlue->GetDropProbability();
+    }
+    return 0.0;
+}
+
+double
+DualQCoupledQueueDisc::GetCoupledProbability()
+{
+    return std::min(m_k * std::sqrt(GetClassicProbability()), 1.0);
+}
+
+bool
+DualQCoupledQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << item);
+
+    item->SetTimeStamp(Simulator::Now());
+    if (IsL4s(item))
+    {
+        // If the L queue is full, it calls DropBeforeEnqueue itself
+        bool retval = m_lQueue->Enqueue(item);
+        NS_LOG_LOGIC("L queue packets " << m_lQueue->GetNPackets());
+        return retval;
+    }
+
+    // Drops and marks by the classic AQM are reported by QueueDisc
+    bool retval = m_classic->Enqueue(item);
+    NS_LOG_LOGIC("C queue packets " << m_classic->GetNPackets());
+    return retval;
+}
+
+Ptr<QueueDiscItem>
+DualQCoupledQueueDisc::DoDequeue()
+{
+    NS_LOG_FUNCTION(this);
+
+    bool lReady = !m_lQueue->IsEmpty();
+    bool cReady = m_classic->GetNPackets() > 0;
+    if (lReady && cReady)
+    {
+        // Time-shifted FIFO: the older head wins once the L head is
+        // credited with TimeShift
+        Ptr<const QueueDiscItem> cHead = m_classic->Peek();
+        lReady = !cHead || m_lQueue->Peek()->GetTimeStamp() - m_tShift <= cHead->GetTimeStamp();
+    }
+
+    if (!lReady)
+    {
+        // Also lets an empty classic AQM see the idle period
+        Ptr<QueueDiscItem> item = m_classic->Dequeue();
+        NS_LOG_LOGIC("Popped from C queue " << item);
+        return item;
+    }
+
+    Ptr<QueueDiscItem> item = m_lQueue->Dequeue();
+    Time sojourn = Simulator::Now() - item->GetTimeStamp();
+    m_lSojourn.Record(sojourn);
+    if (sojourn >= m_stepThreshold)
+    {
+        if (Mark(item, STEP_MARK))
+        {
+            m_nStepMarks++;
+        }
+    }
+    else if (m_uv->GetValue() < GetCoupledProbability())
+    {
+        if (Mark(item, COUPLED_MARK))
+        {
+            m_nCoupledMarks++;
+        }
+    }
+    NS_LOG_LOGIC("Popped from L queue " << item << ", sojourn " << sojourn);
+    return item;
+}
+
+bool
+DualQCoupledQueueDisc::CheckConfig()
+{
+    NS_LOG_FUNCTION(this);
+    if (GetNPacketFilters() > 0)
+    {
+        NS_LOG_ERROR("DualQCoupledQueueDisc classifies by ECN codepoint, not packet filters");
+        return false;
+    }
+
+    if (GetNInternalQueues() == 0)
+    {
+        AddInternalQueue(CreateObjectWithAttributes<DropTailQueue<QueueDiscItem>>(
+            "MaxSize",
+            QueueSizeValue(m_lMaxSize)));
+    }
+
+    if (GetNInternalQueues() != 1)
+    {
+        NS_LOG_ERROR("DualQCoupledQueueDisc needs 1 internal queue (the L queue)");
+        return false;
+    }
+
+    if (GetNQueueDiscClasses() == 0)
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(m_classicType);
+        Ptr<QueueDisc> qd = factory.Create<QueueDisc>();
+        qd->Initialize();
+        Ptr<QueueDiscClass> c = CreateObject<QueueDiscClass>();
+        c->SetQueueDisc(qd);
+        AddQueueDiscClass(c);
+    }
+
+    if (GetNQueueDiscClasses() != 1)
+    {
+        NS_LOG_ERROR("DualQCoupledQueueDisc needs 1 class (the C queue)");
+        return false;
+    }
+
+    m_lQueue = GetInternalQueue(0);
+    m_classic = GetQueueDiscClass(0)->GetQueueDisc();
+    m_classicRed = DynamicCast<RedQueueDisc>(m_classic);
+    m_classicBlue = DynamicCast<BlueQueueDisc>(m_classic);
+    if (!m_classicRed && !m_classicBlue)
+    {
+        NS_LOG_WARN("The classic queue disc exposes no probability, L packets are only step marked");
+    }
+
+    return true;
+}
+
+void
+DualQCoupledQueueDisc::InitializeParams()
+{
+    NS_LOG_FUNCTION(this);
+    m_nStepMarks = 0;
+    m_nCoupledMarks = 0;
+}
+
+} // namespace ns3
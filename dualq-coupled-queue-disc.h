@@ -0,0 +1,121 @@
+#ifndef DUALQ_COUPLED_QUEUE_DISC_H
+#define DUALQ_COUPLED_QUEUE_DISC_H
+
+#include "queue-disc.h"
+#include "sojourn-histogram.h"
+
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+#include <ostream>
+#include <string>
+
+namespace ns3
+{
+
+class RedQueueDisc;
+class BlueQueueDisc;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Dual-queue coupled AQM for L4S and classic traffic (RFC 9332)
+ *
+ * Packets carrying ECT(1) or CE go to a shallow low-latency (L) internal
+ * queue; all others go to a classic (C) child queue disc, by default a
+ * RedQueueDisc (a BlueQueueDisc also works). The classic AQM keeps its own
+ * drop or mark logic. Its probability p_C (the RED curve probability, or
+ * the BLUE drop probability) is coupled to the L queue as
+ *
+ *   p_CL = min(1, CouplingFactor * sqrt(p_C))
+ *
+ * and an L packet is marked at dequeue if it waited at least StepThreshold
+ * or, failing that, with probability p_CL. The scheduler is a time-shifted
+ * FIFO: the L head is served unless the C head has waited more than
+ * TimeShift longer than it.
+ */
+class DualQCoupledQueueDisc : public QueueDisc
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    DualQCoupledQueueDisc();
+    ~DualQCoupledQueueDisc() override;
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     * @param stream first stream index to use
+     * @return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    /**
+     * @brief Get the coupled marking probability of the L queue
+     * @return p_CL for the current state of the classic AQM
+     */
+    double GetCoupledProbability();
+
+    /**
+     * @brief Get the histogram of the time dequeued L packets spent in the queue
+     * @return the L queue sojourn time histogram
+     */
+    const SojournHistogram& GetLowLatencySojournHistogram() const;
+
+    /**
+     * @brief Print the L queue statistics and those of the classic AQM
+     * @param os output stream
+     */
+    void PrintAqmStats(std::ostream& os) const;
+
+    // Reasons for marking packets
+    static constexpr const char* STEP_MARK = "L4S step mark";       //!< L sojourn above StepThreshold
+    static constexpr const char* COUPLED_MARK = "L4S coupled mark"; //!< Random mark with p_CL
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+
+    /**
+     * @brief Check whether a packet belongs to the low-latency queue
+     * @param item the packet
+     * @return true if its ECN field is ECT(1) or CE
+     */
+    static bool IsL4s(Ptr<const QueueDiscItem> item);
+
+    /**
+     * @brief Get the drop (or mark) probability of the classic AQM
+     * @return p_C, 0 if the classic queue disc exposes none
+     */
+    double GetClassicProbability();
+
+    // ** Variables supplied by user
+    std::string m_classicType;      //!< TypeId name of the classic queue disc
+    QueueSize m_lMaxSize;           //!< Capacity of the L queue
+    double m_k;                     //!< Coupling factor
+    Time m_stepThreshold;           //!< L sojourn time above which every packet is marked
+    Time m_tShift;                  //!< Head start given to the C queue by the scheduler
+
+    // ** Variables maintained by the queue disc
+    Ptr<InternalQueue> m_lQueue;      //!< The L queue, cached by CheckConfig
+    Ptr<QueueDisc> m_classic;         //!< The classic queue disc, cached by CheckConfig
+    Ptr<RedQueueDisc> m_classicRed;   //!< The classic queue disc, if of the RED family
+    Ptr<BlueQueueDisc> m_classicBlue; //!< The classic queue disc, if BLUE
+    Ptr<UniformRandomVariable> m_uv;  //!< Random number generator stream
+    SojournHistogram m_lSojourn;      //!< Sojourn times of the dequeued L packets
+    uint64_t m_nStepMarks;            //!< L packets marked by the step threshold
+    uint64_t m_nCoupledMarks;         //!< L packets marked with the coupled probability
+};
+
+} // namespace ns3
+
+#endif // DUALQ_COUPLED_QUEUE_DISC_H
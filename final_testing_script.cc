@@ -6,21 +6,36 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/traffic-control-module.h"
 #include "ns3/flow-monitor-module.h"
+#include "ns3/aqm-arrival-capture.h"
+#include "ns3/aqm-event-log.h"
+#include "ns3/aqm-interval-stats.h"
+#include "ns3/aqm-steady-state-monitor.h"
+#include "ns3/aqm-telemetry.h"
+#include "ns3/pooled-allocator.h"
+#include "ns3/profiling-simulator-impl.h"
 
+#include "multi-flow-on-off-application.h"
+#include "scalable-dumbbell-helper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <ctime>
+#include <sstream>
+#include <vector>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("BlueAqmExample");
 
-int main(int argc, char* argv[])
-{   
-    SeedManager::SetSeed(time(0));
-    LogComponentEnable("BlueAqmExample", LOG_LEVEL_INFO);
-    LogComponentEnable("BlueQueueDisc", LOG_LEVEL_INFO);
+/**
+ * Parameters of one dumbbell experiment
+ */
+struct ExperimentConfig
+{
     uint32_t nLeaf = 10;
     uint32_t maxPackets = 100;
     bool modeBytes = false;
@@ -35,200 +50,973 @@ int main(int argc, char* argv[])
     uint16_t port = 5001;
     std::string bottleNeckLinkBw = "1Mbps";
     std::string bottleNeckLinkDelay = "50ms";
-    // Add new command-line arguments for BlueQueueDisc parameters
     double blueIncrement = 0.02;
     double blueDecrement = 0.002;
     double blueFreezeTime = 0.1;
+    double clientStopTime = 15.0; //!< Time the on/off clients stop
+    double stopTime = 30.0;       //!< Time the simulation stops
+    bool fastTopology = false;    //!< Build with ScalableDumbbellHelper and static routes
+    uint32_t flowsPerLeaf = 1;    //!< TCP connections opened by each right leaf
+    std::string connectionGoodputFile; //!< Per-connection goodput output, empty for none
+    std::string telemetrySegment; //!< Shared-memory segment for live telemetry, empty for none
+    uint32_t l4sLeaves = 0;       //!< Leaf pairs whose connections use DCTCP with ECT(1)
+    bool profile = false;         //!< Print the simulator profile at Simulator::Destroy
+    std::string eventLog;         //!< Binary log of the bottleneck AQM events, empty for none
+    std::string shadows;          //!< Comma-separated shadow AQM types, empty for none
+    std::string captureArrivals;  //!< Binary trace of the bottleneck arrivals, empty for none
+    bool steadyState = false;     //!< Stop once the bottleneck is in steady state
+    double steadyTolerance = 0.1; //!< Relative tolerance of the steady-state windows
+    double steadyHoldTime = 5.0;  //!< Time (s) the windows must agree
+    std::string intervalStats;    //!< CSV of the bottleneck statistics per window, empty for none
+    double warmUp = 0;            //!< Time (s) excluded from the windowed statistics
+};
 
-    CommandLine cmd(__FILE__);
-    cmd.AddValue("nLeaf", "Number of left and right side leaf nodes", nLeaf);
-    cmd.AddValue("maxPackets", "Max Packets allowed in the device queue", maxPackets);
-    cmd.AddValue("queueDiscLimitPackets",
-                 "Max Packets allowed in the queue disc",
-                 queueDiscLimitPackets);
-    cmd.AddValue("queueDiscType", "Set Queue disc type to RED or ARED or Blue", queueDiscType);
-    cmd.AddValue("appPktSize", "Set OnOff App Packet Size", pktSize);
-    cmd.AddValue("appDataRate", "Set OnOff App DataRate", appDataRate);
-    cmd.AddValue("modeBytes", "Set Queue disc mode to Packets (false) or bytes (true)", modeBytes);
-    cmd.AddValue("redMinTh", "RED queue minimum threshold", minTh);
-    cmd.AddValue("redMaxTh", "RED queue maximum threshold", maxTh);
-    cmd.AddValue("redMidTh", "RED queue medium threshold", midTh);
-    cmd.AddValue("gamma", "DSRED gamma value", gamma);
-    // Add command-line values for BlueQueueDisc parameters
-    cmd.AddValue("blueIncrement", "Increment value for BlueQueueDisc marking probability", blueIncrement);
-    cmd.AddValue("blueDecrement", "Decrement value for BlueQueueDisc marking probability", blueDecrement);
-    cmd.AddValue("blueFreezeTime", "Freeze time before changing marking probability in BlueQueueDisc", blueFreezeTime);
-    cmd.Parse(argc, argv);
+/// Mask of the leaf address blocks of the fast topology, room for 2^20 leaves per side
+static const char* const FAST_LEAF_BLOCK_MASK = "255.192.0.0";
+
+/**
+ * Outcome of one dumbbell experiment
+ */
+struct ExperimentResult
+{
+    QueueDisc::Stats stats;   //!< Bottleneck queue disc statistics
+    SojournHistogram sojourn; //!< Bottleneck queue disc sojourn times
+    double goodput = 0;       //!< Aggregate goodput at the sinks (bps)
+    double p99QueueDelay = 0; //!< 99th percentile of the bottleneck sojourn time (s)
+    double jainIndex = 0;     //!< Jain fairness index of the per-connection goodputs
+    std::string hotPath;      //!< Hot-path counters of the bottleneck AQM, empty if not counted
+    AqmSteadyStateMonitor::Estimate steadyState; //!< Steady state, if monitored
+    AqmIntervalStats::Window afterWarmUp; //!< Bottleneck statistics after the warm-up, if windowed
+};
 
-    if ((queueDiscType != "RED") && (queueDiscType != "DSRED") && (queueDiscType != "Blue"))
+/**
+ * Install the AQM under test on both ends of the bottleneck link.
+ *
+ * With shadow AQMs, the AQM under test is the primary of a
+ * ShadowAqmQueueDisc whose shadows are served at the bottleneck rate.
+ *
+ * \param queueDiscType The queue disc type (RED, DSRED, Blue or DualQ).
+ * \param shadows Comma-separated types of the shadow AQMs, empty for none.
+ * \param linkRate The bottleneck link rate.
+ * \param left The bottleneck device of the left router.
+ * \param right The bottleneck device of the right router.
+ * \return The queue disc installed on the right router.
+ */
+QueueDiscContainer
+InstallBottleneckQueueDiscs(const std::string& queueDiscType,
+                            const std::string& shadows,
+                            const std::string& linkRate,
+                            Ptr<NetDevice> left,
+                            Ptr<NetDevice> right)
+{
+    std::string type;
+    if (queueDiscType == "RED")
     {
-        std::cout << "Invalid queue disc type: Use --queueDiscType=RED or --queueDiscType=DSRED or --queueDiscType=Blue"
-                  << std::endl;
-        exit(1);
+        type = "ns3::RedQueueDisc";
+    }
+    else if (queueDiscType == "DSRED")
+    {
+        type = "ns3::DsRedQueueDisc";
+    }
+    else if (queueDiscType == "Blue")
+    {
+        type = "ns3::BlueQueueDisc";
+    }
+    else if (queueDiscType == "DualQ")
+    {
+        // The classic queue is a RedQueueDisc configured like the RED runs
+        type = "ns3::DualQCoupledQueueDisc";
+    }
+    TrafficControlHelper tchBottleneck;
+    if (shadows.empty())
+    {
+        tchBottleneck.SetRootQueueDisc(type);
+    }
+    else
+    {
+        tchBottleneck.SetRootQueueDisc("ns3::ShadowAqmQueueDisc",
+                                       "PrimaryQueueDisc",
+                                       StringValue(type),
+                                       "ShadowQueueDiscs",
+                                       StringValue(shadows),
+                                       "LinkRate",
+                                       StringValue(linkRate));
+    }
+    tchBottleneck.Install(left);
+    return tchBottleneck.Install(right);
+}
+
+/**
+ * Report the time the bottleneck AQM spends enqueuing and dequeuing with the
+ * simulator profile. For DualQ, the classic RED queue is measured.
+ *
+ * \param bottleneck The bottleneck queue disc.
+ */
+void
+TrackBottleneckCycles(Ptr<QueueDisc> bottleneck)
+{
+    auto profiler = DynamicCast<ProfilingSimulatorImpl>(Simulator::GetImplementation());
+    if (Ptr<DualQCoupledQueueDisc> dualq = DynamicCast<DualQCoupledQueueDisc>(bottleneck))
+    {
+        bottleneck = dualq->GetQueueDiscClass(0)->GetQueueDisc();
+    }
+    if (Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(bottleneck))
+    {
+        profiler->Track("bottleneck RED enqueue", &red->GetEnqueueCycles());
+        profiler->Track("bottleneck RED dequeue", &red->GetDequeueCycles());
+    }
+    else if (Ptr<BlueQueueDisc> blue = DynamicCast<BlueQueueDisc>(bottleneck))
+    {
+        profiler->Track("bottleneck BLUE enqueue", &blue->GetEnqueueCycles());
+        profiler->Track("bottleneck BLUE dequeue", &blue->GetDequeueCycles());
     }
+}
 
-    Config::SetDefault("ns3::OnOffApplication::PacketSize", UintegerValue(pktSize));
-    Config::SetDefault("ns3::OnOffApplication::DataRate", StringValue(appDataRate));
+/**
+ * Build the dumbbell, run it and collect the bottleneck and flow statistics.
+ * The simulator is destroyed before returning, so experiments can be run
+ * back to back in the same process.
+ *
+ * \param config The experiment parameters.
+ * \param printFlows True to log the per-flow throughput and latency.
+ * \return The experiment outcome.
+ */
+ExperimentResult
+RunExperiment(ExperimentConfig config, bool printFlows)
+{
+    Config::SetDefault("ns3::OnOffApplication::PacketSize", UintegerValue(config.pktSize));
+    Config::SetDefault("ns3::OnOffApplication::DataRate", StringValue(config.appDataRate));
 
     Config::SetDefault("ns3::DropTailQueue<Packet>::MaxSize",
-                       StringValue(std::to_string(maxPackets) + "p"));
-    if (queueDiscType == "RED" || queueDiscType == "DSRED") {
-        if (!modeBytes)
+                       StringValue(std::to_string(config.maxPackets) + "p"));
+    Config::SetDefault("ns3::RedQueueDisc::ProfileCycles", BooleanValue(config.profile));
+    Config::SetDefault("ns3::BlueQueueDisc::ProfileCycles", BooleanValue(config.profile));
+    // Shadow AQMs are configured like the primary of their family would be
+    bool shadowRed = config.shadows.find("Red") != std::string::npos;
+    bool shadowBlue = config.shadows.find("Blue") != std::string::npos;
+    if (config.queueDiscType == "RED" || config.queueDiscType == "DSRED" ||
+        config.queueDiscType == "DualQ" || shadowRed) {
+        if (!config.modeBytes)
         {
             Config::SetDefault(
                 "ns3::RedQueueDisc::MaxSize",
-                QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+                QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, config.queueDiscLimitPackets)));
         }
         else
         {
             Config::SetDefault(
                 "ns3::RedQueueDisc::MaxSize",
-                QueueSizeValue(QueueSize(QueueSizeUnit::BYTES, queueDiscLimitPackets * pktSize)));
-            minTh *= pktSize;
-            maxTh *= pktSize;
+                QueueSizeValue(QueueSize(QueueSizeUnit::BYTES,
+                                         config.queueDiscLimitPackets * config.pktSize)));
+            config.minTh *= config.pktSize;
+            config.maxTh *= config.pktSize;
             // add blue logic that corresponds to this condition with bytes
         }
 
-        Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(minTh));
-        Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(maxTh));
-        Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(bottleNeckLinkBw));
-        Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(bottleNeckLinkDelay));
-        Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(pktSize));
-        Config::SetDefault("ns3::DsRedQueueDisc::MidThreshold", DoubleValue(midTh));
-        Config::SetDefault("ns3::DsRedQueueDisc::Gamma", DoubleValue(gamma));
+        Config::SetDefault("ns3::RedQueueDisc::MinTh", DoubleValue(config.minTh));
+        Config::SetDefault("ns3::RedQueueDisc::MaxTh", DoubleValue(config.maxTh));
+        Config::SetDefault("ns3::RedQueueDisc::LinkBandwidth", StringValue(config.bottleNeckLinkBw));
+        Config::SetDefault("ns3::RedQueueDisc::LinkDelay", StringValue(config.bottleNeckLinkDelay));
+        Config::SetDefault("ns3::RedQueueDisc::MeanPktSize", UintegerValue(config.pktSize));
+        Config::SetDefault("ns3::DsRedQueueDisc::MidThreshold", DoubleValue(config.midTh));
+        Config::SetDefault("ns3::DsRedQueueDisc::Gamma", DoubleValue(config.gamma));
 
     }
-    else if (queueDiscType == "Blue")
+    if (config.queueDiscType == "Blue" || shadowBlue)
     {
-        if (!modeBytes)
+        if (!config.modeBytes)
         {
             Config::SetDefault(
                 "ns3::BlueQueueDisc::MaxSize",
-                QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, queueDiscLimitPackets)));
+                QueueSizeValue(QueueSize(QueueSizeUnit::PACKETS, config.queueDiscLimitPackets)));
         }
         else
         {
             Config::SetDefault(
                 "ns3::BlueQueueDisc::MaxSize",
-                QueueSizeValue(QueueSize(QueueSizeUnit::BYTES, queueDiscLimitPackets * pktSize)));
+                QueueSizeValue(QueueSize(QueueSizeUnit::BYTES,
+                                         config.queueDiscLimitPackets * config.pktSize)));
         }
-        Config::SetDefault("ns3::BlueQueueDisc::Increment", DoubleValue(blueIncrement));  // Increase probability of marking
-        Config::SetDefault("ns3::BlueQueueDisc::Decrement", DoubleValue(blueDecrement));  // Decrease probability of marking
-        Config::SetDefault("ns3::BlueQueueDisc::FreezeTime", TimeValue(Seconds(blueFreezeTime))); // Time before probability change
+        Config::SetDefault("ns3::BlueQueueDisc::Increment", DoubleValue(config.blueIncrement));  // Increase probability of marking
+        Config::SetDefault("ns3::BlueQueueDisc::Decrement", DoubleValue(config.blueDecrement));  // Decrease probability of marking
+        Config::SetDefault("ns3::BlueQueueDisc::FreezeTime", TimeValue(Seconds(config.blueFreezeTime))); // Time before probability change
     }
 
     // Create the point-to-point link helpers
     PointToPointHelper bottleNeckLink;
-    bottleNeckLink.SetDeviceAttribute("DataRate", StringValue(bottleNeckLinkBw));
-    bottleNeckLink.SetChannelAttribute("Delay", StringValue(bottleNeckLinkDelay));
+    bottleNeckLink.SetDeviceAttribute("DataRate", StringValue(config.bottleNeckLinkBw));
+    bottleNeckLink.SetChannelAttribute("Delay", StringValue(config.bottleNeckLinkDelay));
 
     PointToPointHelper pointToPointLeaf;
     pointToPointLeaf.SetDeviceAttribute("DataRate", StringValue("10Mbps"));
     pointToPointLeaf.SetChannelAttribute("Delay", StringValue("1ms"));
 
-    PointToPointDumbbellHelper d(nLeaf, pointToPointLeaf, nLeaf, pointToPointLeaf, bottleNeckLink);
+    // The rest of the experiment only needs the leaves, the sink addresses
+    // and the bottleneck queue disc
+    NodeContainer leftLeaves;
+    NodeContainer rightLeaves;
+    std::vector<Ipv4Address> leftAddresses;
+    QueueDiscContainer queueDiscs;
+    auto setupStart = std::chrono::steady_clock::now();
 
-    // Install Stack
-    InternetStackHelper stack;
-    for (uint32_t i = 0; i < d.LeftCount(); ++i)
+    if (config.fastTopology)
     {
-        stack.Install(d.GetLeft(i));
+        // IPv4-only stack, no default queue discs on the leaf links and
+        // static routes; the leaf blocks leave room for a million leaves
+        ScalableDumbbellHelper d(config.nLeaf,
+                                 pointToPointLeaf,
+                                 config.nLeaf,
+                                 pointToPointLeaf,
+                                 bottleNeckLink);
+        d.InstallStack();
+        queueDiscs = InstallBottleneckQueueDiscs(config.queueDiscType,
+                                                 config.shadows,
+                                                 config.bottleNeckLinkBw,
+                                                 d.GetLeft()->GetDevice(0),
+                                                 d.GetRight()->GetDevice(0));
+        d.AssignIpv4Addresses(Ipv4Address("10.0.0.0"),
+                              Ipv4Address("10.64.0.0"),
+                              Ipv4Mask(FAST_LEAF_BLOCK_MASK),
+                              Ipv4Address("10.128.0.0"));
+        for (uint32_t i = 0; i < d.LeftCount(); ++i)
+        {
+            leftLeaves.Add(d.GetLeft(i));
+            leftAddresses.push_back(d.GetLeftIpv4Address(i));
+        }
+        for (uint32_t i = 0; i < d.RightCount(); ++i)
+        {
+            rightLeaves.Add(d.GetRight(i));
+        }
     }
-    for (uint32_t i = 0; i < d.RightCount(); ++i)
+    else
     {
-        stack.Install(d.GetRight(i));
-    }
+        PointToPointDumbbellHelper d(config.nLeaf,
+                                     pointToPointLeaf,
+                                     config.nLeaf,
+                                     pointToPointLeaf,
+                                     bottleNeckLink);
 
-    stack.Install(d.GetLeft());
-    stack.Install(d.GetRight());
-    TrafficControlHelper tchBottleneck;
-    QueueDiscContainer queueDiscs;
+        // Install Stack
+        InternetStackHelper stack;
+        for (uint32_t i = 0; i < d.LeftCount(); ++i)
+        {
+            stack.Install(d.GetLeft(i));
+        }
+        for (uint32_t i = 0; i < d.RightCount(); ++i)
+        {
+            stack.Install(d.GetRight(i));
+        }
 
-    if (queueDiscType == "RED")
-    {
-        tchBottleneck.SetRootQueueDisc("ns3::RedQueueDisc");
+        stack.Install(d.GetLeft());
+        stack.Install(d.GetRight());
+        queueDiscs = InstallBottleneckQueueDiscs(config.queueDiscType,
+                                                 config.shadows,
+                                                 config.bottleNeckLinkBw,
+                                                 d.GetLeft()->GetDevice(0),
+                                                 d.GetRight()->GetDevice(0));
+
+        // Assign IP Addresses
+        d.AssignIpv4Addresses(Ipv4AddressHelper("10.1.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.2.1.0", "255.255.255.0"),
+                              Ipv4AddressHelper("10.3.1.0", "255.255.255.0"));
+        for (uint32_t i = 0; i < d.LeftCount(); ++i)
+        {
+            leftLeaves.Add(d.GetLeft(i));
+            leftAddresses.push_back(d.GetLeftIpv4Address(i));
+        }
+        for (uint32_t i = 0; i < d.RightCount(); ++i)
+        {
+            rightLeaves.Add(d.GetRight(i));
+        }
+
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     }
-    else if (queueDiscType == "DSRED")
+
+    if (printFlows)
     {
-        tchBottleneck.SetRootQueueDisc("ns3::DsRedQueueDisc");
+        double setupTime =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+        std::cout << "Topology set up in " << setupTime << " s, peak RSS "
+                  << ScalableDumbbellHelper::GetPeakRss() / 1024.0 << " MiB" << std::endl;
     }
-    else if (queueDiscType == "Blue")
+
+    if (config.l4sLeaves > 0)
     {
-        tchBottleneck.SetRootQueueDisc("ns3::BlueQueueDisc");
+        // ECT(1) senders and their sinks run DCTCP, every other connection
+        // stays classic (ECT(0), which the classic AQM drops rather than marks)
+        Config::SetDefault("ns3::TcpSocketBase::UseEcn", StringValue("On"));
+        Config::SetDefault("ns3::TcpDctcp::UseEct0", BooleanValue(false));
+        for (uint32_t i = 0; i < std::min(config.l4sLeaves, rightLeaves.GetN()); ++i)
+        {
+            for (Ptr<Node> node : {rightLeaves.Get(i), leftLeaves.Get(i)})
+            {
+                node->GetObject<TcpL4Protocol>()->SetAttribute(
+                    "SocketType",
+                    TypeIdValue(TcpDctcp::GetTypeId()));
+            }
+        }
     }
-    tchBottleneck.Install(d.GetLeft()->GetDevice(0));
-    queueDiscs = tchBottleneck.Install(d.GetRight()->GetDevice(0));
-
-    // Assign IP Addresses
-    d.AssignIpv4Addresses(Ipv4AddressHelper("10.1.1.0", "255.255.255.0"),
-                          Ipv4AddressHelper("10.2.1.0", "255.255.255.0"),
-                          Ipv4AddressHelper("10.3.1.0", "255.255.255.0"));
 
     // Install on/off app on all right side nodes
     OnOffHelper clientHelper("ns3::TcpSocketFactory", Address());
     clientHelper.SetAttribute("OnTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
     clientHelper.SetAttribute("OffTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
-    Address sinkLocalAddress(InetSocketAddress(Ipv4Address::GetAny(), port));
+    Address sinkLocalAddress(InetSocketAddress(Ipv4Address::GetAny(), config.port));
     PacketSinkHelper packetSinkHelper("ns3::TcpSocketFactory", sinkLocalAddress);
     ApplicationContainer sinkApps;
-    for (uint32_t i = 0; i < d.LeftCount(); ++i)
+    sinkApps.Add(packetSinkHelper.Install(leftLeaves));
+    sinkApps.Start(Seconds(0.0));
+    sinkApps.Stop(Seconds(config.stopTime));
+
+    ConnectionGoodputCollector connections;
+    for (uint32_t i = 0; i < sinkApps.GetN(); ++i)
     {
-        sinkApps.Add(packetSinkHelper.Install(d.GetLeft(i)));
+        connections.Attach(DynamicCast<PacketSink>(sinkApps.Get(i)));
     }
-    sinkApps.Start(Seconds(0.0));
-    sinkApps.Stop(Seconds(30.0));
 
     ApplicationContainer clientApps;
-    for (uint32_t i = 0; i < d.RightCount(); ++i)
+    for (uint32_t i = 0; i < rightLeaves.GetN(); ++i)
     {
         // Create an on/off app sending packets to the left side
-        AddressValue remoteAddress(InetSocketAddress(d.GetLeftIpv4Address(i), port));
-        clientHelper.SetAttribute("Remote", remoteAddress);
-        clientApps.Add(clientHelper.Install(d.GetRight(i)));
+        AddressValue remoteAddress(InetSocketAddress(leftAddresses[i], config.port));
+        if (config.flowsPerLeaf == 1)
+        {
+            clientHelper.SetAttribute("Remote", remoteAddress);
+            clientApps.Add(clientHelper.Install(rightLeaves.Get(i)));
+            continue;
+        }
+        // Many on/off connections share the node, each with its own timing
+        Ptr<MultiFlowOnOffApplication> app = CreateObject<MultiFlowOnOffApplication>();
+        app->SetAttribute("Remote", remoteAddress);
+        app->SetAttribute("NFlows", UintegerValue(config.flowsPerLeaf));
+        app->SetAttribute("DataRate", StringValue(config.appDataRate));
+        app->SetAttribute("PacketSize", UintegerValue(config.pktSize));
+        app->SetAttribute("OnTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+        app->SetAttribute("OffTime", StringValue("ns3::UniformRandomVariable[Min=0.|Max=1.]"));
+        rightLeaves.Get(i)->AddApplication(app);
+        clientApps.Add(app);
     }
     clientApps.Start(Seconds(1.0)); // Start 1 second after sink
-    clientApps.Stop(Seconds(15.0)); // Stop before the sink
-
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    clientApps.Stop(Seconds(config.clientStopTime)); // Stop before the sink
 
     // Flow monitor to capture throughput and latency
     FlowMonitorHelper flowmon;
     Ptr<FlowMonitor> monitor = flowmon.InstallAll();
 
-    std::cout << "Running the simulation" << std::endl;
-    Simulator::Stop(Seconds(30.0));
+    // The AQM under test, the primary if shadow AQMs judge the same traffic
+    Ptr<QueueDisc> aqm = queueDiscs.Get(0);
+    Ptr<ShadowAqmQueueDisc> shadowAqm = DynamicCast<ShadowAqmQueueDisc>(aqm);
+    if (shadowAqm)
+    {
+        aqm = shadowAqm->GetPrimary();
+    }
+
+    if (!config.telemetrySegment.empty())
+    {
+        // Kept alive by the simulator until Simulator::Destroy
+        Ptr<AqmTelemetry> telemetry = CreateObjectWithAttributes<AqmTelemetry>(
+            "SegmentName", StringValue(config.telemetrySegment));
+        telemetry->Start(aqm);
+    }
+
+    if (!config.eventLog.empty())
+    {
+        // Closed by the simulator at Simulator::Destroy
+        Ptr<AqmEventLog> eventLog =
+            CreateObjectWithAttributes<AqmEventLog>("FileName", StringValue(config.eventLog));
+        eventLog->Start(aqm);
+    }
+
+    if (!config.captureArrivals.empty())
+    {
+        // Closed by the simulator at Simulator::Destroy
+        Ptr<AqmArrivalCapture> capture = CreateObjectWithAttributes<AqmArrivalCapture>(
+            "FileName", StringValue(config.captureArrivals),
+            "LinkRate", StringValue(config.bottleNeckLinkBw));
+        capture->Start(aqm);
+    }
+
+    Ptr<AqmIntervalStats> intervalStats;
+    if (!config.intervalStats.empty() || config.warmUp > 0)
+    {
+        intervalStats = CreateObjectWithAttributes<AqmIntervalStats>(
+            "FileName", StringValue(config.intervalStats),
+            "WarmUp", TimeValue(Seconds(config.warmUp)));
+        intervalStats->Start(aqm);
+    }
+
+    Ptr<AqmSteadyStateMonitor> steadyState;
+    if (config.steadyState)
+    {
+        // Judged while the clients send, stopping the simulator once steady
+        steadyState = CreateObjectWithAttributes<AqmSteadyStateMonitor>(
+            "StartTime", TimeValue(Seconds(1.0)),
+            "EndTime", TimeValue(Seconds(config.clientStopTime)),
+            "Tolerance", DoubleValue(config.steadyTolerance),
+            "HoldTime", TimeValue(Seconds(config.steadyHoldTime)));
+        for (uint32_t i = 0; i < sinkApps.GetN(); ++i)
+        {
+            sinkApps.Get(i)->TraceConnectWithoutContext(
+                "Rx",
+                MakeCallback(&AqmSteadyStateMonitor::Delivered, steadyState));
+        }
+        steadyState->Start(aqm);
+    }
+
+    if (config.profile)
+    {
+        TrackBottleneckCycles(aqm);
+    }
+
+    if (printFlows)
+    {
+        std::cout << "Running the simulation" << std::endl;
+    }
+    Simulator::Stop(Seconds(config.stopTime));
     Simulator::Run();
 
+    ExperimentResult result;
+
     // Collect flow stats
     monitor->CheckForLostPackets();
     Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
     FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats();
     for (auto it = stats.begin(); it != stats.end(); ++it)
     {
-        Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(it->first);
-        NS_LOG_INFO("Flow " << it->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")");
-        double throughput = (it->second.rxBytes * 8.0) / (it->second.timeLastRxPacket.GetSeconds() - it->second.timeFirstTxPacket.GetSeconds()) / 1e6;
-        double latency = it->second.delaySum.GetSeconds() / it->second.rxPackets;
-        NS_LOG_INFO("  Throughput: " << throughput << " Mbps");
-        NS_LOG_INFO("  Latency: " << latency * 1000 << " ms");
+        if (printFlows)
+        {
+            Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(it->first);
+            NS_LOG_INFO("Flow " << it->first << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")");
+            double throughput = (it->second.rxBytes * 8.0) / (it->second.timeLastRxPacket.GetSeconds() - it->second.timeFirstTxPacket.GetSeconds()) / 1e6;
+            double latency = it->second.delaySum.GetSeconds() / it->second.rxPackets;
+            NS_LOG_INFO("  Throughput: " << throughput << " Mbps");
+            NS_LOG_INFO("  Latency: " << latency * 1000 << " ms");
+        }
+    }
+
+    // The queue disc measures the queueing delay itself
+    Ptr<QueueDisc> bottleneck = aqm;
+    std::ostringstream hotPath;
+    if (Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(bottleneck))
+    {
+        result.sojourn = red->GetSojournHistogram();
+        if (red->GetHotPathCounters().enabled)
+        {
+            hotPath << red->GetHotPathCounters();
+        }
+    }
+    else if (Ptr<BlueQueueDisc> blue = DynamicCast<BlueQueueDisc>(bottleneck))
+    {
+        result.sojourn = blue->GetSojournHistogram();
+        if (blue->GetHotPathCounters().enabled)
+        {
+            hotPath << blue->GetHotPathCounters();
+        }
+    }
+    else if (Ptr<DualQCoupledQueueDisc> dualq = DynamicCast<DualQCoupledQueueDisc>(bottleneck))
+    {
+        // The RED parameters being evaluated shape the classic queue
+        auto classic = DynamicCast<RedQueueDisc>(dualq->GetQueueDiscClass(0)->GetQueueDisc());
+        result.sojourn = classic->GetSojournHistogram();
+        if (printFlows)
+        {
+            dualq->PrintAqmStats(std::cout);
+        }
+    }
+    if (shadowAqm && printFlows)
+    {
+        shadowAqm->PrintAqmStats(std::cout);
+    }
+    result.p99QueueDelay = result.sojourn.GetPercentile(99).GetSeconds();
+    result.hotPath = hotPath.str();
+
+    if (steadyState)
+    {
+        result.steadyState = steadyState->GetEstimate();
+    }
+    if (intervalStats)
+    {
+        // Close the last, possibly short, window
+        intervalStats->Stop();
+        result.afterWarmUp = intervalStats->GetTotal();
+    }
+
+    // The clients were active until they stopped or the steady state ended the run
+    double sum = 0;
+    double activeTime = std::min(Simulator::Now().GetSeconds(), config.clientStopTime) - 1.0;
+    for (uint32_t i = 0; i < sinkApps.GetN(); ++i)
+    {
+        sum += DynamicCast<PacketSink>(sinkApps.Get(i))->GetTotalRx() * 8.0 / activeTime;
+    }
+    result.goodput = sum;
+    result.jainIndex = connections.GetJainIndex(rightLeaves.GetN() * config.flowsPerLeaf);
+    if (!config.connectionGoodputFile.empty())
+    {
+        std::ofstream out(config.connectionGoodputFile, std::ios::out);
+        connections.Print(out, activeTime);
+    }
+    result.stats = bottleneck->GetStats();
+
+    if (printFlows)
+    {
+        std::cout << "Destroying the simulation" << std::endl;
+    }
+    Simulator::Destroy();
+    return result;
+}
+
+/**
+ * AQM parameters explored by the optimiser, with their search ranges
+ */
+struct SearchDimension
+{
+    std::string name;                  //!< Command line name of the parameter
+    double ExperimentConfig::*field;   //!< Field of the ExperimentConfig being searched
+    double lo;                         //!< Lower bound
+    double hi;                         //!< Upper bound
+    bool logScale;                     //!< True to sample the range log-uniformly
+};
+
+/**
+ * Parse a "lo:hi" range.
+ *
+ * \param spec The range specification.
+ * \return The lower and upper bounds.
+ */
+std::pair<double, double>
+ParseRange(const std::string& spec)
+{
+    auto colon = spec.find(':');
+    NS_ABORT_MSG_IF(colon == std::string::npos, "Range must be lo:hi, got " << spec);
+    return {std::stod(spec.substr(0, colon)), std::stod(spec.substr(colon + 1))};
+}
+
+/**
+ * Describe every field of a scenario that affects its outcome, so that
+ * cached evaluations are only reused for the very same simulation. Output
+ * files and diagnostics (telemetry, profile, logs, captures) are left out.
+ *
+ * \param config The scenario.
+ * \param seed The simulation seed.
+ * \return The cache key of the scenario.
+ */
+std::string
+ScenarioKey(const ExperimentConfig& config, uint32_t seed)
+{
+    std::stringstream key;
+    key << std::setprecision(10) << config.queueDiscType << " seed=" << seed
+        << " nLeaf=" << config.nLeaf << " flowsPerLeaf=" << config.flowsPerLeaf
+        << " l4sLeaves=" << config.l4sLeaves << " fastTopology=" << config.fastTopology
+        << " bw=" << config.bottleNeckLinkBw << " delay=" << config.bottleNeckLinkDelay
+        << " maxPackets=" << config.maxPackets << " limit=" << config.queueDiscLimitPackets
+        << " modeBytes=" << config.modeBytes << " pktSize=" << config.pktSize
+        << " appDataRate=" << config.appDataRate << " port=" << config.port
+        << " shadows=" << config.shadows << " steadyState=" << config.steadyState
+        << " steadyTolerance=" << config.steadyTolerance
+        << " steadyHoldTime=" << config.steadyHoldTime << " warmUp=" << config.warmUp
+        << " clientStop=" << config.clientStopTime << " stop=" << config.stopTime
+        << " minTh=" << config.minTh << " midTh=" << config.midTh << " maxTh=" << config.maxTh
+        << " gamma=" << config.gamma << " blueIncrement=" << config.blueIncrement
+        << " blueDecrement=" << config.blueDecrement
+        << " blueFreezeTime=" << config.blueFreezeTime;
+    return key.str();
+}
+
+/**
+ * Combine goodput, p99 queueing delay and fairness into a single cost to be
+ * minimised.
+ */
+struct Objective
+{
+    double goodputWeight = 1.0;  //!< Weight of the normalised goodput
+    double delayWeight = 1.0;    //!< Weight of the normalised p99 queueing delay
+    double fairnessWeight = 1.0; //!< Weight of the Jain index
+    double delayReference = 0.1; //!< p99 queueing delay (s) that costs delayWeight
+    double capacity = 1e6;       //!< Bottleneck capacity used to normalise goodput (bps)
+
+    /**
+     * \param r The experiment outcome.
+     * \return The cost of the outcome, lower is better.
+     */
+    double Cost(const ExperimentResult& r) const
+    {
+        return -goodputWeight * r.goodput / capacity +
+               delayWeight * r.p99QueueDelay / delayReference - fairnessWeight * r.jainIndex;
+    }
+};
+
+/**
+ * Local store of completed evaluations, so interrupted or repeated searches
+ * do not pay for the same simulation twice.
+ */
+class EvaluationCache
+{
+  public:
+    /**
+     * \param path File backing the cache; empty to disable it.
+     */
+    explicit EvaluationCache(const std::string& path)
+        : m_path(path)
+    {
+        std::ifstream in(m_path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            auto tab = line.rfind('\t');
+            if (tab == std::string::npos)
+            {
+                continue;
+            }
+            std::stringstream values(line.substr(tab + 1));
+            ExperimentResult r;
+            values >> r.goodput >> r.p99QueueDelay >> r.jainIndex;
+            m_entries[line.substr(0, tab)] = r;
+        }
+    }
+
+    /**
+     * \param key The evaluation key.
+     * \param result Set to the cached outcome if present.
+     * \return True if the evaluation is cached.
+     */
+    bool Lookup(const std::string& key, ExperimentResult& result) const
+    {
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+        {
+            return false;
+        }
+        result = it->second;
+        return true;
+    }
+
+    /**
+     * \param key The evaluation key.
+     * \param result The outcome to store.
+     */
+    void Store(const std::string& key, const ExperimentResult& result)
+    {
+        m_entries[key] = result;
+        if (!m_path.empty())
+        {
+            std::ofstream out(m_path, std::ios::out | std::ios::app);
+            out << key << "\t" << std::setprecision(10) << result.goodput << " "
+                << result.p99QueueDelay << " " << result.jainIndex << std::endl;
+        }
+    }
+
+  private:
+    std::string m_path;                              //!< Backing file
+    std::map<std::string, ExperimentResult> m_entries; //!< Cached outcomes by key
+};
+
+/**
+ * Tell whether the thresholds of a configuration can be simulated: RED and
+ * DualQ need minTh < maxTh, and DSRED also minTh < midTh < maxTh.
+ *
+ * \param config The configuration.
+ * \return True if the thresholds are strictly ordered.
+ */
+bool
+HasOrderedThresholds(const ExperimentConfig& config)
+{
+    if (config.queueDiscType == "Blue")
+    {
+        return true;
     }
+    if (config.minTh >= config.maxTh)
+    {
+        return false;
+    }
+    return config.queueDiscType != "DSRED" ||
+           (config.minTh < config.midTh && config.midTh < config.maxTh);
+}
+
+/**
+ * Search the AQM parameters of the configured queue disc by successive
+ * halving: many random candidates are simulated for a short time, and only
+ * the best fraction is promoted to a longer (eta times) simulation, until
+ * the full client duration is reached. Candidates whose thresholds are not
+ * strictly ordered are redrawn, so none is simulated or cached.
+ *
+ * \param base The scenario; its AQM parameters are overwritten by the search.
+ * \param dims The searched parameters and their ranges.
+ * \param objective The cost function.
+ * \param nCandidates Number of candidates of the first rung.
+ * \param eta Promotion ratio between rungs.
+ * \param minBudget Client active time (s) of the first rung.
+ * \param cache The evaluation cache.
+ * \param seed Seed of the candidate sampling and of the simulations.
+ */
+void
+RunOptimiser(ExperimentConfig base,
+             std::vector<SearchDimension> dims,
+             const Objective& objective,
+             uint32_t nCandidates,
+             uint32_t eta,
+             double minBudget,
+             EvaluationCache& cache,
+             uint32_t seed)
+{
+    Ptr<UniformRandomVariable> uv = CreateObject<UniformRandomVariable>();
+    uv->SetStream(seed);
 
-    QueueDisc::Stats st = queueDiscs.Get(0)->GetStats();
+    struct Candidate
+    {
+        std::vector<double> values;
+        double cost;
+        ExperimentResult result;
+    };
 
-    if (queueDiscType == "RED" || queueDiscType == "ARED") {
+    const uint32_t maxDraws = 1000;
+    std::vector<Candidate> candidates(nCandidates);
+    for (auto& c : candidates)
+    {
+        ExperimentConfig config = base;
+        uint32_t draws = 0;
+        do
+        {
+            NS_ABORT_MSG_IF(draws++ == maxDraws,
+                            "No ordered thresholds in " << maxDraws
+                                                        << " draws, check the --optRed* ranges");
+            c.values.clear();
+            for (const auto& dim : dims)
+            {
+                double u = uv->GetValue();
+                double value = dim.logScale ? std::exp(std::log(dim.lo) +
+                                                       u * (std::log(dim.hi) - std::log(dim.lo)))
+                                            : dim.lo + u * (dim.hi - dim.lo);
+                config.*(dim.field) = value;
+                c.values.push_back(value);
+            }
+        } while (!HasOrderedThresholds(config));
+    }
+
+    double fullBudget = base.clientStopTime - 1.0;
+    double budget = std::min(minBudget, fullBudget);
+    uint32_t simulated = 0;
+    uint32_t cached = 0;
+    while (true)
+    {
+        for (auto& c : candidates)
+        {
+            ExperimentConfig config = base;
+            std::stringstream values;
+            values << std::setprecision(10);
+            for (std::size_t i = 0; i < dims.size(); ++i)
+            {
+                config.*(dims[i].field) = c.values[i];
+                values << " " << dims[i].name << "=" << c.values[i];
+            }
+            config.clientStopTime = 1.0 + budget;
+            config.stopTime = config.clientStopTime + 1.0;
+
+            std::string key = ScenarioKey(config, seed);
+            if (cache.Lookup(key, c.result))
+            {
+                cached++;
+            }
+            else
+            {
+                SeedManager::SetSeed(seed);
+                SeedManager::SetRun(1);
+                c.result = RunExperiment(config, false);
+                cache.Store(key, c.result);
+                simulated++;
+            }
+            c.cost = objective.Cost(c.result);
+            std::cout << "budget " << budget << "s cost " << c.cost << " goodput "
+                      << c.result.goodput / 1e6 << " Mbps p99 " << c.result.p99QueueDelay * 1000
+                      << " ms jain " << c.result.jainIndex << " :" << values.str() << std::endl;
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+            return a.cost < b.cost;
+        });
+
+        if (budget >= fullBudget || candidates.size() == 1)
+        {
+            break;
+        }
+        // Stop the unpromising candidates and give the rest a longer run
+        candidates.resize(std::max<std::size_t>(1, candidates.size() / eta));
+        budget = std::min(budget * eta, fullBudget);
+    }
+
+    const Candidate& best = candidates.front();
+    std::cout << "*** Best " << base.queueDiscType << " parameters (" << simulated
+              << " simulations, " << cached << " cache hits) ***" << std::endl;
+    std::cout << "cost " << best.cost << " goodput " << best.result.goodput / 1e6 << " Mbps p99 "
+              << best.result.p99QueueDelay * 1000 << " ms jain " << best.result.jainIndex
+              << std::endl;
+    std::cout << "--queueDiscType=" << base.queueDiscType;
+    for (std::size_t i = 0; i < dims.size(); ++i)
+    {
+        std::cout << " --" << dims[i].name << "=" << best.values[i];
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    LogComponentEnable("BlueAqmExample", LOG_LEVEL_INFO);
+    LogComponentEnable("BlueQueueDisc", LOG_LEVEL_INFO);
+    ExperimentConfig config;
+    // Optimiser mode
+    bool optimise = false;
+    uint32_t optCandidates = 27;
+    uint32_t optEta = 3;
+    double optMinBudget = 2.0;
+    uint32_t optSeed = 1;
+    std::string optCache = "aqm_optimiser_cache.txt";
+    std::string optBlueIncrement = "0.001:0.1";
+    std::string optBlueDecrement = "0.0001:0.01";
+    std::string optBlueFreezeTime = "0.01:0.5";
+    std::string optRedMinTh = "2:30";
+    std::string optRedMidTh = "5:60";
+    std::string optRedMaxTh = "10:90";
+    std::string optGamma = "0.05:0.95";
+    Objective objective;
+    bool pooledAllocator = false;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nLeaf", "Number of left and right side leaf nodes", config.nLeaf);
+    cmd.AddValue("maxPackets", "Max Packets allowed in the device queue", config.maxPackets);
+    cmd.AddValue("queueDiscLimitPackets",
+                 "Max Packets allowed in the queue disc",
+                 config.queueDiscLimitPackets);
+    cmd.AddValue("queueDiscType", "Set Queue disc type to RED or ARED or Blue or DualQ", config.queueDiscType);
+    cmd.AddValue("appPktSize", "Set OnOff App Packet Size", config.pktSize);
+    cmd.AddValue("appDataRate", "Set OnOff App DataRate", config.appDataRate);
+    cmd.AddValue("modeBytes", "Set Queue disc mode to Packets (false) or bytes (true)", config.modeBytes);
+    cmd.AddValue("redMinTh", "RED queue minimum threshold", config.minTh);
+    cmd.AddValue("redMaxTh", "RED queue maximum threshold", config.maxTh);
+    cmd.AddValue("redMidTh", "RED queue medium threshold", config.midTh);
+    cmd.AddValue("gamma", "DSRED gamma value", config.gamma);
+    // Add command-line values for BlueQueueDisc parameters
+    cmd.AddValue("blueIncrement", "Increment value for BlueQueueDisc marking probability", config.blueIncrement);
+    cmd.AddValue("blueDecrement", "Decrement value for BlueQueueDisc marking probability", config.blueDecrement);
+    cmd.AddValue("blueFreezeTime", "Freeze time before changing marking probability in BlueQueueDisc", config.blueFreezeTime);
+    cmd.AddValue("fastTopology", "Build the dumbbell with static routes and an IPv4-only stack", config.fastTopology);
+    cmd.AddValue("flowsPerLeaf", "TCP connections with independent on/off timing per right leaf", config.flowsPerLeaf);
+    cmd.AddValue("connectionGoodputFile", "File for the goodput (bps) of every connection", config.connectionGoodputFile);
+    cmd.AddValue("pooledAllocator", "Recycle small per-packet objects through free lists", pooledAllocator);
+    cmd.AddValue("telemetry", "Shared-memory segment (e.g. /aqm) to publish the AQM state to", config.telemetrySegment);
+    cmd.AddValue("l4sLeaves", "Leaf pairs whose connections use DCTCP with ECT(1)", config.l4sLeaves);
+    cmd.AddValue("profile", "Print events and time per event type and in the bottleneck AQM", config.profile);
+    cmd.AddValue("eventLog", "Binary file for the drops, marks and probability updates of the bottleneck AQM", config.eventLog);
+    cmd.AddValue("shadows", "Comma-separated AQM types (e.g. ns3::RedQueueDisc) judging the bottleneck traffic alongside the AQM under test", config.shadows);
+    cmd.AddValue("captureArrivals", "Binary file for the bottleneck arrivals, replayed by aqm_replay", config.captureArrivals);
+    cmd.AddValue("steadyState", "Stop the run once the bottleneck queue, drop probability and goodput are steady", config.steadyState);
+    cmd.AddValue("steadyTolerance", "Relative tolerance of the steady-state windows", config.steadyTolerance);
+    cmd.AddValue("steadyHoldTime", "Time (s) the windows must agree before the run stops", config.steadyHoldTime);
+    cmd.AddValue("intervalStats", "CSV file for the bottleneck statistics of every 1 s window", config.intervalStats);
+    cmd.AddValue("warmUp", "Time (s) excluded from the windowed bottleneck statistics", config.warmUp);
+    // Optimiser mode
+    cmd.AddValue("optimise", "Search the AQM parameters instead of running once", optimise);
+    cmd.AddValue("optCandidates", "Number of random candidates of the first rung", optCandidates);
+    cmd.AddValue("optEta", "Fraction (1/eta) of candidates promoted to each longer rung", optEta);
+    cmd.AddValue("optMinBudget", "Client active time (s) of the first rung", optMinBudget);
+    cmd.AddValue("optSeed", "Seed of the search and of the simulations it runs", optSeed);
+    cmd.AddValue("optCache", "Evaluation cache file, empty to disable", optCache);
+    cmd.AddValue("optBlueIncrement", "Search range (lo:hi) of blueIncrement", optBlueIncrement);
+    cmd.AddValue("optBlueDecrement", "Search range (lo:hi) of blueDecrement", optBlueDecrement);
+    cmd.AddValue("optBlueFreezeTime", "Search range (lo:hi) of blueFreezeTime", optBlueFreezeTime);
+    cmd.AddValue("optRedMinTh", "Search range (lo:hi) of redMinTh", optRedMinTh);
+    cmd.AddValue("optRedMidTh", "Search range (lo:hi) of redMidTh", optRedMidTh);
+    cmd.AddValue("optRedMaxTh", "Search range (lo:hi) of redMaxTh", optRedMaxTh);
+    cmd.AddValue("optGamma", "Search range (lo:hi) of gamma", optGamma);
+    cmd.AddValue("objGoodputWeight", "Objective weight of the normalised goodput", objective.goodputWeight);
+    cmd.AddValue("objDelayWeight", "Objective weight of the p99 queueing delay", objective.delayWeight);
+    cmd.AddValue("objFairnessWeight", "Objective weight of the Jain fairness index", objective.fairnessWeight);
+    cmd.AddValue("objDelayReference", "p99 queueing delay (s) normalising the delay term", objective.delayReference);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(optimise && optEta < 2, "--optEta must be at least 2 for the rungs to shrink");
+    NS_ABORT_MSG_IF(optimise && optMinBudget <= 0, "--optMinBudget must be positive");
+    NS_ABORT_MSG_IF(pooledAllocator && !PooledAllocator::IsAvailable(),
+                    "--pooledAllocator needs a build configured with NS3_POOLED_ALLOCATOR");
+    PooledAllocator::Enable(pooledAllocator);
+    if (config.profile)
+    {
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::ProfilingSimulatorImpl"));
+    }
+
+    if ((config.queueDiscType != "RED") && (config.queueDiscType != "DSRED") && (config.queueDiscType != "Blue") &&
+        (config.queueDiscType != "DualQ"))
+    {
+        std::cout << "Invalid queue disc type: Use --queueDiscType=RED or --queueDiscType=DSRED or --queueDiscType=Blue"
+                  << " or --queueDiscType=DualQ" << std::endl;
+        exit(1);
+    }
+    NS_ABORT_MSG_IF(config.fastTopology &&
+                        config.nLeaf >
+                            ScalableDumbbellHelper::GetMaxLeaves(Ipv4Mask(FAST_LEAF_BLOCK_MASK)),
+                    "--nLeaf exceeds the "
+                        << ScalableDumbbellHelper::GetMaxLeaves(Ipv4Mask(FAST_LEAF_BLOCK_MASK))
+                        << " leaves a fast topology leaf block can address");
+
+    if (optimise)
+    {
+        std::vector<SearchDimension> dims;
+        auto addDim = [&dims](const std::string& name,
+                              double ExperimentConfig::*field,
+                              const std::string& range,
+                              bool logScale) {
+            auto [lo, hi] = ParseRange(range);
+            dims.push_back({name, field, lo, hi, logScale});
+        };
+        if (config.queueDiscType == "Blue")
+        {
+            addDim("blueIncrement", &ExperimentConfig::blueIncrement, optBlueIncrement, true);
+            addDim("blueDecrement", &ExperimentConfig::blueDecrement, optBlueDecrement, true);
+            addDim("blueFreezeTime", &ExperimentConfig::blueFreezeTime, optBlueFreezeTime, true);
+        }
+        else
+        {
+            addDim("redMinTh", &ExperimentConfig::minTh, optRedMinTh, false);
+            addDim("redMaxTh", &ExperimentConfig::maxTh, optRedMaxTh, false);
+            if (config.queueDiscType == "DSRED")
+            {
+                addDim("redMidTh", &ExperimentConfig::midTh, optRedMidTh, false);
+                addDim("gamma", &ExperimentConfig::gamma, optGamma, false);
+            }
+        }
+        objective.capacity = DataRate(config.bottleNeckLinkBw).GetBitRate();
+        EvaluationCache cache(optCache);
+        RunOptimiser(config, dims, objective, optCandidates, optEta, optMinBudget, cache, optSeed);
+        if (pooledAllocator)
+        {
+            PooledAllocator::PrintStats(std::cout);
+        }
+        return 0;
+    }
+
+    SeedManager::SetSeed(time(0));
+    ExperimentResult result = RunExperiment(config, true);
+    QueueDisc::Stats st = result.stats;
+
+    if (config.queueDiscType == "RED" || config.queueDiscType == "ARED") {
         if (st.GetNDroppedPackets(RedQueueDisc::UNFORCED_DROP) == 0)
         {
             std::cout << "There should be some unforced drops" << std::endl;
             exit(1);
         }
     }
-    else if(queueDiscType == "DSRED") {
+    else if(config.queueDiscType == "DSRED") {
         if (st.GetNDroppedPackets(DsRedQueueDisc::UNFORCED_DROP) == 0)
         {
             std::cout << "There should be some unforced drops" << std::endl;
             exit(1);
         }
     }
+    else if (config.queueDiscType == "DualQ") {
+        if (st.nTotalDroppedPackets == 0 && st.nTotalMarkedPackets == 0)
+        {
+            std::cout << "There should be some drops or marks" << std::endl;
+            exit(1);
+        }
+    }
     else if (st.GetNDroppedPackets(BlueQueueDisc::FORCED_DROP) == 0 &&
         st.GetNDroppedPackets(BlueQueueDisc::PROB_DROP) == 0)
     {
@@ -244,8 +1032,23 @@ int main(int argc, char* argv[])
 
     std::cout << "*** Stats from the bottleneck queue disc ***" << std::endl;
     std::cout << st << std::endl;
-    std::cout << "Destroying the simulation" << std::endl;
-
-    Simulator::Destroy();
+    std::cout << result.sojourn << std::endl;
+    if (config.steadyState)
+    {
+        std::cout << result.steadyState << std::endl;
+    }
+    if (!config.intervalStats.empty() || config.warmUp > 0)
+    {
+        std::cout << "*** Stats from the bottleneck queue disc after the warm-up ***" << std::endl;
+        std::cout << result.afterWarmUp << std::endl;
+    }
+    if (!result.hotPath.empty())
+    {
+        std::cout << result.hotPath << std::endl;
+    }
+    if (pooledAllocator)
+    {
+        PooledAllocator::PrintStats(std::cout);
+    }
     return 0;
 }
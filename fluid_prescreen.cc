@@ -0,0 +1,242 @@
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("FluidPrescreen");
+
+/**
+ * Expand a "lo:hi:n" grid specification into n evenly spaced values.
+ * A single number yields a one-point grid.
+ *
+ * \param spec The grid specification.
+ * \return The grid values.
+ */
+std::vector<double>
+ParseGrid(const std::string& spec)
+{
+    std::vector<double> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':'))
+    {
+        fields.push_back(std::stod(field));
+    }
+    if (fields.size() == 1)
+    {
+        return fields;
+    }
+    NS_ABORT_MSG_IF(fields.size() != 3, "Grid must be a number or lo:hi:n, got " << spec);
+
+    std::vector<double> values;
+    auto n = static_cast<uint32_t>(fields[2]);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        values.push_back(n == 1 ? fields[0] : fields[0] + (fields[1] - fields[0]) * i / (n - 1));
+    }
+    return values;
+}
+
+/**
+ * Sweep RED, DSRED and BLUE parameter grids through the fluid model and flag
+ * the points worth validating with final_testing_script.
+ *
+ * The scenario defaults mirror final_testing_script: a dumbbell with 1 ms
+ * leaf links, on/off TCP sources that are active half of the time, and the
+ * queue disc limit given in packets.
+ */
+int
+main(int argc, char* argv[])
+{
+    uint32_t nLeaf = 10;
+    uint32_t queueDiscLimitPackets = 1000;
+    uint32_t pktSize = 512;
+    std::string appDataRate = "10Mbps";
+    std::string bottleNeckLinkBw = "1Mbps";
+    std::string bottleNeckLinkDelay = "50ms";
+    std::string leafLinkDelay = "1ms";
+    double activeFraction = 0.5;
+    std::string queueDiscType = "RED";
+    std::string minThGrid = "2:20:10";
+    std::string maxThGrid = "10:60:11";
+    std::string midThGrid = "5:40:8";
+    std::string gammaGrid = "0.1:0.9:5";
+    std::string incrementGrid = "0.005:0.05:10";
+    std::string decrementGrid = "0.0005:0.005:10";
+    std::string freezeTimeGrid = "0.01:0.2:5";
+    double duration = 30;
+    double warmup = 5;
+    double minUtilisation = 0.9;
+    double maxLossRate = 0.05;
+    double maxDelay = 0.1;
+    std::string outputFile;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nLeaf", "Number of left and right side leaf nodes", nLeaf);
+    cmd.AddValue("queueDiscLimitPackets",
+                 "Max Packets allowed in the queue disc",
+                 queueDiscLimitPackets);
+    cmd.AddValue("appPktSize", "OnOff App Packet Size", pktSize);
+    cmd.AddValue("appDataRate", "OnOff App DataRate", appDataRate);
+    cmd.AddValue("bottleNeckLinkBw", "Bottleneck link bandwidth", bottleNeckLinkBw);
+    cmd.AddValue("bottleNeckLinkDelay", "Bottleneck link delay", bottleNeckLinkDelay);
+    cmd.AddValue("leafLinkDelay", "Leaf link delay", leafLinkDelay);
+    cmd.AddValue("activeFraction", "Mean fraction of time a source is on", activeFraction);
+    cmd.AddValue("queueDiscType", "Queue disc to screen: RED, DSRED or Blue", queueDiscType);
+    cmd.AddValue("redMinTh", "RED minimum threshold grid (lo:hi:n)", minThGrid);
+    cmd.AddValue("redMaxTh", "RED maximum threshold grid (lo:hi:n)", maxThGrid);
+    cmd.AddValue("redMidTh", "DSRED middle threshold grid (lo:hi:n)", midThGrid);
+    cmd.AddValue("gamma", "DSRED gamma grid (lo:hi:n)", gammaGrid);
+    cmd.AddValue("blueIncrement", "BLUE increment grid (lo:hi:n)", incrementGrid);
+    cmd.AddValue("blueDecrement", "BLUE decrement grid (lo:hi:n)", decrementGrid);
+    cmd.AddValue("blueFreezeTime", "BLUE freeze time grid in seconds (lo:hi:n)", freezeTimeGrid);
+    cmd.AddValue("duration", "Simulated seconds per fluid run", duration);
+    cmd.AddValue("warmup", "Seconds excluded from the averages", warmup);
+    cmd.AddValue("minUtilisation", "Promising if utilisation is at least this", minUtilisation);
+    cmd.AddValue("maxLossRate", "Promising if the loss rate is at most this", maxLossRate);
+    cmd.AddValue("maxDelay", "Promising if the mean queueing delay (s) is at most this", maxDelay);
+    cmd.AddValue("outputFile", "CSV file for all points (stdout if empty)", outputFile);
+    cmd.Parse(argc, argv);
+
+    if ((queueDiscType != "RED") && (queueDiscType != "DSRED") && (queueDiscType != "Blue"))
+    {
+        std::cout << "Invalid queue disc type: Use --queueDiscType=RED or --queueDiscType=DSRED or "
+                     "--queueDiscType=Blue"
+                  << std::endl;
+        exit(1);
+    }
+
+    double pktBits = 8.0 * pktSize;
+    AqmFluidModel::Config base;
+    base.nFlows = nLeaf;
+    base.activeFraction = activeFraction;
+    base.capacity = DataRate(bottleNeckLinkBw).GetBitRate() / pktBits;
+    base.flowRateCap = DataRate(appDataRate).GetBitRate() / pktBits;
+    base.propDelay = 2 * (Time(bottleNeckLinkDelay).GetSeconds() +
+                          2 * Time(leafLinkDelay).GetSeconds());
+    base.bufferSize = queueDiscLimitPackets;
+    base.duration = duration;
+    base.warmup = warmup;
+
+    // Build the list of points to screen
+    std::vector<AqmFluidModel::Config> points;
+    if (queueDiscType == "Blue")
+    {
+        base.algorithm = AqmFluidModel::BLUE;
+        for (double inc : ParseGrid(incrementGrid))
+        {
+            for (double dec : ParseGrid(decrementGrid))
+            {
+                for (double freeze : ParseGrid(freezeTimeGrid))
+                {
+                    AqmFluidModel::Config c = base;
+                    c.increment = inc;
+                    c.decrement = dec;
+                    c.freezeTime = freeze;
+                    points.push_back(c);
+                }
+            }
+        }
+    }
+    else
+    {
+        base.algorithm = (queueDiscType == "DSRED") ? AqmFluidModel::DSRED : AqmFluidModel::RED;
+        std::vector<double> mids = ParseGrid(midThGrid);
+        std::vector<double> gammas = ParseGrid(gammaGrid);
+        if (base.algorithm == AqmFluidModel::RED)
+        {
+            mids = {base.midTh};
+            gammas = {base.gamma};
+        }
+        for (double minTh : ParseGrid(minThGrid))
+        {
+            for (double maxTh : ParseGrid(maxThGrid))
+            {
+                for (double midTh : mids)
+                {
+                    for (double gamma : gammas)
+                    {
+                        bool ordered = (base.algorithm == AqmFluidModel::DSRED)
+                                           ? (minTh < midTh && midTh < maxTh)
+                                           : (minTh < maxTh);
+                        if (!ordered)
+                        {
+                            continue;
+                        }
+                        AqmFluidModel::Config c = base;
+                        c.minTh = minTh;
+                        c.maxTh = maxTh;
+                        c.midTh = midTh;
+                        c.gamma = gamma;
+                        points.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!outputFile.empty())
+    {
+        file.open(outputFile, std::ios::out);
+    }
+    std::ostream& out = outputFile.empty() ? std::cout : file;
+    out << "minTh,maxTh,midTh,gamma,increment,decrement,freezeTime,"
+        << "meanQueue,queueStdDev,meanDelay,lossRate,utilisation,meanDropProb,promising"
+        << std::endl;
+
+    std::vector<std::string> promising;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& c : points)
+    {
+        AqmFluidModel::Result r = AqmFluidModel::Run(c);
+        bool good = r.utilisation >= minUtilisation && r.lossRate <= maxLossRate &&
+                    r.meanDelay <= maxDelay;
+
+        out << c.minTh << "," << c.maxTh << "," << c.midTh << "," << c.gamma << ","
+            << c.increment << "," << c.decrement << "," << c.freezeTime << "," << r.meanQueue
+            << "," << r.queueStdDev << "," << r.meanDelay << "," << r.lossRate << ","
+            << r.utilisation << "," << r.meanDropProb << "," << good << std::endl;
+
+        if (good)
+        {
+            // Command line for the packet-level validation run
+            std::stringstream args;
+            args << "--queueDiscType=" << queueDiscType << " --nLeaf=" << nLeaf
+                 << " --queueDiscLimitPackets=" << queueDiscLimitPackets;
+            if (queueDiscType == "Blue")
+            {
+                args << " --blueIncrement=" << c.increment << " --blueDecrement=" << c.decrement
+                     << " --blueFreezeTime=" << c.freezeTime;
+            }
+            else
+            {
+                args << " --redMinTh=" << c.minTh << " --redMaxTh=" << c.maxTh;
+                if (queueDiscType == "DSRED")
+                {
+                    args << " --redMidTh=" << c.midTh << " --gamma=" << c.gamma;
+                }
+            }
+            promising.push_back(args.str());
+        }
+    }
+    double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "Screened " << points.size() << " configurations in " << elapsed << " s ("
+              << (elapsed > 0 ? points.size() / elapsed : 0) << " per second)" << std::endl;
+    std::cerr << promising.size() << " promising configurations for final_testing_script:"
+              << std::endl;
+    for (const auto& args : promising)
+    {
+        std::cerr << "  " << args << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,348 @@
+#ifndef MULTI_FLOW_ON_OFF_APPLICATION_H
+#define MULTI_FLOW_ON_OFF_APPLICATION_H
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief On/off traffic over many TCP connections from a single node
+ *
+ * Every connection behaves like its own OnOffApplication: it alternates
+ * between on periods, during which it writes PacketSize bytes to its
+ * socket at DataRate, and off periods, with the OnTime and OffTime
+ * variables drawn independently for each connection. Running N connections
+ * in one application costs N sockets instead of N nodes with their stacks
+ * and devices.
+ */
+class MultiFlowOnOffApplication : public Application
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::MultiFlowOnOffApplication")
+                .SetParent<Application>()
+                .SetGroupName("Applications")
+                .AddConstructor<MultiFlowOnOffApplication>()
+                .AddAttribute("Remote",
+                              "The address of the destination",
+                              AddressValue(),
+                              MakeAddressAccessor(&MultiFlowOnOffApplication::m_peer),
+                              MakeAddressChecker())
+                .AddAttribute("NFlows",
+                              "Number of TCP connections opened by the application",
+                              UintegerValue(1),
+                              MakeUintegerAccessor(&MultiFlowOnOffApplication::m_nFlows),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("DataRate",
+                              "The data rate of each connection in on state",
+                              DataRateValue(DataRate("500kb/s")),
+                              MakeDataRateAccessor(&MultiFlowOnOffApplication::m_cbrRate),
+                              MakeDataRateChecker())
+                .AddAttribute("PacketSize",
+                              "The size of the packets written to the sockets",
+                              UintegerValue(512),
+                              MakeUintegerAccessor(&MultiFlowOnOffApplication::m_pktSize),
+                              MakeUintegerChecker<uint32_t>(1))
+                .AddAttribute("OnTime",
+                              "A RandomVariableStream used to pick the duration of the 'On' state",
+                              StringValue("ns3::ConstantRandomVariable[Constant=1.0]"),
+                              MakePointerAccessor(&MultiFlowOnOffApplication::m_onTime),
+                              MakePointerChecker<RandomVariableStream>())
+                .AddAttribute("OffTime",
+                              "A RandomVariableStream used to pick the duration of the 'Off' state",
+                              StringValue("ns3::ConstantRandomVariable[Constant=1.0]"),
+                              MakePointerAccessor(&MultiFlowOnOffApplication::m_offTime),
+                              MakePointerChecker<RandomVariableStream>());
+        return tid;
+    }
+
+    MultiFlowOnOffApplication() = default;
+
+    /**
+     * @brief Assign a fixed random variable stream number to the random variables
+     * @param stream first stream index to use
+     * @return the number of stream indices assigned
+     */
+    int64_t AssignStreams(int64_t stream)
+    {
+        m_onTime->SetStream(stream);
+        m_offTime->SetStream(stream + 1);
+        return 2;
+    }
+
+    /// @return the number of bytes accepted by the sockets of each connection
+    std::vector<uint64_t> GetTxBytes() const
+    {
+        std::vector<uint64_t> bytes;
+        bytes.reserve(m_flows.size());
+        for (const auto& flow : m_flows)
+        {
+            bytes.push_back(flow.totBytes);
+        }
+        return bytes;
+    }
+
+  protected:
+    void DoDispose() override
+    {
+        m_flows.clear();
+        m_socketIndex.clear();
+        Application::DoDispose();
+    }
+
+  private:
+    /**
+     * @brief State of one connection
+     */
+    struct Flow
+    {
+        Ptr<Socket> socket;     //!< Connection socket
+        bool connected{false};  //!< True once the connection is established
+        EventId startStopEvent; //!< Next on/off transition
+        EventId sendEvent;      //!< Next packet write
+        uint32_t residualBits{0}; //!< Bits of the current packet not yet paced
+        Time lastStartTime;     //!< Start of the current on period
+        uint64_t totBytes{0};   //!< Bytes accepted by the socket
+    };
+
+    void StartApplication() override
+    {
+        m_flows.resize(m_nFlows);
+        for (uint32_t i = 0; i < m_nFlows; ++i)
+        {
+            Flow& flow = m_flows[i];
+            if (!flow.socket)
+            {
+                flow.socket = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+                flow.socket->Bind();
+                flow.socket->Connect(m_peer);
+                flow.socket->ShutdownRecv();
+                flow.socket->SetConnectCallback(
+                    MakeCallback(&MultiFlowOnOffApplication::ConnectionSucceeded, this),
+                    MakeCallback(&MultiFlowOnOffApplication::ConnectionFailed, this));
+                m_socketIndex[flow.socket] = i;
+            }
+            ScheduleStartEvent(i);
+        }
+    }
+
+    void StopApplication() override
+    {
+        for (auto& flow : m_flows)
+        {
+            Simulator::Cancel(flow.startStopEvent);
+            Simulator::Cancel(flow.sendEvent);
+            if (flow.socket)
+            {
+                flow.socket->Close();
+            }
+        }
+    }
+
+    /**
+     * @brief Schedule the start of the next on period of a connection
+     * @param i the connection index
+     */
+    void ScheduleStartEvent(uint32_t i)
+    {
+        Time offInterval = Seconds(m_offTime->GetValue());
+        m_flows[i].startStopEvent =
+            Simulator::Schedule(offInterval, &MultiFlowOnOffApplication::StartSending, this, i);
+    }
+
+    /**
+     * @brief Schedule the end of the current on period of a connection
+     * @param i the connection index
+     */
+    void ScheduleStopEvent(uint32_t i)
+    {
+        Time onInterval = Seconds(m_onTime->GetValue());
+        m_flows[i].startStopEvent =
+            Simulator::Schedule(onInterval, &MultiFlowOnOffApplication::StopSending, this, i);
+    }
+
+    /**
+     * @brief Start an on period
+     * @param i the connection index
+     */
+    void StartSending(uint32_t i)
+    {
+        m_flows[i].lastStartTime = Simulator::Now();
+        ScheduleNextTx(i);
+        ScheduleStopEvent(i);
+    }
+
+    /**
+     * @brief End an on period, keeping the unpaced part of the packet
+     * @param i the connection index
+     */
+    void StopSending(uint32_t i)
+    {
+        Flow& flow = m_flows[i];
+        if (flow.sendEvent.IsRunning())
+        {
+            // Same accounting as OnOffApplication::CancelEvents
+            Time delta = Simulator::Now() - flow.lastStartTime;
+            flow.residualBits +=
+                static_cast<uint32_t>(delta.GetSeconds() * m_cbrRate.GetBitRate());
+        }
+        Simulator::Cancel(flow.sendEvent);
+        ScheduleStartEvent(i);
+    }
+
+    /**
+     * @brief Schedule the next packet write of a connection
+     * @param i the connection index
+     */
+    void ScheduleNextTx(uint32_t i)
+    {
+        Flow& flow = m_flows[i];
+        uint32_t bits = m_pktSize * 8 > flow.residualBits ? m_pktSize * 8 - flow.residualBits : 0;
+        Time nextTime(Seconds(bits / static_cast<double>(m_cbrRate.GetBitRate())));
+        flow.sendEvent =
+            Simulator::Schedule(nextTime, &MultiFlowOnOffApplication::SendPacket, this, i);
+    }
+
+    /**
+     * @brief Write one packet to the socket of a connection
+     * @param i the connection index
+     */
+    void SendPacket(uint32_t i)
+    {
+        Flow& flow = m_flows[i];
+        if (flow.connected)
+        {
+            int actual = flow.socket->Send(Create<Packet>(m_pktSize));
+            if (actual > 0)
+            {
+                flow.totBytes += actual;
+            }
+        }
+        flow.residualBits = 0;
+        flow.lastStartTime = Simulator::Now();
+        ScheduleNextTx(i);
+    }
+
+    /**
+     * @brief Connection established
+     * @param socket the connected socket
+     */
+    void ConnectionSucceeded(Ptr<Socket> socket)
+    {
+        m_flows[m_socketIndex[socket]].connected = true;
+    }
+
+    /**
+     * @brief Connection failed
+     * @param socket the socket that failed to connect
+     */
+    void ConnectionFailed(Ptr<Socket> socket)
+    {
+        NS_FATAL_ERROR("Can't connect");
+    }
+
+    Address m_peer;                          //!< Peer address
+    uint32_t m_nFlows{1};                    //!< Number of connections
+    DataRate m_cbrRate;                      //!< Per-connection rate in on state
+    uint32_t m_pktSize{512};                 //!< Size of the packets written
+    Ptr<RandomVariableStream> m_onTime;      //!< Random variable for the on periods
+    Ptr<RandomVariableStream> m_offTime;     //!< Random variable for the off periods
+    std::vector<Flow> m_flows;               //!< Per-connection state
+    std::map<Ptr<Socket>, uint32_t> m_socketIndex; //!< Connection index of each socket
+};
+
+/**
+ * @brief Per-connection goodput at one or more PacketSinks
+ *
+ * Received bytes are keyed by the remote address and port of the
+ * connection, as reported by the PacketSink RxWithAddresses trace.
+ */
+class ConnectionGoodputCollector
+{
+  public:
+    /**
+     * @brief Start counting the bytes received by a sink
+     * @param sink the packet sink
+     */
+    void Attach(Ptr<PacketSink> sink)
+    {
+        sink->TraceConnectWithoutContext("RxWithAddresses",
+                                         MakeCallback(&ConnectionGoodputCollector::Rx, this));
+    }
+
+    /// @return the bytes received per connection, keyed by (remote address, remote port)
+    const std::map<std::pair<uint32_t, uint16_t>, uint64_t>& GetRxBytes() const
+    {
+        return m_rxBytes;
+    }
+
+    /**
+     * @brief Jain fairness index of the per-connection goodputs
+     *
+     * Connections that never delivered a byte are not seen by the sink; they
+     * count as zero goodput when nConnections exceeds the observed ones.
+     *
+     * @param nConnections number of connections that were opened
+     * @return the Jain index
+     */
+    double GetJainIndex(uint32_t nConnections) const
+    {
+        double sum = 0;
+        double sumSquares = 0;
+        for (const auto& [connection, bytes] : m_rxBytes)
+        {
+            sum += bytes;
+            sumSquares += static_cast<double>(bytes) * bytes;
+        }
+        uint32_t n = std::max<uint32_t>(nConnections, m_rxBytes.size());
+        return sumSquares > 0 ? (sum * sum) / (n * sumSquares) : 0;
+    }
+
+    /**
+     * @brief Print the goodput of every connection
+     * @param os output stream
+     * @param activeTime time (s) the goodput is averaged over
+     */
+    void Print(std::ostream& os, double activeTime) const
+    {
+        for (const auto& [connection, bytes] : m_rxBytes)
+        {
+            os << Ipv4Address(connection.first) << ":" << connection.second << " "
+               << bytes * 8.0 / activeTime << std::endl;
+        }
+    }
+
+  private:
+    /**
+     * @brief PacketSink RxWithAddresses trace sink
+     * @param packet the received packet
+     * @param from the remote address
+     * @param local the local address
+     */
+    void Rx(Ptr<const Packet> packet, const Address& from, const Address& local)
+    {
+        InetSocketAddress remote = InetSocketAddress::ConvertFrom(from);
+        m_rxBytes[{remote.GetIpv4().Get(), remote.GetPort()}] += packet->GetSize();
+    }
+
+    std::map<std::pair<uint32_t, uint16_t>, uint64_t> m_rxBytes; //!< Bytes per connection
+};
+
+} // namespace ns3
+
+#endif // MULTI_FLOW_ON_OFF_APPLICATION_H
@@ -14,62 +14,74 @@
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("BlueAqmExample");
-uint32_t checkTimes; //!< Number of times the queues have been checked.
-double avgQueueSize; //!< Average Queue size.
-std::stringstream filePlotQueue;    //!< Output file name for queue size.
-std::stringstream filePlotQueueAvg; //!< Output file name for queue average.
-std::stringstream fileBlueMarkingProbability; // Output file name for Blue Marking Probability
+std::ofstream fPlotQueue;               //!< Instantaneous queue size output file.
+std::ofstream fPlotQueueAvg;            //!< Average queue size output file.
+std::ofstream fBlueMarkingProbability; //!< Blue marking probability output file.
+double queueArea;                       //!< Integral of the queue size over time.
+uint32_t lastQueueSize;                 //!< Queue size since lastQueueChange.
+Time lastQueueChange;                   //!< Time of the last queue size change.
 
 
 /**
- * Check the queue size and write its stats to the output files.
+ * Write a change of the queue size to the output files.
  *
- * \param queue The queue to check.
+ * Connected to the PacketsInQueue or BytesInQueue trace source, so every
+ * change is recorded at the time it happens. The average is weighted by the
+ * time the queue spent at each size since the start of the simulation.
+ *
+ * \param oldValue The previous queue size.
+ * \param newValue The new queue size.
  */
 void
-CheckQueueSize(Ptr<QueueDisc> queue)
+QueueSizeChanged(uint32_t oldValue, uint32_t newValue)
 {
-    uint32_t qSize = queue->GetCurrentSize().GetValue();
-
-    avgQueueSize += qSize;
-    checkTimes++;
+    Time now = Simulator::Now();
+    queueArea += lastQueueSize * (now - lastQueueChange).GetSeconds();
+    lastQueueSize = newValue;
+    lastQueueChange = now;
 
-    // check queue size every 1/100 of a second
-    Simulator::Schedule(Seconds(0.01), &CheckQueueSize, queue);
+    // Write to instaneous queue size data file
+    fPlotQueue << now.GetSeconds() << " " << newValue << '\n';
 
+    // Write to avg queue size data file
+    if (now.IsStrictlyPositive())
+    {
+        fPlotQueueAvg << now.GetSeconds() << " " << queueArea / now.GetSeconds() << '\n';
+    }
+}
 
-// Write to instaneous queue size data file
-    std::ofstream fPlotQueue(filePlotQueue.str(), std::ios::out | std::ios::app);
-    fPlotQueue << Simulator::Now().GetSeconds() << " " << qSize << std::endl;
-    fPlotQueue.close();
 
-    
-// Write to avg queue size data file
-    std::ofstream fPlotQueueAvg(filePlotQueueAvg.str(), std::ios::out | std::ios::app);
-    fPlotQueueAvg << Simulator::Now().GetSeconds() << " " << avgQueueSize / checkTimes << std::endl;
-    fPlotQueueAvg.close();
+/**
+ * Write the average queue size over the whole run to its output file.
+ *
+ * Called once when the simulation ends, to close the last queue size
+ * interval, which no trace event does.
+ */
+void
+WriteFinalQueueAverage()
+{
+    Time now = Simulator::Now();
+    queueArea += lastQueueSize * (now - lastQueueChange).GetSeconds();
+    lastQueueChange = now;
+    if (now.IsStrictlyPositive())
+    {
+        fPlotQueueAvg << now.GetSeconds() << " " << queueArea / now.GetSeconds() << std::endl;
+    }
 }
 
 
 /**
- * Check the marking proability of BLUE and write it to an output file
+ * Write a change of the marking probability of BLUE to an output file
+ *
+ * Connected to the DropProbability trace source of the BLUE queue disc.
  *
- * \param queue The BLUE queue to check.
+ * \param oldValue The previous marking probability.
+ * \param newValue The new marking probability.
  */
 void
-CheckMarkingProbability(Ptr<QueueDisc> queue)
+MarkingProbabilityChanged(double oldValue, double newValue)
 {
-    
-    
-    // check queue size every 1/100 of a second
-    Simulator::Schedule(Seconds(0.01), &CheckMarkingProbability, queue);
-    Ptr<BlueQueueDisc> blueQueue = DynamicCast<BlueQueueDisc>(queue);
-    double dropProbability = blueQueue->GetDropProbability();
-
-    // write to file that contains marking probability each 1/100 of a second
-    std::ofstream fBlueMarkingProbability(fileBlueMarkingProbability.str(), std::ios::out | std::ios::app);
-    fBlueMarkingProbability << Simulator::Now().GetSeconds() << " " << dropProbability << std::endl;
-    fBlueMarkingProbability.close();
+    fBlueMarkingProbability << Simulator::Now().GetSeconds() << " " << newValue << '\n';
 }
 
 
@@ -106,8 +118,7 @@ int main(int argc, char* argv[]) {
     double blueIncrement = 0.02; // d1
     double blueDecrement = 0.002; // d2
     double blueFreezeTime = 0.1; 
-    double checkQueueInterval = 0.01; // Default value of 0.01 seconds
-    double checkBlueProbMarkingInterval = 0.01; // Default value of 0.01 seconds
+    double traceDeadband = 0; // Record every change of the marking probability
   
     QueueStatsPathOut = "."; // Current directory
     FlowMonitorPathOut = "."; // Current Directory
@@ -132,8 +143,7 @@ int main(int argc, char* argv[]) {
     cmd.AddValue("QueueStatsPathOut", "Queue size and avg queue size at specific timestamp", QueueStatsPathOut);
     cmd.AddValue("FlowMonitorPathOut", "Flow Monitor Stats for flows in a simulation", FlowMonitorPathOut);
     cmd.AddValue("BlueMarketProbPathOut", "Blue Marking Probability at a specific timestamp", BlueMarketProbPathOut);
-    cmd.AddValue("checkQueueInterval", "Interval for checking queue size", checkQueueInterval);
-    cmd.AddValue("checkBlueProbMarkingInterval", "Interval for checking Blue's Marking Probability", checkBlueProbMarkingInterval);
+    cmd.AddValue("traceDeadband", "Smallest change of Blue's Marking Probability that is recorded", traceDeadband);
     cmd.Parse(argc, argv);
 
      // Enable debug logs
@@ -203,6 +213,7 @@ int main(int argc, char* argv[]) {
         Config::SetDefault("ns3::BlueQueueDisc::Increment", DoubleValue(blueIncrement));
         Config::SetDefault("ns3::BlueQueueDisc::Decrement", DoubleValue(blueDecrement));
         Config::SetDefault("ns3::BlueQueueDisc::FreezeTime", TimeValue(Seconds(blueFreezeTime)));
+        Config::SetDefault("ns3::BlueQueueDisc::TraceDeadband", DoubleValue(traceDeadband));
     }
 
     // Configure network topology
@@ -277,25 +288,25 @@ int main(int argc, char* argv[]) {
 
     Ipv4GlobalRoutingHelper::PopulateRoutingTables();
     
-    // set paths 
-    filePlotQueue << QueueStatsPathOut << "/"
-                    << "queue_size.plotme";
-    filePlotQueueAvg << QueueStatsPathOut << "/"
-                        << "queue_avg_size.plotme";
-    fileBlueMarkingProbability << BlueMarketProbPathOut << "/"
-                    << "Blue_marking_prob.plotme";
+    // open output files
+    fPlotQueue.open(QueueStatsPathOut + "/queue_size.plotme", std::ios::out | std::ios::app);
+    fPlotQueueAvg.open(QueueStatsPathOut + "/queue_avg_size.plotme", std::ios::out | std::ios::app);
 
-
-    // add update of inst/avg queue size
+    // record every change of inst/avg queue size
     Ptr<QueueDisc> queue = queueDiscs.Get(0);
-    Simulator::ScheduleNow(&CheckQueueSize, queue);
+    fPlotQueue << 0 << " " << 0 << std::endl;
+    queue->TraceConnectWithoutContext(modeBytes ? "BytesInQueue" : "PacketsInQueue",
+                                      MakeCallback(&QueueSizeChanged));
     // Use DynamicCast to check if it's a BlueQueueDisc
     Ptr<BlueQueueDisc> blueQueue = DynamicCast<BlueQueueDisc>(queue);
     if (blueQueue != nullptr)  // Ensure the cast is valid
     {
         NS_LOG_INFO("The queue is a BlueQueueDisc.");
-        Simulator::ScheduleNow(&CheckMarkingProbability, queue); // Add marking probability at specific timestamp to file
-        
+        fBlueMarkingProbability.open(BlueMarketProbPathOut + "/Blue_marking_prob.plotme",
+                                     std::ios::out | std::ios::app);
+        fBlueMarkingProbability << 0 << " " << blueQueue->GetDropProbability() << std::endl;
+        blueQueue->TraceConnectWithoutContext("DropProbability",
+                                              MakeCallback(&MarkingProbabilityChanged));
     }
     else
     {
@@ -310,6 +321,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Starting the simulation" << std::endl;
     // Start simulation
     Simulator::Run();
+    WriteFinalQueueAverage();
    
     // Grab queue stats
     QueueDisc::Stats st = queueDiscs.Get(0)->GetStats();
@@ -360,6 +372,14 @@ int main(int argc, char* argv[]) {
         
     std::cout << "*** Stats from the bottleneck queue disc ***" << std::endl;
     std::cout << st << std::endl;
+    if (blueQueue != nullptr)
+    {
+        blueQueue->PrintAqmStats(std::cout);
+    }
+    else if (Ptr<RedQueueDisc> redQueue = DynamicCast<RedQueueDisc>(queue))
+    {
+        redQueue->PrintAqmStats(std::cout);
+    }
 
     std::cout << "Destroying the simulation" << std::endl;
     Simulator::Destroy();
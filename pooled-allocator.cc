@@ -0,0 +1,362 @@
+#include "pooled-allocator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace ns3
+{
+
+namespace
+{
+
+/// Tag of the blocks obtained from malloc without a size class
+constexpr std::size_t TAG_MALLOC = 0;
+/// Tag of the over-aligned blocks, whose malloc pointer follows the tag
+constexpr std::size_t TAG_ALIGNED = SIZE_MAX;
+
+/**
+ * @brief A recycled block, linked through its header
+ */
+struct FreeBlock
+{
+    FreeBlock* next; //!< Next free block of the same class
+};
+
+/**
+ * @brief Free list and counters of one size class
+ */
+struct SizeClass
+{
+    FreeBlock* head;      //!< First free block
+    uint64_t nFree;       //!< Number of free blocks
+    uint64_t allocations; //!< Allocations while recycling was enabled
+    uint64_t recycled;    //!< Allocations served from the free list
+    uint64_t released;    //!< Blocks returned to malloc
+};
+
+static_assert(sizeof(FreeBlock) <= PooledAllocator::HEADER,
+              "A free block must fit in the header");
+static_assert(2 * sizeof(std::size_t) <= PooledAllocator::HEADER,
+              "An aligned block keeps its tag and malloc pointer in the header");
+
+std::atomic<bool> g_enabled{false}; //!< Recycling switch
+
+/// @return the size classes of the calling thread
+SizeClass*
+Classes()
+{
+    // Trivially destructible, so it is usable until the thread exits
+    static thread_local SizeClass classes[PooledAllocator::N_CLASSES];
+    return classes;
+}
+
+/**
+ * @param p a block
+ * @return the tag in the header of the block
+ */
+std::size_t&
+Tag(void* p)
+{
+    return *reinterpret_cast<std::size_t*>(static_cast<char*>(p) - PooledAllocator::HEADER);
+}
+
+#ifdef NS3_POOLED_ALLOCATOR
+/**
+ * @brief Allocate a block the way operator new must: call the new handler
+ * until it succeeds, and throw std::bad_alloc if there is none
+ * @param size the requested size
+ * @param alignment the alignment, 0 for the default one
+ * @return the block
+ */
+void*
+AllocateOrThrow(std::size_t size, std::size_t alignment)
+{
+    while (true)
+    {
+        void* p = alignment > PooledAllocator::HEADER
+                      ? PooledAllocator::AllocateAligned(size, alignment)
+                      : PooledAllocator::Allocate(size);
+        if (p)
+        {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+#endif
+
+} // namespace
+
+void
+PooledAllocator::Enable(bool enable)
+{
+    g_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool
+PooledAllocator::IsEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+bool
+PooledAllocator::IsAvailable()
+{
+#ifdef NS3_POOLED_ALLOCATOR
+    return true;
+#else
+    return false;
+#endif
+}
+
+void*
+PooledAllocator::Allocate(std::size_t size) noexcept
+{
+    if (size == 0)
+    {
+        size = 1;
+    }
+    std::size_t tag = TAG_MALLOC;
+    void* base;
+    if (size <= MAX_POOLED_SIZE && IsEnabled())
+    {
+        std::size_t c = (size - 1) / GRANULE;
+        SizeClass& sc = Classes()[c];
+        sc.allocations++;
+        tag = c + 1;
+        if (sc.head)
+        {
+            base = sc.head;
+            sc.head = sc.head->next;
+            sc.nFree--;
+            sc.recycled++;
+        }
+        else
+        {
+            base = std::malloc(HEADER + tag * GRANULE);
+        }
+    }
+    else
+    {
+        base = std::malloc(HEADER + size);
+    }
+    if (!base)
+    {
+        return nullptr;
+    }
+    void* p = static_cast<char*>(base) + HEADER;
+    Tag(p) = tag;
+    return p;
+}
+
+void*
+PooledAllocator::AllocateAligned(std::size_t size, std::size_t alignment) noexcept
+{
+    if (alignment <= HEADER)
+    {
+        return Allocate(size);
+    }
+    void* base = std::malloc(HEADER + alignment + size);
+    if (!base)
+    {
+        return nullptr;
+    }
+    auto address = reinterpret_cast<std::uintptr_t>(base) + HEADER;
+    address = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+    void* p = reinterpret_cast<void*>(address);
+    Tag(p) = TAG_ALIGNED;
+    reinterpret_cast<void**>(p)[-1] = base;
+    return p;
+}
+
+void
+PooledAllocator::Deallocate(void* p) noexcept
+{
+    if (!p)
+    {
+        return;
+    }
+    std::size_t tag = Tag(p);
+    if (tag == TAG_ALIGNED)
+    {
+        std::free(reinterpret_cast<void**>(p)[-1]);
+        return;
+    }
+    void* base = static_cast<char*>(p) - HEADER;
+    if (tag == TAG_MALLOC)
+    {
+        std::free(base);
+        return;
+    }
+    SizeClass& sc = Classes()[tag - 1];
+    if (IsEnabled() && sc.nFree < MAX_FREE)
+    {
+        auto block = static_cast<FreeBlock*>(base);
+        block->next = sc.head;
+        sc.head = block;
+        sc.nFree++;
+        return;
+    }
+    sc.released++;
+    std::free(base);
+}
+
+void
+PooledAllocator::PrintStats(std::ostream& os)
+{
+    uint64_t allocations = 0;
+    uint64_t recycled = 0;
+    os << "Pooled allocator (" << (IsEnabled() ? "enabled" : "disabled") << ")" << std::endl;
+    for (std::size_t c = 0; c < N_CLASSES; ++c)
+    {
+        const SizeClass& sc = Classes()[c];
+        if (sc.allocations == 0)
+        {
+            continue;
+        }
+        os << "  <= " << std::setw(3) << (c + 1) * GRANULE << " B: " << sc.allocations
+           << " allocations, " << sc.recycled << " recycled, " << sc.nFree << " free"
+           << std::endl;
+        allocations += sc.allocations;
+        recycled += sc.recycled;
+    }
+    os << "  " << recycled << " of " << allocations << " small allocations avoided malloc ("
+       << (allocations ? 100.0 * recycled / allocations : 0.0) << "%)" << std::endl;
+}
+
+} // namespace ns3
+
+#ifdef NS3_POOLED_ALLOCATOR
+
+// Replacements of every global allocation and deallocation function, so
+// that a block is always released by the allocator that produced it
+
+void*
+operator new(std::size_t size)
+{
+    return ns3::AllocateOrThrow(size, 0);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return ns3::AllocateOrThrow(size, 0);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+    return ns3::AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ns3::AllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ns3::PooledAllocator::Allocate(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return ns3::PooledAllocator::Allocate(size);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return ns3::PooledAllocator::AllocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return ns3::PooledAllocator::AllocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void
+operator delete(void* p) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, std::align_val_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+void
+operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+    ns3::PooledAllocator::Deallocate(p);
+}
+
+#endif // NS3_POOLED_ALLOCATOR
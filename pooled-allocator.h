@@ -0,0 +1,84 @@
+#ifndef POOLED_ALLOCATOR_H
+#define POOLED_ALLOCATOR_H
+
+#include <cstddef>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Free-list allocator for the small objects created per packet
+ *
+ * QueueDiscItem, Ipv4QueueDiscItem, Packet and their helpers are created
+ * by the internet stack (e.g. Ipv4Interface::Send) before they reach the
+ * traffic control layer, so they cannot be drawn from a pool owned by a
+ * queue disc. Instead pooled-allocator.cc replaces every global operator
+ * new and delete (plain, array, nothrow, sized and aligned): requests of up
+ * to MAX_POOLED_SIZE bytes are rounded up to a multiple of GRANULE and
+ * recycled through per-size free lists, while larger and over-aligned
+ * requests go straight to malloc. Every block carries a HEADER recording
+ * how it was obtained, so any delete overload releases any block, and
+ * recycling can be toggled at run time with Enable. The free lists are per
+ * thread.
+ *
+ * The replacement costs the header and a branch on every allocation of the
+ * process, so it is only compiled in with the NS3_POOLED_ALLOCATOR CMake
+ * option. Without it the free lists are never used; programs ask
+ * IsAvailable at run time, since the macro is private to this module.
+ */
+class PooledAllocator
+{
+  public:
+    static constexpr std::size_t GRANULE = 16;  //!< Size class granularity (bytes)
+    static constexpr std::size_t N_CLASSES = 16; //!< Number of size classes
+    static constexpr std::size_t MAX_POOLED_SIZE = GRANULE * N_CLASSES; //!< Largest pooled request
+    static constexpr std::size_t MAX_FREE = 1 << 16; //!< Free blocks kept per class
+    static constexpr std::size_t HEADER = alignof(std::max_align_t); //!< Block header size
+
+    /**
+     * @brief Turn recycling on or off
+     * @param enable true to recycle small blocks
+     */
+    static void Enable(bool enable);
+
+    /// @return true if small blocks are recycled
+    static bool IsEnabled();
+
+    /// @return true if operator new and delete are replaced, so that Enable has an effect
+    static bool IsAvailable();
+
+    /**
+     * @brief Allocate a block aligned to at most HEADER bytes
+     * @param size the requested size
+     * @return the block, nullptr if the system is out of memory
+     */
+    static void* Allocate(std::size_t size) noexcept;
+
+    /**
+     * @brief Allocate a block with a larger alignment, never pooled
+     * @param size the requested size
+     * @param alignment the alignment, a power of two
+     * @return the block, nullptr if the system is out of memory
+     */
+    static void* AllocateAligned(std::size_t size, std::size_t alignment) noexcept;
+
+    /**
+     * @brief Release a block obtained from Allocate or AllocateAligned
+     * @param p the block
+     */
+    static void Deallocate(void* p) noexcept;
+
+    /**
+     * @brief Print, for each size class in use, the allocations and how many
+     * of them were served from the free list instead of malloc
+     * @param os output stream
+     */
+    static void PrintStats(std::ostream& os);
+};
+
+} // namespace ns3
+
+#endif // POOLED_ALLOCATOR_H
@@ -0,0 +1,201 @@
+#include "profiling-simulator-impl.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <iomanip>
+#include <iostream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ProfilingSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingSimulatorImpl);
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::ProfilingSimulatorImpl")
+                            .SetParent<DefaultSimulatorImpl>()
+                            .SetGroupName("TrafficControl")
+                            .AddConstructor<ProfilingSimulatorImpl>();
+    return tid;
+}
+
+ProfilingSimulatorImpl::ProfilingSimulatorImpl()
+    : m_runSeconds(0),
+      m_runCycles(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+ProfilingSimulatorImpl::~ProfilingSimulatorImpl()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+ProfilingSimulatorImpl::ProfiledEvent::ProfiledEvent(EventImpl* event, EventStats* stats)
+    : m_event(event, false),
+      m_stats(stats)
+{
+}
+
+void
+ProfilingSimulatorImpl::ProfiledEvent::Notify()
+{
+    uint64_t start = ReadCycleCounter();
+    m_event->Invoke();
+    m_stats->cycles += ReadCycleCounter() - start;
+    m_stats->executed++;
+}
+
+std::string
+ProfilingSimulatorImpl::MakeLabel(const std::type_info& type)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    std::string name = status == 0 ? demangled : type.name();
+    std::free(demangled);
+
+    // MakeEvent<void (ns3::TcpSocketBase::*)(), ...>(...)::EventMemberImpl
+    auto end = name.find("::*)");
+    auto begin = name.rfind('(', end);
+    if (end != std::string::npos && begin != std::string::npos)
+    {
+        return name.substr(begin + 1, end - begin - 1);
+    }
+    // MakeEvent<void (*)(args), bound args>(...)::EventFunctionImpl
+    begin = name.find('<');
+    end = name.find(">(");
+    if (begin != std::string::npos && end != std::string::npos)
+    {
+        std::string function = name.substr(begin + 1, end - begin - 1);
+        auto bound = function.find("), ");
+        if (bound != std::string::npos)
+        {
+            function.resize(bound + 1);
+        }
+        return function;
+    }
+    return name;
+}
+
+EventImpl*
+ProfilingSimulatorImpl::Wrap(EventImpl* event)
+{
+    auto it = m_events.find(typeid(*event));
+    if (it == m_events.end())
+    {
+        it = m_events.emplace(typeid(*event), EventStats()).first;
+        it->second.label = MakeLabel(typeid(*event));
+    }
+    it->second.scheduled++;
+    return new ProfiledEvent(event, &it->second);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    return DefaultSimulatorImpl::Schedule(delay, Wrap(event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event)
+{
+    DefaultSimulatorImpl::ScheduleWithContext(context, delay, Wrap(event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return DefaultSimulatorImpl::ScheduleNow(Wrap(event));
+}
+
+void
+ProfilingSimulatorImpl::Run()
+{
+    NS_LOG_FUNCTION(this);
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t start = ReadCycleCounter();
+    DefaultSimulatorImpl::Run();
+    m_runCycles += ReadCycleCounter() - start;
+    m_runSeconds +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+}
+
+void
+ProfilingSimulatorImpl::Destroy()
+{
+    NS_LOG_FUNCTION(this);
+    // Queue discs and the other tracked objects are still alive here
+    Print(std::cout);
+    m_tracked.clear();
+    DefaultSimulatorImpl::Destroy();
+}
+
+void
+ProfilingSimulatorImpl::Track(const std::string& label, const CycleAccount* account)
+{
+    NS_LOG_FUNCTION(this << label);
+    m_tracked.emplace_back(label, account);
+}
+
+void
+ProfilingSimulatorImpl::Print(std::ostream& os) const
+{
+    // Calibrate the counter against the wall clock over the whole run
+    double secondsPerCycle = m_runCycles > 0 ? m_runSeconds / m_runCycles : 0;
+    auto ms = [secondsPerCycle](uint64_t cycles) { return cycles * secondsPerCycle * 1e3; };
+    auto share = [this](uint64_t cycles) {
+        return m_runCycles > 0 ? 100.0 * cycles / m_runCycles : 0.0;
+    };
+
+    std::vector<const EventStats*> events;
+    uint64_t executed = 0;
+    for (const auto& [type, stats] : m_events)
+    {
+        events.push_back(&stats);
+        executed += stats.executed;
+    }
+    std::sort(events.begin(), events.end(), [](const EventStats* a, const EventStats* b) {
+        return a->cycles > b->cycles;
+    });
+
+    os << "*** Simulator profile ***" << std::endl;
+    os << "Run: " << m_runSeconds << " s wall clock, " << executed << " events executed";
+    if (m_runSeconds > 0)
+    {
+        os << " (" << std::fixed << std::setprecision(0) << executed / m_runSeconds
+           << " events/s)";
+    }
+    os << std::endl;
+
+    os << std::fixed << std::setprecision(1);
+    os << std::setw(12) << "scheduled" << std::setw(12) << "executed" << std::setw(12)
+       << "time (ms)" << std::setw(8) << "share" << "  event type" << std::endl;
+    for (const EventStats* e : events)
+    {
+        os << std::setw(12) << e->scheduled << std::setw(12) << e->executed << std::setw(12)
+           << ms(e->cycles) << std::setw(7) << share(e->cycles) << "%  " << e->label << std::endl;
+    }
+
+    if (!m_tracked.empty())
+    {
+        os << std::setw(12) << "calls" << std::setw(12) << "ns/call" << std::setw(12)
+           << "time (ms)" << std::setw(8) << "share" << "  tracked code" << std::endl;
+        for (const auto& [label, account] : m_tracked)
+        {
+            double perCall = account->calls > 0 ? ms(account->cycles) * 1e6 / account->calls : 0;
+            os << std::setw(12) << account->calls << std::setw(12) << perCall << std::setw(12)
+               << ms(account->cycles) << std::setw(7) << share(account->cycles) << "%  " << label
+               << std::endl;
+        }
+    }
+    os << std::defaultfloat << std::setprecision(6);
+}
+
+} // namespace ns3
@@ -0,0 +1,128 @@
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "cycle-counter.h"
+
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-impl.h"
+
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Default simulator that also counts and times the events it runs
+ *
+ * Selected with
+ * GlobalValue::Bind("SimulatorImplementationType",
+ * StringValue("ns3::ProfilingSimulatorImpl")) before the simulator is
+ * first used. Every event is wrapped when scheduled, so the number of
+ * scheduled and executed events and the ticks (see ReadCycleCounter) spent
+ * executing them are kept per event type. The type is the class of the
+ * event, which MakeEvent derives from the scheduled function: member
+ * function events are labelled with their class (TcpSocketBase,
+ * PointToPointNetDevice, FlowMonitor, ...), other events with their
+ * function signature. Code run inside events, such as the enqueue and
+ * dequeue of a queue disc, can be measured with a CycleAccount and
+ * registered with Track.
+ *
+ * The breakdown is printed to the standard output by Simulator::Destroy,
+ * before the destroy events run. Wrapping costs an allocation and two
+ * counter reads per event, so the run is slower than with the default
+ * simulator, but the shares are representative.
+ */
+class ProfilingSimulatorImpl : public DefaultSimulatorImpl
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    ProfilingSimulatorImpl();
+    ~ProfilingSimulatorImpl() override;
+
+    void Destroy() override;
+    void Run() override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+
+    /**
+     * @brief Report a CycleAccount with the events
+     * @param label name of the measured code
+     * @param account the account, which must live until Simulator::Destroy
+     */
+    void Track(const std::string& label, const CycleAccount* account);
+
+    /**
+     * @brief Print the events per second, the events and time per event
+     * type and the tracked accounts
+     * @param os output stream
+     */
+    void Print(std::ostream& os) const;
+
+  private:
+    /**
+     * @brief Counters of an event type
+     */
+    struct EventStats
+    {
+        std::string label;      //!< Name of the event type
+        uint64_t scheduled = 0; //!< Events scheduled
+        uint64_t executed = 0;  //!< Events executed (not cancelled)
+        uint64_t cycles = 0;    //!< Ticks spent executing them
+    };
+
+    /**
+     * @brief Event that runs another one and charges it to its type
+     */
+    class ProfiledEvent : public EventImpl
+    {
+      public:
+        /**
+         * @param event the wrapped event, whose reference is taken over
+         * @param stats the counters of its type
+         */
+        ProfiledEvent(EventImpl* event, EventStats* stats);
+
+      protected:
+        void Notify() override;
+
+      private:
+        Ptr<EventImpl> m_event; //!< Wrapped event
+        EventStats* m_stats;    //!< Counters of its type
+    };
+
+    /**
+     * @brief Count an event and wrap it
+     * @param event the event being scheduled
+     * @return the event to hand to the default simulator
+     */
+    EventImpl* Wrap(EventImpl* event);
+
+    /**
+     * @brief Make a readable label out of an event type
+     * @param type the type of the event
+     * @return the class of a member function event, else the demangled type
+     */
+    static std::string MakeLabel(const std::type_info& type);
+
+    std::unordered_map<std::type_index, EventStats> m_events; //!< Counters by event type
+    std::vector<std::pair<std::string, const CycleAccount*>> m_tracked; //!< Tracked code
+    double m_runSeconds; //!< Wall-clock time spent in Run
+    uint64_t m_runCycles; //!< Ticks spent in Run
+};
+
+} // namespace ns3
+
+#endif // PROFILING_SIMULATOR_IMPL_H
@@ -46,14 +46,20 @@
 
 #include "red-queue-disc.h"
 
+#include "aqm-drop-curves.h"
+
 #include "ns3/abort.h"
 #include "ns3/double.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/enum.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
 #include "ns3/uinteger.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace ns3
 {
 
@@ -61,6 +67,13 @@ NS_LOG_COMPONENT_DEFINE("RedQueueDisc");
 
 NS_OBJECT_ENSURE_REGISTERED(RedQueueDisc);
 
+const uint16_t RedQueueDisc::UNFORCED_DROP_ID = AqmReasons::Register(UNFORCED_DROP);
+const uint16_t RedQueueDisc::FORCED_DROP_ID = AqmReasons::Register(FORCED_DROP);
+const uint16_t RedQueueDisc::UNFORCED_MARK_ID = AqmReasons::Register(UNFORCED_MARK);
+const uint16_t RedQueueDisc::FORCED_MARK_ID = AqmReasons::Register(FORCED_MARK);
+const uint16_t RedQueueDisc::STEP_MARK_ID = AqmReasons::Register(STEP_MARK);
+const uint16_t RedQueueDisc::STEP_DROP_ID = AqmReasons::Register(STEP_DROP);
+
 TypeId
 RedQueueDisc::GetTypeId()
 {
@@ -209,7 +222,61 @@ RedQueueDisc::GetTypeId()
                           "True to always drop packets above max threshold",
                           BooleanValue(true),
                           MakeBooleanAccessor(&RedQueueDisc::m_useHardDrop),
-                          MakeBooleanChecker());
+                          MakeBooleanChecker())
+            .AddAttribute("StepMarking",
+                          "True to mark (DCTCP style) every packet that finds the instantaneous "
+                          "queue above StepK, without the average queue and the random drops",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&RedQueueDisc::m_stepMarking),
+                          MakeBooleanChecker())
+            .AddAttribute("StepK",
+                          "Instantaneous queue length (packets or bytes) above which packets are "
+                          "marked in step-marking mode",
+                          QueueSizeValue(QueueSize("20p")),
+                          MakeQueueSizeAccessor(&RedQueueDisc::m_stepK),
+                          MakeQueueSizeChecker())
+            .AddAttribute("StepSojournK",
+                          "If not zero, step-marking marks at dequeue the packets that waited "
+                          "longer than this, instead of using StepK",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&RedQueueDisc::m_stepSojournK),
+                          MakeTimeChecker())
+            .AddAttribute("DropCurve",
+                          "Drop curve as \"x:p\" breakpoints of the average queue length, "
+                          "e.g. \"5:0 15:0.1:cubic 30:1\"; replaces the linear, gentle and "
+                          "nonlinear curves if not empty (see DropCurveTable)",
+                          StringValue(""),
+                          MakeStringAccessor(&RedQueueDisc::m_dropCurveSpec),
+                          MakeStringChecker())
+            .AddAttribute("DropCurveTableSize",
+                          "Number of intervals of the lookup table built from DropCurve",
+                          UintegerValue(1024),
+                          MakeUintegerAccessor(&RedQueueDisc::m_dropCurveTableSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("TraceDeadband",
+                          "Smallest change of the average queue length, max_p or drop "
+                          "probability reported by the trace sources",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&RedQueueDisc::m_traceDeadband),
+                          MakeDoubleChecker<double>(0.0))
+            .AddAttribute("ProfileCycles",
+                          "True to count the calls of DoEnqueue and DoDequeue and the ticks "
+                          "spent in them (see GetEnqueueCycles)",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&RedQueueDisc::m_profileCycles),
+                          MakeBooleanChecker())
+            .AddTraceSource("QueueAverage",
+                            "Average queue length (bytes or packets)",
+                            MakeTraceSourceAccessor(&RedQueueDisc::m_qAvgTrace),
+                            "ns3::TracedValueCallback::Double")
+            .AddTraceSource("CurMaxP",
+                            "Current max_p, adapted by Adaptive RED",
+                            MakeTraceSourceAccessor(&RedQueueDisc::m_curMaxPTrace),
+                            "ns3::TracedValueCallback::Double")
+            .AddTraceSource("DropProbability",
+                            "Drop probability computed for the last arrival",
+                            MakeTraceSourceAccessor(&RedQueueDisc::m_vProbTrace),
+                            "ns3::TracedValueCallback::Double");
 
     return tid;
 }
@@ -231,6 +298,9 @@ RedQueueDisc::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     m_uv = nullptr;
+    m_queue = nullptr;
+    m_sharedBuffer = nullptr;
+    m_eventLog = nullptr;
     QueueDisc::DoDispose();
 }
 
@@ -327,12 +397,186 @@ RedQueueDisc::AssignStreams(int64_t stream)
     return 1;
 }
 
+const SojournHistogram&
+RedQueueDisc::GetSojournHistogram() const
+{
+    return m_sojourn;
+}
+
+const CycleAccount&
+RedQueueDisc::GetEnqueueCycles() const
+{
+    return m_enqueueCycles;
+}
+
+const CycleAccount&
+RedQueueDisc::GetDequeueCycles() const
+{
+    return m_dequeueCycles;
+}
+
+const RedHotPathCounters&
+RedQueueDisc::GetHotPathCounters() const
+{
+    return m_counters;
+}
+
+double
+RedQueueDisc::GetQueueAverage() const
+{
+    return m_qAvg;
+}
+
+double
+RedQueueDisc::GetDropProbability() const
+{
+    return m_vProb;
+}
+
+double
+RedQueueDisc::GetCurveProbability()
+{
+    if (m_qAvg < m_minTh)
+    {
+        return 0.0;
+    }
+    return std::min(CalculatePNew(), 1.0);
+}
+
+void
+RedQueueDisc::SetSharedBuffer(Ptr<SharedBufferManager> manager)
+{
+    NS_LOG_FUNCTION(this << manager);
+    m_sharedBuffer = manager;
+    m_sharedBufferPort = manager->Register(this);
+}
+
+void
+RedQueueDisc::SetEventLog(Ptr<AqmEventLog> log)
+{
+    NS_LOG_FUNCTION(this << log);
+    m_eventLog = log;
+}
+
+void
+RedQueueDisc::Report(uint8_t type, uint16_t reason, Ptr<const QueueDiscItem> item)
+{
+    if (m_eventLog)
+    {
+        m_eventLog->Log(type, reason, item->Hash(), GetCurrentSize().GetValue(), m_vProb);
+    }
+}
+
+void
+RedQueueDisc::DropBeforeEnqueue(Ptr<const QueueDiscItem> item, uint16_t reason)
+{
+    QueueDisc::DropBeforeEnqueue(item, AqmReasons::GetName(reason));
+    Report(AQM_EVENT_DROP, reason, item);
+}
+
+void
+RedQueueDisc::DropAfterDequeue(Ptr<const QueueDiscItem> item, uint16_t reason)
+{
+    QueueDisc::DropAfterDequeue(item, AqmReasons::GetName(reason));
+    Report(AQM_EVENT_DROP, reason, item);
+}
+
+bool
+RedQueueDisc::Mark(Ptr<QueueDiscItem> item, uint16_t reason)
+{
+    if (!QueueDisc::Mark(item, AqmReasons::GetName(reason)))
+    {
+        return false;
+    }
+    Report(AQM_EVENT_MARK, reason, item);
+    return true;
+}
+
+uint64_t
+RedQueueDisc::GetNStepMarks() const
+{
+    return m_nStepMarks;
+}
+
+uint64_t
+RedQueueDisc::GetNStepDrops() const
+{
+    return m_nStepDrops;
+}
+
+void
+RedQueueDisc::PrintAqmStats(std::ostream& os) const
+{
+    if (m_stepMarking)
+    {
+        os << "Step marking: " << m_nStepMarks << " marks, " << m_nStepDrops
+           << " drops of packets that could not be marked" << std::endl;
+    }
+#ifdef NS3_AQM_COUNTERS
+    os << m_counters << std::endl;
+#endif
+    os << m_sojourn << std::endl;
+}
+
+bool
+RedQueueDisc::StepMark(Ptr<QueueDiscItem> item)
+{
+    if (Mark(item, STEP_MARK_ID))
+    {
+        m_nStepMarks++;
+        return true;
+    }
+    m_nStepDrops++;
+    return false;
+}
+
+void
+RedQueueDisc::UpdateTraces()
+{
+    if (std::fabs(m_qAvg - m_qAvgTrace.Get()) >= m_traceDeadband)
+    {
+        m_qAvgTrace = m_qAvg;
+    }
+    if (std::fabs(m_curMaxP - m_curMaxPTrace.Get()) >= m_traceDeadband)
+    {
+        m_curMaxPTrace = m_curMaxP;
+    }
+    if (m_vProb == 0.0 || std::fabs(m_vProb - m_vProbTrace.Get()) >= m_traceDeadband)
+    {
+        m_vProbTrace = m_vProb;
+    }
+}
+
 bool
 RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
 {
     NS_LOG_FUNCTION(this << item);
+    CycleScope profile(m_profileCycles ? &m_enqueueCycles : nullptr);
+
+    if (m_sharedBuffer && !m_sharedBuffer->Admit(m_sharedBufferPort, item))
+    {
+        DropBeforeEnqueue(item, SharedBufferManager::ADMISSION_DROP_ID);
+        return false;
+    }
+
+    if (m_stepMarking)
+    {
+        // Instantaneous threshold only: no estimator, no random number
+        if (m_stepSojournK.IsZero())
+        {
+            uint32_t length = m_stepK.GetUnit() == QueueSizeUnit::BYTES ? m_queue->GetNBytes()
+                                                                        : m_queue->GetNPackets();
+            if (length > m_stepK.GetValue() && !StepMark(item))
+            {
+                DropBeforeEnqueue(item, STEP_DROP_ID);
+                return false;
+            }
+        }
+        item->SetTimeStamp(Simulator::Now());
+        return m_queue->Enqueue(item);
+    }
 
-    uint32_t nQueued = GetInternalQueue(0)->GetCurrentSize().GetValue();
+    uint32_t nQueued = m_queue->GetCurrentSize().GetValue();
 
     // simulate number of packets arrival during idle period
     uint32_t m = 0;
@@ -357,8 +601,8 @@ RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
 
     m_qAvg = Estimator(nQueued, m + 1, m_qAvg, m_qW);
 
-    NS_LOG_DEBUG("\t bytesInQueue  " << GetInternalQueue(0)->GetNBytes() << "\tQavg " << m_qAvg);
-    NS_LOG_DEBUG("\t packetsInQueue  " << GetInternalQueue(0)->GetNPackets() << "\tQavg "
+    NS_LOG_DEBUG("\t bytesInQueue  " << m_queue->GetNBytes() << "\tQavg " << m_qAvg);
+    NS_LOG_DEBUG("\t packetsInQueue  " << m_queue->GetNPackets() << "\tQavg "
                                        << m_qAvg);
 
     m_count++;
@@ -374,6 +618,7 @@ RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
         }
         else if (m_old == 0)
         {
+            AQM_COUNT(m_counters.oldResets);
             /*
              * The average queue size has just crossed the
              * threshold from below to above m_minTh, or
@@ -396,23 +641,24 @@ RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
         m_vProb = 0.0;
         m_old = 0;
     }
+    UpdateTraces();
 
     if (dropType == DTYPE_UNFORCED)
     {
-        if (!m_useEcn || !Mark(item, UNFORCED_MARK))
+        if (!m_useEcn || !Mark(item, UNFORCED_MARK_ID))
         {
             NS_LOG_DEBUG("\t Dropping due to Prob Mark " << m_qAvg);
-            DropBeforeEnqueue(item, UNFORCED_DROP);
+            DropBeforeEnqueue(item, UNFORCED_DROP_ID);
             return false;
         }
         NS_LOG_DEBUG("\t Marking due to Prob Mark " << m_qAvg);
     }
     else if (dropType == DTYPE_FORCED)
     {
-        if (m_useHardDrop || !m_useEcn || !Mark(item, FORCED_MARK))
+        if (m_useHardDrop || !m_useEcn || !Mark(item, FORCED_MARK_ID))
         {
             NS_LOG_DEBUG("\t Dropping due to Hard Mark " << m_qAvg);
-            DropBeforeEnqueue(item, FORCED_DROP);
+            DropBeforeEnqueue(item, FORCED_DROP_ID);
             if (m_isNs1Compat)
             {
                 m_count = 0;
@@ -423,13 +669,14 @@ RedQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
         NS_LOG_DEBUG("\t Marking due to Hard Mark " << m_qAvg);
     }
 
-    bool retval = GetInternalQueue(0)->Enqueue(item);
+    item->SetTimeStamp(Simulator::Now());
+    bool retval = m_queue->Enqueue(item);
 
     // If Queue::Enqueue fails, QueueDisc::DropBeforeEnqueue is called by the
     // internal queue because QueueDisc::AddInternalQueue sets the trace callback
 
-    NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-    NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+    NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+    NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
     return retval;
 }
@@ -446,6 +693,12 @@ RedQueueDisc::InitializeParams()
     NS_LOG_FUNCTION(this);
     NS_LOG_INFO("Initializing RED params.");
 
+    m_nStepMarks = 0;
+    m_nStepDrops = 0;
+    m_counters = RedHotPathCounters();
+#ifdef NS3_AQM_COUNTERS
+    m_counters.enabled = true;
+#endif
     m_cautious = 0;
     m_ptc = m_linkBandwidth.GetBitRate() / (8.0 * m_meanPktSize);
 
@@ -563,6 +816,11 @@ RedQueueDisc::InitializeParams()
                               << "; th_diff " << th_diff << "; lInterm " << m_lInterm << "; va "
                               << m_vA << "; cur_max_p " << m_curMaxP << "; v_b " << m_vB
                               << "; m_vC " << m_vC << "; m_vD " << m_vD);
+
+    m_vProb = 0.0;
+    m_qAvgTrace = m_qAvg;
+    m_curMaxPTrace = m_curMaxP;
+    m_vProbTrace = m_vProb;
 }
 
 // Updating m_curMaxP, following the pseudocode
@@ -623,18 +881,27 @@ RedQueueDisc::Estimator(uint32_t nQueued, uint32_t m, double qAvg, double qW)
 {
     NS_LOG_FUNCTION(this << nQueued << m << qAvg << qW);
 
-    double newAve = qAvg * std::pow(1.0 - qW, m);
+    // m is 1 for every arrival but the first one after an idle period
+    AQM_COUNT(m == 1 ? m_counters.estimatorFast : m_counters.estimatorPow);
+    double newAve = qAvg * (m == 1 ? 1.0 - qW : std::pow(1.0 - qW, m));
     newAve += qW * nQueued;
 
+    double curMaxP = m_curMaxP;
     Time now = Simulator::Now();
     if (m_isAdaptMaxP && now > m_lastSet + m_interval)
     {
+        AQM_COUNT(m_counters.aredUpdates);
         UpdateMaxP(newAve);
     }
     else if (m_isFengAdaptive)
     {
+        AQM_COUNT(m_counters.fengUpdates);
         UpdateMaxPFeng(newAve); // Update m_curMaxP in MIMD fashion.
     }
+    if (m_eventLog && m_curMaxP != curMaxP)
+    {
+        m_eventLog->Log(AQM_EVENT_PROBABILITY, AQM_EVENT_NO_REASON, 0, nQueued, m_curMaxP);
+    }
 
     return newAve;
 }
@@ -686,8 +953,10 @@ RedQueueDisc::DropEarly(Ptr<QueueDiscItem> item, uint32_t qSize)
         }
     }
 
+    AQM_COUNT(m_counters.rngComparisons);
     if (u <= m_vProb)
     {
+        AQM_COUNT(m_counters.rngHits);
         NS_LOG_LOGIC("u <= m_vProb; u " << u << "; m_vProb " << m_vProb);
 
         // DROP or MARK
@@ -706,45 +975,21 @@ double
 RedQueueDisc::CalculatePNew()
 {
     NS_LOG_FUNCTION(this);
-    double p;
 
-    if (m_isGentle && m_qAvg >= m_maxTh)
+    if (!m_dropCurve.IsEmpty())
     {
-        // p ranges from m_curMaxP to 1 as the average queue
-        // size ranges from m_maxTh to twice m_maxTh
-        p = m_vC * m_qAvg + m_vD;
-    }
-    else if (!m_isGentle && m_qAvg >= m_maxTh)
-    {
-        /*
-         * OLD: p continues to range linearly above m_curMaxP as
-         * the average queue size ranges above m_maxTh.
-         * NEW: p is set to 1.0
-         */
-        p = 1.0;
-    }
-    else
-    {
-        /*
-         * p ranges from 0 to m_curMaxP as the average queue size ranges from
-         * m_minTh to m_maxTh
-         */
-        p = m_vA * m_qAvg + m_vB;
-
-        if (m_isNonlinear)
-        {
-            p *= p * 1.5;
-        }
-
-        p *= m_curMaxP;
+        return m_dropCurve.Evaluate(m_qAvg);
     }
 
-    if (p > 1.0)
-    {
-        p = 1.0;
-    }
-
-    return p;
+    return RedDropCurve(m_qAvg,
+                        m_vA,
+                        m_vB,
+                        m_vC,
+                        m_vD,
+                        m_maxTh,
+                        m_curMaxP,
+                        m_isGentle,
+                        m_isNonlinear);
 }
 
 // Returns a probability using these function parameters for the DropEarly function
@@ -759,32 +1004,7 @@ RedQueueDisc::ModifyP(double p, uint32_t size)
         count1 = (double)(m_countBytes / m_meanPktSize);
     }
 
-    if (m_isWait)
-    {
-        if (count1 * p < 1.0)
-        {
-            p = 0.0;
-        }
-        else if (count1 * p < 2.0)
-        {
-            p /= (2.0 - count1 * p);
-        }
-        else
-        {
-            p = 1.0;
-        }
-    }
-    else
-    {
-        if (count1 * p < 1.0)
-        {
-            p /= (1.0 - count1 * p);
-        }
-        else
-        {
-            p = 1.0;
-        }
-    }
+    p = RedSpacedProbability(p, count1, m_isWait);
 
     if ((GetMaxSize().GetUnit() == QueueSizeUnit::BYTES) && (p < 1.0))
     {
@@ -803,43 +1023,51 @@ Ptr<QueueDiscItem>
 RedQueueDisc::DoDequeue()
 {
     NS_LOG_FUNCTION(this);
+    CycleScope profile(m_profileCycles ? &m_dequeueCycles : nullptr);
 
-    if (GetInternalQueue(0)->IsEmpty())
-    {
-        NS_LOG_LOGIC("Queue empty");
-        m_idle = 1;
-        m_idleTime = Simulator::Now();
-
-        return nullptr;
-    }
-    else
+    while (!m_queue->IsEmpty())
     {
         m_idle = 0;
-        Ptr<QueueDiscItem> item = GetInternalQueue(0)->Dequeue();
+        Ptr<QueueDiscItem> item = m_queue->Dequeue();
+        Time sojourn = Simulator::Now() - item->GetTimeStamp();
+        m_sojourn.Record(sojourn);
+
+        if (m_stepMarking && !m_stepSojournK.IsZero() && sojourn > m_stepSojournK &&
+            !StepMark(item))
+        {
+            DropAfterDequeue(item, STEP_DROP_ID);
+            continue;
+        }
 
         NS_LOG_LOGIC("Popped " << item);
 
-        NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-        NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+        NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+        NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
         return item;
     }
+
+    NS_LOG_LOGIC("Queue empty");
+    m_idle = 1;
+    m_idleTime = Simulator::Now();
+
+    return nullptr;
 }
 
 Ptr<const QueueDiscItem>
 RedQueueDisc::DoPeek()
 {
     NS_LOG_FUNCTION(this);
-    if (GetInternalQueue(0)->IsEmpty())
+    if (m_queue->IsEmpty())
     {
         NS_LOG_LOGIC("Queue empty");
         return nullptr;
     }
 
-    Ptr<const QueueDiscItem> item = GetInternalQueue(0)->Peek();
+    Ptr<const QueueDiscItem> item = m_queue->Peek();
 
-    NS_LOG_LOGIC("Number packets " << GetInternalQueue(0)->GetNPackets());
-    NS_LOG_LOGIC("Number bytes " << GetInternalQueue(0)->GetNBytes());
+    NS_LOG_LOGIC("Number packets " << m_queue->GetNPackets());
+    NS_LOG_LOGIC("Number bytes " << m_queue->GetNBytes());
 
     return item;
 }
@@ -873,12 +1101,27 @@ RedQueueDisc::CheckConfig()
         NS_LOG_ERROR("RedQueueDisc needs 1 internal queue");
         return false;
     }
+    m_queue = GetInternalQueue(0);
 
     if ((m_isARED || m_isAdaptMaxP) && m_isFengAdaptive)
     {
         NS_LOG_ERROR("m_isAdaptMaxP and m_isFengAdaptive cannot be simultaneously true");
     }
 
+    if (!m_dropCurveSpec.empty())
+    {
+        std::string error;
+        if (!m_dropCurve.Compile(m_dropCurveSpec, m_dropCurveTableSize, error))
+        {
+            NS_LOG_ERROR("Invalid DropCurve \"" << m_dropCurveSpec << "\": " << error);
+            return false;
+        }
+        if (m_isARED || m_isAdaptMaxP || m_isFengAdaptive)
+        {
+            NS_LOG_WARN("DropCurve gives absolute probabilities, m_curMaxP is not applied");
+        }
+    }
+
     return true;
 }
 
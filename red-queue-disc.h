@@ -49,12 +49,20 @@
 #ifndef RED_QUEUE_DISC_H
 #define RED_QUEUE_DISC_H
 
+#include "aqm-counters.h"
+#include "aqm-event-log.h"
+#include "aqm-reasons.h"
+#include "cycle-counter.h"
+#include "drop-curve-table.h"
 #include "queue-disc.h"
+#include "shared-buffer-manager.h"
+#include "sojourn-histogram.h"
 
 #include "ns3/boolean.h"
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/traced-value.h"
 
 namespace ns3
 {
@@ -65,6 +73,12 @@ class TraceContainer;
  * \ingroup traffic-control
  *
  * \brief A RED packet queue disc
+ *
+ * The average queue length, the current max_p and the drop probability of
+ * the last arrival are exported as the QueueAverage, CurMaxP and
+ * DropProbability trace sources. They fire when a value changes by at least
+ * TraceDeadband (any change by default); the drop probability also fires
+ * when it falls back to zero.
  */
 class RedQueueDisc : public QueueDisc
 {
@@ -182,12 +196,116 @@ class RedQueueDisc : public QueueDisc
      */
     int64_t AssignStreams(int64_t stream);
 
+    /**
+     * \brief Get the histogram of the time dequeued packets spent in the queue.
+     *
+     * \returns The sojourn time histogram.
+     */
+    const SojournHistogram& GetSojournHistogram() const;
+
+    /**
+     * \brief Get the ticks spent in DoEnqueue, counted if ProfileCycles is set.
+     *
+     * \returns The enqueue cycle account.
+     */
+    const CycleAccount& GetEnqueueCycles() const;
+
+    /**
+     * \brief Get the ticks spent in DoDequeue, counted if ProfileCycles is set.
+     *
+     * \returns The dequeue cycle account.
+     */
+    const CycleAccount& GetDequeueCycles() const;
+
+    /**
+     * \brief Get the hot-path counters, counted if built with NS3_AQM_COUNTERS.
+     *
+     * \returns The hot-path counters.
+     */
+    const RedHotPathCounters& GetHotPathCounters() const;
+
+    /**
+     * \brief Get the average queue length.
+     *
+     * \returns The average queue length (bytes or packets).
+     */
+    double GetQueueAverage() const;
+
+    /**
+     * \brief Get the probability of the last early drop (or mark) decision.
+     *
+     * \returns The drop probability.
+     */
+    double GetDropProbability() const;
+
+    /**
+     * \brief Get the probability the drop curve gives for the current
+     * average queue length, before the "count" spacing of ModifyP.
+     *
+     * Unlike GetDropProbability, this does not jump between packets, so it
+     * can drive another AQM (e.g. the coupling of DualQCoupledQueueDisc).
+     *
+     * \returns The curve probability, 0 below MinTh.
+     */
+    double GetCurveProbability();
+
+    /**
+     * \brief Share the packet buffer of other queue discs of the node.
+     *
+     * Every arriving packet must then be admitted by the manager before the
+     * RED decision; refused packets are dropped with
+     * SharedBufferManager::ADMISSION_DROP.
+     *
+     * \param manager The shared-buffer manager.
+     */
+    void SetSharedBuffer(Ptr<SharedBufferManager> manager);
+
+    /**
+     * \brief Report drops, marks and max_p updates to a binary event log.
+     *
+     * Called by AqmEventLog::Start.
+     *
+     * \param log The event log.
+     */
+    void SetEventLog(Ptr<AqmEventLog> log);
+
+    /**
+     * \brief Get the number of packets marked in step-marking mode.
+     *
+     * \returns The number of step marks.
+     */
+    uint64_t GetNStepMarks() const;
+
+    /**
+     * \brief Get the number of packets dropped in step-marking mode because
+     * they were not ECN capable.
+     *
+     * \returns The number of step drops.
+     */
+    uint64_t GetNStepDrops() const;
+
+    /**
+     * \brief Print the statistics RED keeps on top of QueueDisc::Stats.
+     *
+     * \param os The output stream.
+     */
+    void PrintAqmStats(std::ostream& os) const;
+
     // Reasons for dropping packets
     static constexpr const char* UNFORCED_DROP = "Unforced drop"; //!< Early probability drops
     static constexpr const char* FORCED_DROP = "Forced drop"; //!< Forced drops, m_qAvg > m_maxTh
     // Reasons for marking packets
     static constexpr const char* UNFORCED_MARK = "Unforced mark"; //!< Early probability marks
     static constexpr const char* FORCED_MARK = "Forced mark"; //!< Forced marks, m_qAvg > m_maxTh
+    static constexpr const char* STEP_MARK = "Step mark"; //!< Step-marking mode, queue above K
+    static constexpr const char* STEP_DROP = "Step drop"; //!< Step-marking mode, packet not ECN capable
+    // IDs of the reasons (see AqmReasons)
+    static const uint16_t UNFORCED_DROP_ID; //!< ID of UNFORCED_DROP
+    static const uint16_t FORCED_DROP_ID;   //!< ID of FORCED_DROP
+    static const uint16_t UNFORCED_MARK_ID; //!< ID of UNFORCED_MARK
+    static const uint16_t FORCED_MARK_ID;   //!< ID of FORCED_MARK
+    static const uint16_t STEP_MARK_ID;     //!< ID of STEP_MARK
+    static const uint16_t STEP_DROP_ID;     //!< ID of STEP_DROP
 
   protected:
     /**
@@ -198,6 +316,8 @@ class RedQueueDisc : public QueueDisc
     double m_maxTh;   //!< Maximum threshold for m_qAvg (bytes or packets), should be >= 2 * m_minTh
     double m_lInterm; //!< The max probability of dropping a packet
     double m_qAvg;           //!< Average queue length
+    DropCurveTable m_dropCurve; //!< Breakpoint drop curve, empty to use the built-in curves
+    RedHotPathCounters m_counters; //!< Hot-path counters (see aqm-counters.h)
 
   private:
     bool DoEnqueue(Ptr<QueueDiscItem> item) override;
@@ -252,7 +372,48 @@ class RedQueueDisc : public QueueDisc
      * \returns Prob. of packet drop
      */
     double ModifyP(double p, uint32_t size);
-
+    /**
+     * \brief Mark a packet in step-marking mode
+     * \param item queue item
+     * \returns false if the packet is not ECN capable and must be dropped
+     */
+    bool StepMark(Ptr<QueueDiscItem> item);
+    /**
+     * \brief Log a drop or mark if an event log is set
+     * \param type AQM_EVENT_DROP or AQM_EVENT_MARK
+     * \param reason The reason ID
+     * \param item The dropped or marked item
+     */
+    void Report(uint8_t type, uint16_t reason, Ptr<const QueueDiscItem> item);
+    /**
+     * \brief Drop a packet before enqueue for a registered reason.
+     *
+     * Every drop decided by RED goes through this overload, so that the
+     * event log gets the reason ID; QueueDisc::Stats counts the drop under
+     * the reason string as usual.
+     *
+     * \param item The dropped item
+     * \param reason The reason ID (see AqmReasons)
+     */
+    void DropBeforeEnqueue(Ptr<const QueueDiscItem> item, uint16_t reason);
+    /**
+     * \brief Drop a packet after dequeue for a registered reason.
+     * \param item The dropped item
+     * \param reason The reason ID (see AqmReasons)
+     */
+    void DropAfterDequeue(Ptr<const QueueDiscItem> item, uint16_t reason);
+    /**
+     * \brief Mark a packet for a registered reason.
+     * \param item The item to mark
+     * \param reason The reason ID (see AqmReasons)
+     * \returns false if the packet could not be marked
+     */
+    bool Mark(Ptr<QueueDiscItem> item, uint16_t reason);
+    /**
+     * \brief Publish m_qAvg, m_curMaxP and m_vProb to their trace sources,
+     * skipping changes smaller than the deadband
+     */
+    void UpdateTraces();
     // ** Variables supplied by user
     uint32_t m_meanPktSize; //!< Avg pkt size
     uint32_t m_idlePktSize; //!< Avg pkt size used during idle times
@@ -277,6 +438,13 @@ class RedQueueDisc : public QueueDisc
     Time m_linkDelay;         //!< Link delay
     bool m_useEcn;            //!< True if ECN is used (packets are marked instead of being dropped)
     bool m_useHardDrop;       //!< True if packets are always dropped above max threshold
+    bool m_stepMarking;       //!< True to mark on the instantaneous queue only (DCTCP style)
+    QueueSize m_stepK;        //!< Step-marking threshold on the queue length
+    Time m_stepSojournK;      //!< Step-marking threshold on the sojourn time, zero if unused
+    std::string m_dropCurveSpec;   //!< Breakpoints of the drop curve, empty for none
+    uint32_t m_dropCurveTableSize; //!< Number of intervals of the drop curve table
+    double m_traceDeadband;        //!< Smallest change reported by the trace sources
+    bool m_profileCycles;          //!< True to count the ticks spent in DoEnqueue and DoDequeue
 
     // ** Variables maintained by RED
     double m_vA;             //!< 1.0 / (m_maxTh - m_minTh)
@@ -300,8 +468,20 @@ class RedQueueDisc : public QueueDisc
      */
     uint32_t m_cautious;
     Time m_idleTime; //!< Start of current idle period
+    uint64_t m_nStepMarks; //!< Packets marked in step-marking mode
+    uint64_t m_nStepDrops; //!< Packets dropped in step-marking mode
+    SojournHistogram m_sojourn; //!< Sojourn times of the dequeued packets
+    CycleAccount m_enqueueCycles; //!< Ticks spent in DoEnqueue
+    CycleAccount m_dequeueCycles; //!< Ticks spent in DoDequeue
+    TracedValue<double> m_qAvgTrace;    //!< Last traced m_qAvg
+    TracedValue<double> m_curMaxPTrace; //!< Last traced m_curMaxP
+    TracedValue<double> m_vProbTrace;   //!< Last traced m_vProb
 
     Ptr<UniformRandomVariable> m_uv; //!< rng stream
+    Ptr<InternalQueue> m_queue;      //!< The internal queue, cached by CheckConfig
+    Ptr<SharedBufferManager> m_sharedBuffer; //!< Shared-buffer manager, if any
+    uint32_t m_sharedBufferPort;             //!< Port index in the shared-buffer manager
+    Ptr<AqmEventLog> m_eventLog;             //!< Binary event log, if any
 };
 
 }; // namespace ns3
@@ -0,0 +1,263 @@
+#ifndef SCALABLE_DUMBBELL_HELPER_H
+#define SCALABLE_DUMBBELL_HELPER_H
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief Dumbbell builder for topologies with tens of thousands of leaves
+ *
+ * Offers the accessors of PointToPointDumbbellHelper, but
+ *  - creates the leaf nodes with one NodeContainer::Create call per side,
+ *  - installs an IPv4-only stack with static routing on all nodes at once,
+ *  - assigns addresses directly on the interfaces, one /30 per leaf link,
+ *    without the per-device default queue disc Ipv4AddressHelper installs,
+ *  - installs the routes that follow from the dumbbell structure (leaf
+ *    default routes and one aggregate route per router) instead of running
+ *    the global route computation.
+ *
+ * Leaf links therefore have no traffic control layer queue disc; only the
+ * device queue buffers packets on them.
+ */
+class ScalableDumbbellHelper
+{
+  public:
+    /**
+     * @brief Create the nodes and point-to-point links of the dumbbell
+     * @param nLeftLeaf number of left side leaf nodes
+     * @param leftHelper helper for the left leaf links
+     * @param nRightLeaf number of right side leaf nodes
+     * @param rightHelper helper for the right leaf links
+     * @param bottleneckHelper helper for the link between the routers
+     */
+    ScalableDumbbellHelper(uint32_t nLeftLeaf,
+                           PointToPointHelper leftHelper,
+                           uint32_t nRightLeaf,
+                           PointToPointHelper rightHelper,
+                           PointToPointHelper bottleneckHelper)
+    {
+        m_routers.Create(2);
+        m_leftLeaf.Create(nLeftLeaf);
+        m_rightLeaf.Create(nRightLeaf);
+
+        // The bottleneck is device 0 of both routers, as in PointToPointDumbbellHelper
+        m_routerDevices = bottleneckHelper.Install(m_routers);
+
+        m_leftLeafDevices.reserve(nLeftLeaf);
+        for (uint32_t i = 0; i < nLeftLeaf; ++i)
+        {
+            m_leftLeafDevices.push_back(leftHelper.Install(m_leftLeaf.Get(i), GetLeft()));
+        }
+        m_rightLeafDevices.reserve(nRightLeaf);
+        for (uint32_t i = 0; i < nRightLeaf; ++i)
+        {
+            m_rightLeafDevices.push_back(rightHelper.Install(m_rightLeaf.Get(i), GetRight()));
+        }
+    }
+
+    /// @return the left side router
+    Ptr<Node> GetLeft() const
+    {
+        return m_routers.Get(0);
+    }
+
+    /// @return the right side router
+    Ptr<Node> GetRight() const
+    {
+        return m_routers.Get(1);
+    }
+
+    /**
+     * @param i index of the left leaf
+     * @return the left leaf node
+     */
+    Ptr<Node> GetLeft(uint32_t i) const
+    {
+        return m_leftLeaf.Get(i);
+    }
+
+    /**
+     * @param i index of the right leaf
+     * @return the right leaf node
+     */
+    Ptr<Node> GetRight(uint32_t i) const
+    {
+        return m_rightLeaf.Get(i);
+    }
+
+    /// @return the number of left leaves
+    uint32_t LeftCount() const
+    {
+        return m_leftLeaf.GetN();
+    }
+
+    /// @return the number of right leaves
+    uint32_t RightCount() const
+    {
+        return m_rightLeaf.GetN();
+    }
+
+    /**
+     * @param i index of the left leaf
+     * @return the address of the left leaf
+     */
+    Ipv4Address GetLeftIpv4Address(uint32_t i) const
+    {
+        return m_leftLeafAddresses[i];
+    }
+
+    /**
+     * @param i index of the right leaf
+     * @return the address of the right leaf
+     */
+    Ipv4Address GetRightIpv4Address(uint32_t i) const
+    {
+        return m_rightLeafAddresses[i];
+    }
+
+    /**
+     * @brief Install an IPv4-only stack with static routing on every node
+     */
+    void InstallStack()
+    {
+        InternetStackHelper stack;
+        stack.SetIpv6StackInstall(false);
+        stack.SetRoutingHelper(Ipv4StaticRoutingHelper());
+        stack.Install(m_routers);
+        stack.Install(m_leftLeaf);
+        stack.Install(m_rightLeaf);
+    }
+
+    /**
+     * @brief Assign the addresses and install the static routes
+     *
+     * Leaf i of a side gets the /30 network base + 4 i, with the router at
+     * .1 and the leaf at .2. Each side's base must start a block large
+     * enough for all its leaves; the opposite router reaches it through a
+     * single route with the given aggregate mask.
+     *
+     * @param leftBase first address of the left leaf block
+     * @param rightBase first address of the right leaf block
+     * @param aggregateMask mask covering a whole leaf block
+     * @param routerBase /30 network of the bottleneck link
+     */
+    void AssignIpv4Addresses(Ipv4Address leftBase,
+                             Ipv4Address rightBase,
+                             Ipv4Mask aggregateMask,
+                             Ipv4Address routerBase)
+    {
+        NS_ABORT_MSG_IF(std::max(LeftCount(), RightCount()) > GetMaxLeaves(aggregateMask),
+                        "A leaf block of mask " << aggregateMask << " holds at most "
+                                                << GetMaxLeaves(aggregateMask) << " leaves");
+        Ipv4StaticRoutingHelper routingHelper;
+        Ipv4Mask linkMask("255.255.255.252");
+
+        uint32_t leftRouterIf =
+            AddInterface(m_routerDevices.Get(0), Ipv4Address(routerBase.Get() + 1), linkMask);
+        uint32_t rightRouterIf =
+            AddInterface(m_routerDevices.Get(1), Ipv4Address(routerBase.Get() + 2), linkMask);
+
+        AssignLeaves(m_leftLeafDevices, leftBase, m_leftLeafAddresses);
+        AssignLeaves(m_rightLeafDevices, rightBase, m_rightLeafAddresses);
+
+        // The routers reach the far side block through the bottleneck
+        routingHelper.GetStaticRouting(GetLeft()->GetObject<Ipv4>())
+            ->AddNetworkRouteTo(rightBase,
+                                aggregateMask,
+                                Ipv4Address(routerBase.Get() + 2),
+                                leftRouterIf);
+        routingHelper.GetStaticRouting(GetRight()->GetObject<Ipv4>())
+            ->AddNetworkRouteTo(leftBase,
+                                aggregateMask,
+                                Ipv4Address(routerBase.Get() + 1),
+                                rightRouterIf);
+    }
+
+    /**
+     * @param aggregateMask mask covering a whole leaf block
+     * @return the number of /30 leaf links a block of that mask holds
+     */
+    static uint64_t GetMaxLeaves(Ipv4Mask aggregateMask)
+    {
+        return (static_cast<uint64_t>(~aggregateMask.Get()) + 1) / 4;
+    }
+
+    /// @return the peak resident set size of the process, in KiB
+    static long GetPeakRss()
+    {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+  private:
+    /**
+     * @brief Add an interface for a device and bring it up
+     * @param device the device
+     * @param address the interface address
+     * @param mask the interface mask
+     * @return the interface index
+     */
+    static uint32_t AddInterface(Ptr<NetDevice> device, Ipv4Address address, Ipv4Mask mask)
+    {
+        Ptr<Ipv4> ipv4 = device->GetNode()->GetObject<Ipv4>();
+        int32_t ifIndex = ipv4->GetInterfaceForDevice(device);
+        if (ifIndex == -1)
+        {
+            ifIndex = ipv4->AddInterface(device);
+        }
+        ipv4->AddAddress(ifIndex, Ipv4InterfaceAddress(address, mask));
+        ipv4->SetMetric(ifIndex, 1);
+        ipv4->SetUp(ifIndex);
+        return ifIndex;
+    }
+
+    /**
+     * @brief Number the leaf links of one side and give each leaf its default route
+     * @param devices leaf link devices, leaf side first
+     * @param base first address of the side's block
+     * @param addresses receives the leaf addresses
+     */
+    static void AssignLeaves(const std::vector<NetDeviceContainer>& devices,
+                             Ipv4Address base,
+                             std::vector<Ipv4Address>& addresses)
+    {
+        Ipv4StaticRoutingHelper routingHelper;
+        Ipv4Mask linkMask("255.255.255.252");
+        addresses.reserve(devices.size());
+        for (uint32_t i = 0; i < devices.size(); ++i)
+        {
+            uint32_t network = base.Get() + 4 * i;
+            Ipv4Address router(network + 1);
+            Ipv4Address leaf(network + 2);
+            uint32_t leafIf = AddInterface(devices[i].Get(0), leaf, linkMask);
+            AddInterface(devices[i].Get(1), router, linkMask);
+            routingHelper.GetStaticRouting(devices[i].Get(0)->GetNode()->GetObject<Ipv4>())
+                ->SetDefaultRoute(router, leafIf);
+            addresses.push_back(leaf);
+        }
+    }
+
+    NodeContainer m_routers;                           //!< Left and right routers
+    NodeContainer m_leftLeaf;                          //!< Left leaf nodes
+    NodeContainer m_rightLeaf;                         //!< Right leaf nodes
+    NetDeviceContainer m_routerDevices;                //!< Bottleneck devices
+    std::vector<NetDeviceContainer> m_leftLeafDevices;  //!< Left leaf links (leaf, router)
+    std::vector<NetDeviceContainer> m_rightLeafDevices; //!< Right leaf links (leaf, router)
+    std::vector<Ipv4Address> m_leftLeafAddresses;      //!< Left leaf addresses
+    std::vector<Ipv4Address> m_rightLeafAddresses;     //!< Right leaf addresses
+};
+
+} // namespace ns3
+
+#endif // SCALABLE_DUMBBELL_HELPER_H
@@ -0,0 +1,516 @@
+#include "shadow-aqm-queue-disc.h"
+
+#include "blue-queue-disc.h"
+#include "dualq-coupled-queue-disc.h"
+#include "red-queue-disc.h"
+
+#include "ns3/log.h"
+#include "ns3/object-factory.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("ShadowAqmQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED(ShadowAqmQueueDisc);
+
+/**
+ * @brief Decisions of the primary and of the shadows on one arrival
+ *
+ * A queue disc may still mark or drop a packet when dequeuing it, so its
+ * decision on an arrival is only final once the packet has left it. The
+ * record is shared by the shadow copies of the arrival and, while the
+ * primary holds it, by ShadowAqmQueueDisc::m_arrivals.
+ */
+class ShadowArrival : public SimpleRefCount<ShadowArrival>
+{
+  public:
+    /**
+     * @param nShadows the number of shadows
+     */
+    explicit ShadowArrival(std::size_t nShadows)
+        : shadowSignal(nShadows, false),
+          shadowDone(nShadows, false)
+    {
+    }
+
+    bool primarySignal = false;     //!< True if the primary dropped or marked the arrival
+    bool primaryDone = false;       //!< True once the arrival has left the primary
+    std::vector<bool> shadowSignal; //!< True if the shadow dropped or marked its copy
+    std::vector<bool> shadowDone;   //!< True once the copy has left the shadow
+};
+
+/**
+ * @brief Copy of an arrival handed to a shadow queue disc
+ *
+ * Shares the packet of the real item and reports its size, fields and
+ * hash, but marking it only tells whether the packet is ECN-capable: the
+ * real packet is left untouched. Never sent, so it has no header to add.
+ * Each shadow gets its own copy, so that the time stamp and the state a
+ * queue disc keeps in its items are not shared.
+ */
+class ShadowQueueDiscItem : public QueueDiscItem
+{
+  public:
+    /**
+     * @param item the real item
+     * @param arrival the decisions on the arrival
+     * @param shadow the index of the shadow the copy is for
+     */
+    ShadowQueueDiscItem(Ptr<const QueueDiscItem> item,
+                        Ptr<ShadowArrival> arrival,
+                        std::size_t shadow)
+        : QueueDiscItem(item->GetPacket(), item->GetAddress(), item->GetProtocol()),
+          m_item(item),
+          m_arrival(arrival),
+          m_shadow(shadow)
+    {
+        uint8_t tos;
+        m_ecnCapable = item->GetUint8Value(QueueItem::IP_DSFIELD, tos) && (tos & 0x3);
+    }
+
+    /// @return the decisions on the arrival
+    Ptr<ShadowArrival> GetArrival() const
+    {
+        return m_arrival;
+    }
+
+    /// @return the index of the shadow the copy is for
+    std::size_t GetShadow() const
+    {
+        return m_shadow;
+    }
+
+    uint32_t GetSize() const override
+    {
+        return m_item->GetSize();
+    }
+
+    void AddHeader() override
+    {
+    }
+
+    bool Mark() override
+    {
+        return m_ecnCapable;
+    }
+
+    bool GetUint8Value(QueueItem::Uint8Values field, uint8_t& value) const override
+    {
+        return m_item->GetUint8Value(field, value);
+    }
+
+    uint32_t Hash(uint32_t perturbation) const override
+    {
+        return m_item->Hash(perturbation);
+    }
+
+  private:
+    Ptr<const QueueDiscItem> m_item; //!< The real item
+    Ptr<ShadowArrival> m_arrival;    //!< Decisions on the arrival
+    std::size_t m_shadow;            //!< Index of the shadow
+    bool m_ecnCapable;               //!< True if the real packet is ECT or CE
+};
+
+TypeId
+ShadowAqmQueueDisc::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::ShadowAqmQueueDisc")
+            .SetParent<QueueDisc>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<ShadowAqmQueueDisc>()
+            .AddAttribute("PrimaryQueueDisc",
+                          "Type of the primary queue disc created if no class is configured",
+                          StringValue("ns3::BlueQueueDisc"),
+                          MakeStringAccessor(&ShadowAqmQueueDisc::m_primaryType),
+                          MakeStringChecker())
+            .AddAttribute("ShadowQueueDiscs",
+                          "Comma-separated types of the shadow queue discs created if none is added",
+                          StringValue("ns3::RedQueueDisc"),
+                          MakeStringAccessor(&ShadowAqmQueueDisc::m_shadowTypes),
+                          MakeStringChecker())
+            .AddAttribute("LinkRate",
+                          "Rate at which the virtual queues of the shadows are served, "
+                          "normally that of the link the primary feeds",
+                          DataRateValue(DataRate("0bps")),
+                          MakeDataRateAccessor(&ShadowAqmQueueDisc::m_linkRate),
+                          MakeDataRateChecker());
+    return tid;
+}
+
+ShadowAqmQueueDisc::ShadowAqmQueueDisc()
+    : QueueDisc(QueueDiscSizePolicy::SINGLE_CHILD_QUEUE_DISC)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+ShadowAqmQueueDisc::~ShadowAqmQueueDisc()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+ShadowAqmQueueDisc::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (auto& s : m_shadows)
+    {
+        s.service.Cancel();
+        s.qd->Dispose();
+    }
+    m_shadows.clear();
+    m_arrivals.clear();
+    m_primary = nullptr;
+    QueueDisc::DoDispose();
+}
+
+void
+ShadowAqmQueueDisc::AddShadow(Ptr<QueueDisc> qd)
+{
+    NS_LOG_FUNCTION(this << qd);
+    Shadow s;
+    s.qd = qd;
+    m_shadows.push_back(s);
+}
+
+Ptr<QueueDisc>
+ShadowAqmQueueDisc::GetPrimary()
+{
+    if (GetNQueueDiscClasses() == 0)
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(m_primaryType);
+        Ptr<QueueDisc> qd = factory.Create<QueueDisc>();
+        qd->Initialize();
+        Ptr<QueueDiscClass> c = CreateObject<QueueDiscClass>();
+        c->SetQueueDisc(qd);
+        AddQueueDiscClass(c);
+    }
+    if (!m_primary)
+    {
+        m_primary = GetQueueDiscClass(0)->GetQueueDisc();
+    }
+    return m_primary;
+}
+
+std::size_t
+ShadowAqmQueueDisc::GetNShadows() const
+{
+    return m_shadows.size();
+}
+
+Ptr<QueueDisc>
+ShadowAqmQueueDisc::GetShadow(std::size_t i) const
+{
+    NS_ASSERT(i < m_shadows.size());
+    return m_shadows[i].qd;
+}
+
+const ShadowAqmQueueDisc::ShadowStats&
+ShadowAqmQueueDisc::GetShadowStats(std::size_t i)
+{
+    NS_ASSERT(i < m_shadows.size());
+    UpdateLength(m_shadows[i]);
+    return m_shadows[i].stats;
+}
+
+double
+ShadowAqmQueueDisc::GetMeanShadowLength(std::size_t i)
+{
+    double elapsed = (Simulator::Now() - m_start).GetSeconds();
+    const ShadowStats& stats = GetShadowStats(i);
+    return elapsed > 0 ? stats.lengthSeconds / elapsed : 0;
+}
+
+void
+ShadowAqmQueueDisc::PrintQueueDisc(std::ostream& os, Ptr<QueueDisc> qd)
+{
+    if (Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc>(qd))
+    {
+        red->PrintAqmStats(os);
+    }
+    else if (Ptr<BlueQueueDisc> blue = DynamicCast<BlueQueueDisc>(qd))
+    {
+        blue->PrintAqmStats(os);
+    }
+    else if (Ptr<DualQCoupledQueueDisc> dualq = DynamicCast<DualQCoupledQueueDisc>(qd))
+    {
+        dualq->PrintAqmStats(os);
+    }
+}
+
+void
+ShadowAqmQueueDisc::PrintAqmStats(std::ostream& os)
+{
+    os << "Primary " << m_primary->GetInstanceTypeId().GetName() << ":" << std::endl;
+    PrintQueueDisc(os, m_primary);
+    for (std::size_t i = 0; i < m_shadows.size(); ++i)
+    {
+        const ShadowStats& stats = GetShadowStats(i);
+        os << "Shadow " << i << " " << m_shadows[i].qd->GetInstanceTypeId().GetName() << ": "
+           << stats.arrivals << " arrivals, " << stats.drops << " dropped, " << stats.marks
+           << " marked" << std::endl;
+        os << "  Signals: " << stats.bothSignals << " with the primary, " << stats.shadowOnly
+           << " shadow only, " << stats.primaryOnly << " primary only" << std::endl;
+        os << "  Virtual queue: mean " << GetMeanShadowLength(i) << ", max " << stats.maxLength
+           << std::endl;
+        os << "  " << stats.sojourn << std::endl;
+        PrintQueueDisc(os, m_shadows[i].qd);
+    }
+}
+
+void
+ShadowAqmQueueDisc::UpdateLength(Shadow& s)
+{
+    Time now = Simulator::Now();
+    s.stats.lengthSeconds += s.qd->GetCurrentSize().GetValue() * (now - s.lastChange).GetSeconds();
+    s.lastChange = now;
+}
+
+void
+ShadowAqmQueueDisc::Offer(std::size_t i, Ptr<ShadowQueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << i << item);
+
+    Shadow& s = m_shadows[i];
+    UpdateLength(s);
+    s.stats.arrivals++;
+    if (!s.qd->Enqueue(item))
+    {
+        s.stats.drops++;
+        ShadowDone(item, true);
+        return;
+    }
+    s.stats.maxLength = std::max(s.stats.maxLength, s.qd->GetCurrentSize().GetValue());
+    if (!s.service.IsPending())
+    {
+        // The virtual link is idle: the packet is sent at once
+        Serve(i);
+    }
+}
+
+void
+ShadowAqmQueueDisc::Serve(std::size_t i)
+{
+    NS_LOG_FUNCTION(this << i);
+
+    Shadow& s = m_shadows[i];
+    UpdateLength(s);
+    // Marks and drops decided by the shadow while dequeuing reach the
+    // trace sinks before the item is returned
+    Ptr<QueueDiscItem> item = s.qd->Dequeue();
+    if (!item)
+    {
+        NS_LOG_LOGIC("Shadow " << i << " idle");
+        return;
+    }
+    s.stats.sojourn.Record(Simulator::Now() - item->GetTimeStamp());
+    ShadowDone(StaticCast<ShadowQueueDiscItem>(item), false);
+    s.service = Simulator::Schedule(m_linkRate.CalculateBytesTxTime(item->GetSize()),
+                                    &ShadowAqmQueueDisc::Serve,
+                                    this,
+                                    i);
+}
+
+void
+ShadowAqmQueueDisc::ShadowDone(Ptr<const ShadowQueueDiscItem> item, bool dropped)
+{
+    Ptr<ShadowArrival> arrival = item->GetArrival();
+    std::size_t i = item->GetShadow();
+    if (dropped)
+    {
+        arrival->shadowSignal[i] = true;
+    }
+    arrival->shadowDone[i] = true;
+    if (arrival->primaryDone)
+    {
+        Pair(i, *arrival);
+    }
+}
+
+void
+ShadowAqmQueueDisc::PrimaryDone(Ptr<ShadowArrival> arrival, bool dropped)
+{
+    if (dropped)
+    {
+        arrival->primarySignal = true;
+    }
+    arrival->primaryDone = true;
+    for (std::size_t i = 0; i < m_shadows.size(); ++i)
+    {
+        if (arrival->shadowDone[i])
+        {
+            Pair(i, *arrival);
+        }
+    }
+}
+
+void
+ShadowAqmQueueDisc::Pair(std::size_t i, const ShadowArrival& arrival)
+{
+    ShadowStats& stats = m_shadows[i].stats;
+    if (arrival.shadowSignal[i] && arrival.primarySignal)
+    {
+        stats.bothSignals++;
+    }
+    else if (arrival.shadowSignal[i])
+    {
+        stats.shadowOnly++;
+    }
+    else if (arrival.primarySignal)
+    {
+        stats.primaryOnly++;
+    }
+}
+
+void
+ShadowAqmQueueDisc::ShadowMarked(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    Ptr<const ShadowQueueDiscItem> copy = StaticCast<const ShadowQueueDiscItem>(item);
+    m_shadows[copy->GetShadow()].stats.marks++;
+    copy->GetArrival()->shadowSignal[copy->GetShadow()] = true;
+}
+
+void
+ShadowAqmQueueDisc::ShadowDropped(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    Ptr<const ShadowQueueDiscItem> copy = StaticCast<const ShadowQueueDiscItem>(item);
+    m_shadows[copy->GetShadow()].stats.drops++;
+    ShadowDone(copy, true);
+}
+
+void
+ShadowAqmQueueDisc::PrimaryMarked(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    auto it = m_arrivals.find(PeekPointer(item));
+    if (it != m_arrivals.end())
+    {
+        it->second->primarySignal = true;
+    }
+}
+
+void
+ShadowAqmQueueDisc::PrimaryDropped(Ptr<const QueueDiscItem> item, const char* reason)
+{
+    auto it = m_arrivals.find(PeekPointer(item));
+    if (it != m_arrivals.end())
+    {
+        PrimaryDone(it->second, true);
+        m_arrivals.erase(it);
+    }
+}
+
+bool
+ShadowAqmQueueDisc::DoEnqueue(Ptr<QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << item);
+
+    // The shadows judge the arrival before the primary can mark it
+    Ptr<ShadowArrival> arrival = Create<ShadowArrival>(m_shadows.size());
+    for (std::size_t i = 0; i < m_shadows.size(); ++i)
+    {
+        Ptr<ShadowQueueDiscItem> copy = Create<ShadowQueueDiscItem>(item, arrival, i);
+        copy->SetTimeStamp(Simulator::Now());
+        Offer(i, copy);
+    }
+
+    m_arrivals[PeekPointer(item)] = arrival;
+    // A drop by the primary is reported by QueueDisc with the child prefix
+    bool retval = m_primary->Enqueue(item);
+    if (!retval)
+    {
+        m_arrivals.erase(PeekPointer(item));
+        PrimaryDone(arrival, true);
+    }
+    return retval;
+}
+
+Ptr<QueueDiscItem>
+ShadowAqmQueueDisc::DoDequeue()
+{
+    NS_LOG_FUNCTION(this);
+    Ptr<QueueDiscItem> item = m_primary->Dequeue();
+    if (item)
+    {
+        auto it = m_arrivals.find(PeekPointer(item));
+        if (it != m_arrivals.end())
+        {
+            PrimaryDone(it->second, false);
+            m_arrivals.erase(it);
+        }
+    }
+    return item;
+}
+
+bool
+ShadowAqmQueueDisc::CheckConfig()
+{
+    NS_LOG_FUNCTION(this);
+    if (GetNPacketFilters() > 0 || GetNInternalQueues() > 0)
+    {
+        NS_LOG_ERROR("ShadowAqmQueueDisc has no packet filters and no internal queues");
+        return false;
+    }
+
+    GetPrimary();
+    if (GetNQueueDiscClasses() != 1)
+    {
+        NS_LOG_ERROR("ShadowAqmQueueDisc needs 1 class (the primary queue disc)");
+        return false;
+    }
+
+    if (m_shadows.empty())
+    {
+        std::istringstream types(m_shadowTypes);
+        std::string type;
+        while (std::getline(types, type, ','))
+        {
+            if (!type.empty())
+            {
+                ObjectFactory factory;
+                factory.SetTypeId(type);
+                AddShadow(factory.Create<QueueDisc>());
+            }
+        }
+    }
+
+    if (!m_shadows.empty() && m_linkRate.GetBitRate() == 0)
+    {
+        NS_LOG_ERROR("LinkRate must be set to serve the virtual queues of the shadows");
+        return false;
+    }
+
+    for (auto& s : m_shadows)
+    {
+        s.qd->Initialize();
+        s.qd->TraceConnectWithoutContext("Mark",
+                                         MakeCallback(&ShadowAqmQueueDisc::ShadowMarked, this));
+        s.qd->TraceConnectWithoutContext("DropAfterDequeue",
+                                         MakeCallback(&ShadowAqmQueueDisc::ShadowDropped, this));
+    }
+    m_primary->TraceConnectWithoutContext("Mark",
+                                          MakeCallback(&ShadowAqmQueueDisc::PrimaryMarked, this));
+    m_primary->TraceConnectWithoutContext("DropAfterDequeue",
+                                          MakeCallback(&ShadowAqmQueueDisc::PrimaryDropped, this));
+    return true;
+}
+
+void
+ShadowAqmQueueDisc::InitializeParams()
+{
+    NS_LOG_FUNCTION(this);
+    m_start = Simulator::Now();
+    for (auto& s : m_shadows)
+    {
+        s.stats = ShadowStats();
+        s.lastChange = m_start;
+    }
+}
+
+} // namespace ns3
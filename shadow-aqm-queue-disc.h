@@ -0,0 +1,249 @@
+#ifndef SHADOW_AQM_QUEUE_DISC_H
+#define SHADOW_AQM_QUEUE_DISC_H
+
+#include "queue-disc.h"
+#include "sojourn-histogram.h"
+
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class ShadowArrival;
+class ShadowQueueDiscItem;
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Queue disc that lets several AQMs judge the same traffic
+ *
+ * The primary queue disc (class 0, by default a BlueQueueDisc) holds the
+ * real queue: it alone decides which packets are dropped, marked and sent.
+ * Every arrival is also offered to the shadow queue discs (RedQueueDisc,
+ * DsRedQueueDisc, ...), before the primary sees it. A shadow gets its own
+ * copy of the item, so its marks never reach the packet, and keeps a
+ * virtual queue of the packets it accepted, served at LinkRate, the rate
+ * of the link the primary feeds. The shadows therefore see the same
+ * arrival process and the same service rate as the primary, but their own
+ * queue lengths, idle periods and random draws.
+ *
+ * For each shadow, the drop and mark decisions, the virtual queue length
+ * and the virtual sojourn times are recorded, together with how often the
+ * shadow and the primary agreed on signalling congestion (dropping or
+ * marking) for the same arrival. Drops and marks are taken from the Mark
+ * and DropAfterDequeue trace sources, so those decided at dequeue (e.g. the
+ * RED step marking on sojourn time) count too, and an arrival is paired
+ * once it has left both the primary and the shadow. A single run thus
+ * compares the AQMs on paired samples. The closed loop only follows the primary: the senders
+ * react to its signals, not to the shadows'.
+ *
+ * The shadows are standalone queue discs, not classes, so their drops and
+ * marks do not show up in the statistics of this queue disc.
+ */
+class ShadowAqmQueueDisc : public QueueDisc
+{
+  public:
+    /**
+     * @brief What a shadow did with the arrivals it was offered
+     */
+    struct ShadowStats
+    {
+        uint64_t arrivals = 0;      //!< Arrivals offered to the shadow
+        uint64_t drops = 0;         //!< Arrivals the shadow dropped
+        uint64_t marks = 0;         //!< Arrivals the shadow marked
+        uint64_t bothSignals = 0;   //!< Arrivals dropped or marked by the primary and the shadow
+        uint64_t primaryOnly = 0;   //!< Arrivals dropped or marked by the primary only
+        uint64_t shadowOnly = 0;    //!< Arrivals dropped or marked by the shadow only
+        uint32_t maxLength = 0;     //!< Longest virtual queue, in the unit of its MaxSize
+        double lengthSeconds = 0;   //!< Virtual queue length integrated over time
+        SojournHistogram sojourn;   //!< Virtual sojourn times of the served packets
+    };
+
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    ShadowAqmQueueDisc();
+    ~ShadowAqmQueueDisc() override;
+
+    /**
+     * @brief Add a configured shadow queue disc
+     *
+     * If no shadow is added before the queue disc is initialized, the
+     * shadows are created from the ShadowQueueDiscs attribute.
+     *
+     * @param qd the shadow, which must not be installed anywhere else
+     */
+    void AddShadow(Ptr<QueueDisc> qd);
+
+    /**
+     * @brief Get the primary queue disc
+     *
+     * Creates it from the PrimaryQueueDisc attribute if no class is
+     * configured yet, so it can be reached before the simulation starts.
+     *
+     * @return the queue disc holding the real queue
+     */
+    Ptr<QueueDisc> GetPrimary();
+
+    /**
+     * @brief Get the number of shadow queue discs
+     * @return the number of shadows
+     */
+    std::size_t GetNShadows() const;
+
+    /**
+     * @brief Get a shadow queue disc
+     * @param i the index of the shadow
+     * @return the shadow
+     */
+    Ptr<QueueDisc> GetShadow(std::size_t i) const;
+
+    /**
+     * @brief Get the statistics of a shadow, up to now
+     * @param i the index of the shadow
+     * @return the shadow statistics
+     */
+    const ShadowStats& GetShadowStats(std::size_t i);
+
+    /**
+     * @brief Get the time-averaged virtual queue length of a shadow
+     * @param i the index of the shadow
+     * @return the average length, in the unit of its MaxSize
+     */
+    double GetMeanShadowLength(std::size_t i);
+
+    /**
+     * @brief Print the statistics of the primary and, side by side with
+     * them, those of each shadow
+     * @param os output stream
+     */
+    void PrintAqmStats(std::ostream& os);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief A shadow queue disc and its virtual link
+     */
+    struct Shadow
+    {
+        Ptr<QueueDisc> qd;  //!< The shadow queue disc
+        EventId service;    //!< End of the virtual transmission in progress
+        Time lastChange;    //!< Last update of stats.lengthSeconds
+        ShadowStats stats;  //!< What the shadow did
+    };
+
+    bool DoEnqueue(Ptr<QueueDiscItem> item) override;
+    Ptr<QueueDiscItem> DoDequeue() override;
+    bool CheckConfig() override;
+    void InitializeParams() override;
+
+    /**
+     * @brief Offer an arrival to a shadow
+     * @param i the index of the shadow
+     * @param item the copy of the arrival for that shadow
+     */
+    void Offer(std::size_t i, Ptr<ShadowQueueDiscItem> item);
+
+    /**
+     * @brief Start the virtual transmission of the head of a shadow queue
+     *
+     * Called when a packet reaches an idle virtual link and at the end of
+     * every virtual transmission. If the shadow queue is empty, the link
+     * goes idle; the empty dequeue is what the shadow would have seen from
+     * a real device.
+     *
+     * @param i the index of the shadow
+     */
+    void Serve(std::size_t i);
+
+    /**
+     * @brief Record that a shadow is done with its copy of an arrival
+     * @param item the copy, sent or dropped
+     * @param dropped true if the shadow dropped it
+     */
+    void ShadowDone(Ptr<const ShadowQueueDiscItem> item, bool dropped);
+
+    /**
+     * @brief Record that the primary is done with an arrival
+     * @param arrival the decisions on the arrival
+     * @param dropped true if the primary dropped it
+     */
+    void PrimaryDone(Ptr<ShadowArrival> arrival, bool dropped);
+
+    /**
+     * @brief Compare the decisions of the primary and of a shadow on an
+     * arrival both are done with
+     * @param i the index of the shadow
+     * @param arrival the decisions on the arrival
+     */
+    void Pair(std::size_t i, const ShadowArrival& arrival);
+
+    /**
+     * @brief Trace sink of the Mark trace source of the shadows
+     * @param item the marked copy
+     * @param reason the reason of the mark
+     */
+    void ShadowMarked(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief Trace sink of the DropAfterDequeue trace source of the shadows
+     * @param item the dropped copy
+     * @param reason the reason of the drop
+     */
+    void ShadowDropped(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief Trace sink of the Mark trace source of the primary
+     * @param item the marked item
+     * @param reason the reason of the mark
+     */
+    void PrimaryMarked(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief Trace sink of the DropAfterDequeue trace source of the primary
+     * @param item the dropped item
+     * @param reason the reason of the drop
+     */
+    void PrimaryDropped(Ptr<const QueueDiscItem> item, const char* reason);
+
+    /**
+     * @brief Integrate the virtual queue length of a shadow up to now
+     * @param s the shadow
+     */
+    void UpdateLength(Shadow& s);
+
+    /**
+     * @brief Print the AQM statistics of a RED, DSRED, BLUE or DualQ queue disc
+     * @param os output stream
+     * @param qd the queue disc
+     */
+    static void PrintQueueDisc(std::ostream& os, Ptr<QueueDisc> qd);
+
+    // ** Variables supplied by user
+    std::string m_primaryType; //!< TypeId name of the primary queue disc
+    std::string m_shadowTypes; //!< Comma-separated TypeId names of the shadows
+    DataRate m_linkRate;       //!< Service rate of the virtual queues
+
+    // ** Variables maintained by the queue disc
+    Ptr<QueueDisc> m_primary;      //!< The primary queue disc, cached by GetPrimary
+    std::vector<Shadow> m_shadows; //!< The shadow queue discs
+    /// Decisions on the arrivals held by the primary, by item
+    std::unordered_map<const QueueDiscItem*, Ptr<ShadowArrival>> m_arrivals;
+    Time m_start; //!< Start of the length averages
+};
+
+} // namespace ns3
+
+#endif // SHADOW_AQM_QUEUE_DISC_H
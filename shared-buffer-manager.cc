@@ -0,0 +1,141 @@
+#include "shared-buffer-manager.h"
+
+#include "aqm-reasons.h"
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("SharedBufferManager");
+
+NS_OBJECT_ENSURE_REGISTERED(SharedBufferManager);
+
+const uint16_t SharedBufferManager::ADMISSION_DROP_ID = AqmReasons::Register(ADMISSION_DROP);
+
+TypeId
+SharedBufferManager::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::SharedBufferManager")
+            .SetParent<Object>()
+            .SetGroupName("TrafficControl")
+            .AddConstructor<SharedBufferManager>()
+            .AddAttribute("BufferSize",
+                          "Capacity of the buffer shared by the registered queue discs",
+                          QueueSizeValue(QueueSize("1000p")),
+                          MakeQueueSizeAccessor(&SharedBufferManager::m_bufferSize),
+                          MakeQueueSizeChecker())
+            .AddAttribute("Alpha",
+                          "Dynamic threshold factor: a port may hold up to Alpha times the "
+                          "free buffer",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&SharedBufferManager::m_alpha),
+                          MakeDoubleChecker<double>(0.0));
+    return tid;
+}
+
+SharedBufferManager::SharedBufferManager()
+    : m_peakTotal(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+SharedBufferManager::~SharedBufferManager()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+SharedBufferManager::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_ports.clear();
+    Object::DoDispose();
+}
+
+uint32_t
+SharedBufferManager::Register(Ptr<QueueDisc> queueDisc)
+{
+    NS_LOG_FUNCTION(this << queueDisc);
+    m_ports.push_back({queueDisc, 0, 0});
+    return m_ports.size() - 1;
+}
+
+uint32_t
+SharedBufferManager::GetNPorts() const
+{
+    return m_ports.size();
+}
+
+uint32_t
+SharedBufferManager::GetOccupancy(uint32_t port) const
+{
+    NS_ABORT_MSG_IF(port >= m_ports.size(), "Unknown port " << port);
+    const Ptr<QueueDisc>& qd = m_ports[port].queueDisc;
+    return m_bufferSize.GetUnit() == QueueSizeUnit::BYTES ? qd->GetNBytes() : qd->GetNPackets();
+}
+
+uint32_t
+SharedBufferManager::GetTotalOccupancy() const
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < m_ports.size(); ++i)
+    {
+        total += GetOccupancy(i);
+    }
+    return total;
+}
+
+double
+SharedBufferManager::GetThreshold() const
+{
+    uint32_t total = GetTotalOccupancy();
+    uint32_t capacity = m_bufferSize.GetValue();
+    return total < capacity ? m_alpha * (capacity - total) : 0.0;
+}
+
+bool
+SharedBufferManager::Admit(uint32_t port, Ptr<const QueueDiscItem> item)
+{
+    NS_LOG_FUNCTION(this << port << item);
+
+    uint32_t size = m_bufferSize.GetUnit() == QueueSizeUnit::BYTES ? item->GetSize() : 1;
+    uint32_t total = GetTotalOccupancy();
+    uint32_t own = GetOccupancy(port);
+    uint32_t capacity = m_bufferSize.GetValue();
+    double threshold = total < capacity ? m_alpha * (capacity - total) : 0.0;
+
+    Port& p = m_ports[port];
+    if (total + size > capacity || own + size > threshold)
+    {
+        NS_LOG_LOGIC("Port " << port << " holds " << own << ", threshold " << threshold
+                             << ", buffer " << total << "/" << capacity << " -- refusing");
+        p.drops++;
+        return false;
+    }
+    p.peak = std::max(p.peak, own + size);
+    m_peakTotal = std::max(m_peakTotal, total + size);
+    return true;
+}
+
+void
+SharedBufferManager::Print(std::ostream& os) const
+{
+    uint64_t drops = 0;
+    os << "Shared buffer of " << m_bufferSize << ", alpha " << m_alpha << std::endl;
+    for (uint32_t i = 0; i < m_ports.size(); ++i)
+    {
+        os << "  port " << i << ": " << GetOccupancy(i) << " now, " << m_ports[i].peak
+           << " peak, " << m_ports[i].drops << " admission drops" << std::endl;
+        drops += m_ports[i].drops;
+    }
+    os << "  total: " << GetTotalOccupancy() << " now, " << m_peakTotal << " peak, " << drops
+       << " admission drops" << std::endl;
+}
+
+} // namespace ns3
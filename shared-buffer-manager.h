@@ -0,0 +1,111 @@
+#ifndef SHARED_BUFFER_MANAGER_H
+#define SHARED_BUFFER_MANAGER_H
+
+#include "queue-disc.h"
+
+#include "ns3/object.h"
+#include "ns3/queue-size.h"
+
+#include <ostream>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Packet buffer shared by the queue discs of the ports of a switch
+ *
+ * Queue discs register with the manager of their node (see
+ * RedQueueDisc::SetSharedBuffer and BlueQueueDisc::SetSharedBuffer) and ask
+ * it to admit every arriving packet before running their AQM. A packet is
+ * admitted if the buffer has room for it and the occupancy of its port
+ * stays within the dynamic threshold Alpha times the free buffer
+ * (Choudhury and Hahne), so a single congested port cannot take the whole
+ * buffer while the others are idle. Occupancy is counted in the unit of
+ * BufferSize and read from the queue discs themselves, so it is always
+ * consistent with their own drops and dequeues. The private MaxSize of the
+ * queue discs still applies and is best set to BufferSize.
+ */
+class SharedBufferManager : public Object
+{
+  public:
+    /**
+     * @brief Get the type ID.
+     * @return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    SharedBufferManager();
+    ~SharedBufferManager() override;
+
+    /**
+     * @brief Register the queue disc of a port
+     * @param queueDisc the queue disc
+     * @return the port index, to be passed to Admit
+     */
+    uint32_t Register(Ptr<QueueDisc> queueDisc);
+
+    /**
+     * @brief Decide whether a packet arriving at a port fits in the buffer
+     * @param port the port index
+     * @param item the arriving packet
+     * @return true if the packet is admitted
+     */
+    bool Admit(uint32_t port, Ptr<const QueueDiscItem> item);
+
+    /// @return the number of registered ports
+    uint32_t GetNPorts() const;
+
+    /**
+     * @brief Get the current occupancy of a port
+     * @param port the port index
+     * @return packets or bytes, in the unit of BufferSize
+     */
+    uint32_t GetOccupancy(uint32_t port) const;
+
+    /// @return the current occupancy of the whole buffer, in the unit of BufferSize
+    uint32_t GetTotalOccupancy() const;
+
+    /**
+     * @brief Get the current admission threshold of every port
+     * @return Alpha times the free buffer
+     */
+    double GetThreshold() const;
+
+    /**
+     * @brief Print, for every port and for the whole buffer, the current and
+     * peak occupancy and the admission drops
+     * @param os output stream
+     */
+    void Print(std::ostream& os) const;
+
+    /// Reason of the drops made on behalf of the manager
+    static constexpr const char* ADMISSION_DROP = "Shared buffer admission drop";
+    /// ID of ADMISSION_DROP (see AqmReasons)
+    static const uint16_t ADMISSION_DROP_ID;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * @brief A registered port
+     */
+    struct Port
+    {
+        Ptr<QueueDisc> queueDisc; //!< Queue disc of the port
+        uint32_t peak;            //!< Highest occupancy after an admission
+        uint64_t drops;           //!< Packets refused admission
+    };
+
+    QueueSize m_bufferSize;   //!< Capacity of the shared buffer
+    double m_alpha;           //!< Dynamic threshold factor
+    std::vector<Port> m_ports; //!< Registered ports
+    uint32_t m_peakTotal;     //!< Highest total occupancy after an admission
+};
+
+} // namespace ns3
+
+#endif // SHARED_BUFFER_MANAGER_H
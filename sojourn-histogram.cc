@@ -0,0 +1,95 @@
+#include "sojourn-histogram.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("SojournHistogram");
+
+SojournHistogram::SojournHistogram()
+{
+    Reset();
+}
+
+void
+SojournHistogram::Reset()
+{
+    m_counts.fill(0);
+    m_total = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+void
+SojournHistogram::Merge(const SojournHistogram& other)
+{
+    for (uint32_t bucket = 0; bucket < N_BUCKETS; ++bucket)
+    {
+        m_counts[bucket] += other.m_counts[bucket];
+    }
+    m_total += other.m_total;
+    m_sum += other.m_sum;
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t
+SojournHistogram::GetBucketUpperBound(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    uint32_t shift = bucket / SUB_BUCKETS - 1;
+    uint64_t mantissa = bucket % SUB_BUCKETS;
+    return ((SUB_BUCKETS + mantissa + 1) << shift) - 1;
+}
+
+Time
+SojournHistogram::GetPercentile(double percentile) const
+{
+    NS_ASSERT(percentile >= 0 && percentile <= 100);
+    if (m_total == 0)
+    {
+        return Time(0);
+    }
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * m_total));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < N_BUCKETS; ++bucket)
+    {
+        seen += m_counts[bucket];
+        if (seen >= rank)
+        {
+            return NanoSeconds(std::min(GetBucketUpperBound(bucket), m_max));
+        }
+    }
+    return NanoSeconds(m_max);
+}
+
+Time
+SojournHistogram::GetMean() const
+{
+    return m_total > 0 ? NanoSeconds(m_sum / m_total) : Time(0);
+}
+
+void
+SojournHistogram::Print(std::ostream& os) const
+{
+    os << "Sojourn time (" << m_total << " packets): mean " << GetMean().As(Time::MS) << " p50 "
+       << GetPercentile(50).As(Time::MS) << " p90 " << GetPercentile(90).As(Time::MS) << " p99 "
+       << GetPercentile(99).As(Time::MS) << " p99.9 " << GetPercentile(99.9).As(Time::MS)
+       << " max " << GetMax().As(Time::MS);
+}
+
+std::ostream&
+operator<<(std::ostream& os, const SojournHistogram& histogram)
+{
+    histogram.Print(os);
+    return os;
+}
+
+} // namespace ns3
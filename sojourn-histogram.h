@@ -0,0 +1,159 @@
+#ifndef SOJOURN_HISTOGRAM_H
+#define SOJOURN_HISTOGRAM_H
+
+#include "ns3/nstime.h"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @ingroup traffic-control
+ *
+ * @brief Log-linear (HDR-style) histogram of queue sojourn times
+ *
+ * Sojourn times are recorded in nanoseconds. Values below 2^SUB_BUCKET_BITS
+ * get one bucket each; above that, every power of two is split into
+ * 2^SUB_BUCKET_BITS linear sub-buckets, so any reported value is within
+ * 1/32 (about 3%) of the recorded one. Values beyond 2^MAX_EXPONENT ns
+ * (about 37 minutes) land in the last bucket. Memory is fixed and
+ * recording costs one count-leading-zeros, a shift and an increment.
+ */
+class SojournHistogram
+{
+  public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 5; //!< log2 of the sub-buckets per power of two
+    static constexpr uint32_t MAX_EXPONENT = 41;   //!< Largest power of two with its own buckets
+    static constexpr uint32_t SUB_BUCKETS = 1U << SUB_BUCKET_BITS; //!< Sub-buckets per power of two
+    static constexpr uint32_t N_BUCKETS =
+        SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 2); //!< Total number of buckets
+
+    SojournHistogram();
+
+    /**
+     * @brief Record one sojourn time
+     * @param sojourn time the packet spent in the queue
+     */
+    void Record(Time sojourn)
+    {
+        int64_t ns = sojourn.GetNanoSeconds();
+        uint64_t value = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+        m_counts[GetBucket(value)]++;
+        m_total++;
+        m_sum += value;
+        if (value > m_max)
+        {
+            m_max = value;
+        }
+    }
+
+    /**
+     * @brief Forget all the recorded samples
+     */
+    void Reset();
+
+    /**
+     * @brief Add the samples of another histogram
+     * @param other the histogram to add
+     */
+    void Merge(const SojournHistogram& other);
+
+    /// @return the number of recorded samples
+    uint64_t GetCount() const
+    {
+        return m_total;
+    }
+
+    /**
+     * @brief Get a percentile of the recorded sojourn times
+     *
+     * Returns the highest value equivalent to the bucket holding the
+     * percentile, capped by the largest recorded value.
+     *
+     * @param percentile the percentile, between 0 and 100
+     * @return the sojourn time, zero if nothing was recorded
+     */
+    Time GetPercentile(double percentile) const;
+
+    /// @return the mean sojourn time, zero if nothing was recorded
+    Time GetMean() const;
+
+    /// @return the largest recorded sojourn time
+    Time GetMax() const
+    {
+        return NanoSeconds(m_max);
+    }
+
+    /**
+     * @brief Print the sample count, p50, p90, p99, p99.9 and the maximum
+     * @param os output stream
+     */
+    void Print(std::ostream& os) const;
+
+    /**
+     * @brief Get the bucket of a value
+     * @param value the value in nanoseconds
+     * @return the bucket index
+     */
+    static uint32_t GetBucket(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return static_cast<uint32_t>(value);
+        }
+        uint32_t exponent = 63 - CountLeadingZeros(value);
+        if (exponent > MAX_EXPONENT)
+        {
+            return N_BUCKETS - 1;
+        }
+        uint32_t shift = exponent - SUB_BUCKET_BITS;
+        auto mantissa = static_cast<uint32_t>(value >> shift) - SUB_BUCKETS;
+        return SUB_BUCKETS * (shift + 1) + mantissa;
+    }
+
+    /**
+     * @brief Get the highest value that falls into a bucket
+     * @param bucket the bucket index
+     * @return the value in nanoseconds
+     */
+    static uint64_t GetBucketUpperBound(uint32_t bucket);
+
+  private:
+    /**
+     * @param value a non-zero value
+     * @return the number of leading zero bits of value
+     */
+    static uint32_t CountLeadingZeros(uint64_t value)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        uint32_t n = 0;
+        for (uint64_t bit = 1ULL << 63; (value & bit) == 0; bit >>= 1)
+        {
+            n++;
+        }
+        return n;
+#endif
+    }
+
+    std::array<uint64_t, N_BUCKETS> m_counts; //!< Samples per bucket
+    uint64_t m_total;                         //!< Number of samples
+    uint64_t m_sum;                           //!< Sum of the samples (ns)
+    uint64_t m_max;                           //!< Largest sample (ns)
+};
+
+/**
+ * @brief Stream insertion operator.
+ * @param os the reference to the output stream
+ * @param histogram the sojourn histogram
+ * @return the reference to the output stream
+ */
+std::ostream& operator<<(std::ostream& os, const SojournHistogram& histogram);
+
+} // namespace ns3
+
+#endif // SOJOURN_HISTOGRAM_H